@@ -30,7 +30,7 @@ Bruce Culbertson
  * -------------------------------------------------------------------
  * 32000	Command (? for help): download <address>
  * MS-DOS	[exit terminal emulator]
- * MS-DOS	C> <this program> <file name to download>
+ * MS-DOS	C> <this program> [-b] <file name to download>
  * MS-DOS	[re-enter terminal emulator]
  * 32000	[hit return to get status of download]
  * 32000	Command (? for help): ...
@@ -73,10 +73,22 @@ Bruce Culbertson
  *   polynomial (x^16 + x^12 + x^5 + 1).  Compute on data only (not
  *   length or start) and exclude quotes.  (This is the same CRC
  *   as computed by Minix's CRC command.)
+ *
+ * With -b, the block protocol described in the monitor's download.c is
+ * used instead.  Data goes in BLKSZ blocks, each with its own CRC and
+ * run-length encoded when that makes it shorter.  Up to WINDOW blocks
+ * are sent ahead of the acknowledgements, and a block is resent when
+ * the monitor rejects it or its acknowledgement does not arrive within
+ * TIMEOUT.  The serial port must be full duplex for this.
  */
 
 #include <stdio.h>
 #include <fcntl.h>
+#include <time.h>
+#ifndef MSDOS
+#  include <sys/types.h>
+#  include <sys/time.h>
+#endif
 
 #ifdef MSDOS
 #  define OPEN_FLAGS    (O_RDONLY | O_BINARY)
@@ -84,24 +96,56 @@ Bruce Culbertson
 #  define OPEN_FLAGS    O_RDONLY
 #endif
 
-#define CCITT_GEN	0x11021		/* x^16 + x^12 + x^5 + 1 */
+/* CCITT CRC a byte at a time, as the monitor's crctab.h; crc_init()
+ * builds the table.
+ */
+#define UPDATE_CRC(crc, ch) \
+  ((((crc) & 0xff) << 8 | ((ch) & 0xff)) ^ crctab [((crc) >> 8) & 0xff])
+
+#ifdef MSDOS
+#  ifndef CLOCKS_PER_SEC
+#    define CLOCKS_PER_SEC CLK_TCK
+#  endif
+#  define HZ		CLOCKS_PER_SEC	/* units of now() */
+#else
+#  define HZ		1000
+#endif
+
 #define BUFSZ		0x1000
 #define ESC		0x1b
 #define CTL_C		0x03
 #define DEFAULT_PORT    1
 
+#define BSTART		';'		/* block protocol start mark */
+#define SOH		0x01
+#define EOT		0x04
+#define BLKSZ		512		/* as in the monitor */
+#define WINDOW		8		/* no more than the monitor's */
+#define F_RLE		0x01
+#define TIMEOUT		(2 * HZ)
+#define MAX_TRIES	10
+
 char buf[BUFSZ];
+unsigned char rle_buf[BLKSZ + BLKSZ / 128 + 2];
 int port_num = DEFAULT_PORT;
 int port;
-long write_data(), write_header();
+int bad_blocks;
+unsigned short crctab [256];
+long write_data(), write_header(), write_blocks(), lseek(), now();
 
 main (argc, argv)
 int argc;
 char **argv;
 {
-  int fd;
+  int fd, blocks = 0;
   long crc, len;
 
+  crc_init ();
+  if (argc > 1 && 0 == strcmp (argv[1], "-b")) {
+    blocks = 1;
+    ++argv;
+    --argc;
+  }
   if (argc == 3) {
     if (1 != sscanf (argv[2], "%d", &port_num)) {
       fprintf (stderr, "Bad serial port, use 1 or 2\n");
@@ -110,7 +154,7 @@ char **argv;
     --argc;
   }
   if (argc != 2) {
-    fprintf (stderr, "usage: %s <file> [<serial port>]\n", argv[0]);
+    fprintf (stderr, "usage: %s [-b] <file> [<serial port>]\n", argv[0]);
     exit (-1);
   }
   if (port_num == 1) port = 0x3f8;
@@ -124,6 +168,13 @@ char **argv;
     exit (-1);
   }
   init_port();
+  if (blocks) {
+    len = lseek (fd, 0L, 2);
+    crc = write_blocks (fd, len);
+    printf ("Length=%ld CRC=%ld, %d blocks resent\n", len, crc, bad_blocks);
+    restore_port();
+    exit (0);
+  }
   len = write_header (fd);
   crc = write_data (fd);
   write_crc (crc);
@@ -140,7 +191,7 @@ long
 write_header (fd)
 int fd;
 {
-  long len, lseek();
+  long len;
 
   if (0 == (len = lseek (fd, 0L, 2))) {
     fprintf (stderr, "file length is zero\n");
@@ -161,7 +212,7 @@ long
 write_data (fd)
 int fd;
 {
-  long len, crc = 0, update_crc();
+  long len, crc = 0;
   char *p;
 
   for (;;) {
@@ -173,12 +224,26 @@ int fd;
     if (len == 0) break;
     for (p = buf; p < buf + len; ++p) {
       write_ch (*p);
-      crc = update_crc (crc, *p);
+      crc = UPDATE_CRC (crc, *p);
     }
   }
   return crc;
 }
 
+/* Fill crctab: crctab [t] is t * x^16 mod x^16 + x^12 + x^5 + 1.
+ */
+crc_init ()
+{
+  unsigned c;
+  int t, i;
+
+  for (t = 0; t < 256; ++t) {
+    c = t << 8;
+    for (i = 0; i < 8; ++i) c = (c & 0x8000)? c << 1 ^ 0x1021: c << 1;
+    crctab [t] = c;
+  }
+}
+
 /* Write two CRC bytes, LSB first.
  */
 write_crc (crc)
@@ -188,32 +253,197 @@ long crc;
   write_ch ((int)((crc >> 8) & 0xff));
 }
 
-/* Given old CRC and new character, return new CRC.  Uses standard
- * CCITT CRC generator polynomial.
+/* Output a character.  If it is a CLT_C or ESC, then quote (preceed)
+ * it with a ESC.
+ */
+write_ch (c)
+int c;
+{
+  if (c == ESC || c == CTL_C)
+    putch (ESC);
+  putch (c);
+}
+
+/* Send the file with the block protocol.  Return the CRC of the data.
+ * Only the acknowledgement state of the blocks in the window is kept,
+ * indexed by block number modulo WINDOW.
  */
 long
-update_crc (crc, ch)
-long crc;
-int ch;
+write_blocks (fd, len)
+int fd;
+long len;
 {
-  int i;
+  long nblk, base, next, b, crc = 0;
+  long sent[WINDOW];
+  char acked[WINDOW];
+  int c, s, tries, size;
+  unsigned char *p;
 
-  for (i = 0x80; i; i >>= 1) {
-    crc = (crc << 1) | (i & ch? 1: 0);
-    if (crc & 0x10000) crc ^= CCITT_GEN;
+  if (len == 0) {
+    fprintf (stderr, "file length is zero\n");
+    exit (-1);
+  }
+  for (tries = 0;; ++tries) {
+    if (tries == MAX_TRIES) give_up ("header");
+    write_block_header (len);
+    while ((c = read_ch (TIMEOUT)) >= 0 && c != 'H' && c != 'N');
+    if (c == 'H') break;
+  }
+  nblk = (len + BLKSZ - 1) / BLKSZ;
+  base = next = 0;
+  tries = 0;
+  while (base < nblk) {
+    while (next < nblk && next < base + WINDOW) {
+      size = read_block (fd, next);
+      for (p = (unsigned char *)buf; p < (unsigned char *)buf + size; ++p)
+	crc = UPDATE_CRC (crc, *p);
+      write_block (next, size);
+      sent[next % WINDOW] = now();
+      acked[next % WINDOW] = 0;
+      ++next;
+    }
+    c = read_ch (TIMEOUT / 4);
+    if (c == 'A' || c == 'N') {
+      if (0 > (s = read_ch (TIMEOUT))) continue;
+      b = base + ((s - base) & 0xff);
+      if (b >= next) continue;
+      if (c == 'A') {
+	acked[b % WINDOW] = 1;
+	while (base < next && acked[base % WINDOW]) ++base;
+	tries = 0;
+      } else if (!acked[b % WINDOW]) {
+	++bad_blocks;
+	write_block (b, read_block (fd, b));
+	sent[b % WINDOW] = now();
+      }
+    } else if (c < 0) {
+      for (b = base; b < next; ++b) {
+	if (acked[b % WINDOW] || now() - sent[b % WINDOW] < TIMEOUT)
+	  continue;
+	if (b == base && ++tries == MAX_TRIES) give_up ("block");
+	++bad_blocks;
+	write_block (b, read_block (fd, b));
+	sent[b % WINDOW] = now();
+      }
+    }
+  }
+  for (tries = 0;; ++tries) {
+    if (tries == MAX_TRIES) give_up ("end");
+    putch (EOT);
+    while ((c = read_ch (TIMEOUT)) >= 0 && c != 'E');
+    if (c == 'E') break;
   }
   return crc;
 }
 
-/* Output a character.  If it is a CLT_C or ESC, then quote (preceed)
- * it with a ESC.
+/* Block protocol header: start mark, four byte length LSB first, and
+ * the CRC of the length bytes.
  */
-write_ch (c)
-int c;
+write_block_header (len)
+long len;
 {
-  if (c == ESC || c == CTL_C)
-    putch (ESC);
-  putch (c);
+  long crc = 0;
+  int i, c;
+
+  putch (BSTART);
+  for (i = 0; i < 32; i += 8) {
+    c = (len >> i) & 0xff;
+    putch (c);
+    crc = UPDATE_CRC (crc, c);
+  }
+  putch ((int)(crc & 0xff));
+  putch ((int)((crc >> 8) & 0xff));
+}
+
+/* Read block b of the file into buf.  Return its size.
+ */
+int
+read_block (fd, b)
+int fd;
+long b;
+{
+  int size;
+
+  lseek (fd, b * BLKSZ, 0);
+  if (0 > (size = read (fd, buf, BLKSZ))) {
+    fprintf (stderr, "read failed\n");
+    exit (-1);
+  }
+  return size;
+}
+
+/* Send block b, which is in buf.  Compress it if that helps.
+ */
+write_block (b, size)
+long b;
+int size;
+{
+  unsigned char *p;
+  int flags = 0, len, seq = b & 0xff;
+  long crc;
+
+  p = (unsigned char *)buf;
+  len = size;
+  if (size > (len = rle (buf, size))) {
+    p = rle_buf;
+    flags = F_RLE;
+  } else len = size;
+  putch (SOH);
+  putch (seq);
+  putch (~seq & 0xff);
+  putch (flags);
+  putch (len & 0xff);
+  putch (len >> 8);
+  crc = UPDATE_CRC (0L, seq);
+  crc = UPDATE_CRC (crc, ~seq);
+  crc = UPDATE_CRC (crc, flags);
+  crc = UPDATE_CRC (crc, len);
+  crc = UPDATE_CRC (crc, len >> 8);
+  for (; len > 0; --len, ++p) {
+    putch (*p);
+    crc = UPDATE_CRC (crc, *p);
+  }
+  putch ((int)(crc & 0xff));
+  putch ((int)((crc >> 8) & 0xff));
+}
+
+/* Run-length encode size bytes from src into rle_buf.  A byte c < 128
+ * is followed by c+1 literals, c >= 128 by a byte repeated c-125 times.
+ * Return the encoded length, or size if the encoding is no shorter.
+ */
+int
+rle (src, size)
+char *src;
+int size;
+{
+  unsigned char *s = (unsigned char *)src, *d = rle_buf, *lit;
+  int i = 0, run;
+
+  while (i < size) {
+    for (run = 1; i + run < size && run < 130 && s[i + run] == s[i]; ++run);
+    if (run >= 3) {
+      *d++ = run + 125;
+      *d++ = s[i];
+      i += run;
+    } else {
+      lit = d++;
+      for (run = 0; i < size && run < 128; ++i, ++run) {
+	if (i + 2 < size && s[i] == s[i + 1] && s[i] == s[i + 2]) break;
+	*d++ = s[i];
+      }
+      *lit = run - 1;
+    }
+    if (d - rle_buf >= size) return size;
+  }
+  return d - rle_buf;
+}
+
+give_up (what)
+char *what;
+{
+  fprintf (stderr, "no answer from monitor, %s not acknowledged\n", what);
+  restore_port();
+  exit (-1);
 }
 
 #ifdef MSDOS
@@ -227,6 +457,7 @@ int c;
 #define COM_CTL_VAL 3                   /* 8 bits, 1 stop, no parity */
 #define COM_IER_VAL 0                   /* interrupts off */
 #define COM_TX_RDY  0x20
+#define COM_RX_RDY  0x01
 
 int old_control, old_ier;
 
@@ -244,6 +475,26 @@ int c;
   outp (port + COM_WR, c);
 }
 
+/* Read a character from the serial port.  Return -1 if none arrives
+ * within tmo ticks of now().
+ */
+int
+read_ch (tmo)
+long tmo;
+{
+  long start = now();
+
+  while (!(inp (port + COM_STAT) & COM_RX_RDY))
+    if (now() - start > tmo) return -1;
+  return inp (port + COM_RD) & 0xff;
+}
+
+long
+now()
+{
+  return clock();
+}
+
 /* Initialize serial port and save old values.  Assume baud rate
  * already set.
  */
@@ -266,5 +517,37 @@ restore_port()
 putch (c) {putchar (c);}
 init_port(){}
 restore_port(){}
+
+/* The monitor's replies come in on stdin.
+ */
+int
+read_ch (tmo)
+long tmo;
+{
+  fd_set fds;
+  struct timeval tv;
+  unsigned char c;
+
+  fflush (stdout);
+  FD_ZERO (&fds);
+  FD_SET (0, &fds);
+  tv.tv_sec = tmo / HZ;
+  tv.tv_usec = tmo % HZ * (1000000L / HZ);
+  if (1 != select (1, &fds, (fd_set *)0, (fd_set *)0, &tv) ||
+    1 != read (0, &c, 1))
+    return -1;
+  return c;
+}
+
+/* Milliseconds; clock() would not count time spent waiting.
+ */
+long
+now()
+{
+  struct timeval tv;
+
+  gettimeofday (&tv, (struct timezone *)0);
+  return tv.tv_sec * 1000L + tv.tv_usec / 1000;
+}
 #endif
 
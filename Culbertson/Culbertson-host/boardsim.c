@@ -0,0 +1,1599 @@
+/* Logic level simulation of the NS32016 board from its netlist.
+ *
+ * Usage: boardsim [-v] [-p <partlist>] [-d <pal dir>] [-n <count>]
+ *		   [-g <idle clocks>] [-t <net>]... [-s rand|seq|map] [<netlist>]
+ *
+ * The board is built from the netlist and partlist: every part of a
+ * type with a model below becomes one or more elements, and the PALs
+ * run their own equation files, found by part name in the netlist's
+ * directory or -d.  The CPU, MMU and TCU are replaced by a bus model
+ * which runs bus cycles at their pins, so the rest of the board sees
+ * T states, wait states, strobes and the clocks it would see.  Every
+ * net carries 64 lanes, one bit each, and each lane runs its own
+ * stream of bus cycles: the 64 take their own wait states and see
+ * their own chip selects, but share the clocks.
+ *
+ * A change of net marks the elements which read it; a settle evaluates
+ * the marked elements in level order, so that in a tree of gates each
+ * is evaluated once, and repeats only for the elements in loops (the
+ * data bus transceivers, say).  Clocked elements are clocked on the
+ * rising edges of their clock nets after a settle, all at once.
+ *
+ * What is modelled, and what is not:
+ *
+ *	Each T state is two halves of CTTL, high first, and FCLK rises
+ *	at the end of each half, as in dramsim.  In T1 the bus model
+ *	drives the address on AD and asserts ADS and PAV in the first
+ *	half; TSO is asserted T2 to T4; DDIN for the whole of a read;
+ *	RD or WR T2 to T3 and any Tw; DBE from the second half of T2 to
+ *	the first half of T4; write data on AD from T2.  The MMU passes
+ *	addresses through untranslated.
+ *
+ *	The TCU samples WAIT1-8 and PER at the end of T2, and CWAIT at
+ *	the end of T3 and each Tw.  PER asks for PERWAITS wait states.
+ *
+ *	Gates, buffers, transceivers, latches, muxes and decoders are
+ *	modelled at their pins, with no delay.  A net nothing drives
+ *	floats high, as TTL inputs do; a net driven by two outputs at
+ *	once is a clash, whatever they drive.  Series terminations pass
+ *	the signal on from whichever side is driven; delay lines are
+ *	wires.
+ *
+ *	Memories drive their data pins, with a pattern of their own,
+ *	when selected and read; their contents are not kept.  The DP8419
+ *	is modelled as far as its pins: refresh requests on RFCK as in
+ *	dramsim, RASn and CAS for the bank chosen by B1 B0, and the row
+ *	then the column address on Q.  CAS follows RAS at once.
+ *
+ *	Peripherals (ICU, DMA, FPU, UARTs, SCSI, floppy) are not
+ *	modelled: their chip selects are checked, but they answer no
+ *	reads.
+ *
+ * For each chip select the result is how many cycles reached it, the
+ * wait states they took, and how many reads no part answered.  Cycles
+ * with two chip selects at once, and nets driven by two parts at once,
+ * are decode bugs.  -s map reads each 256 bytes of the address space
+ * in two passes and prints the memory map the board decodes, with the
+ * fewer of the two wait states so that a refresh does not split a region.
+ *
+ * Speed: each run ends with its bus cycles a second.  Built with
+ * cc -O2 on an x86-64 host and run for 1000000 cycles, -s seq does
+ * about 1.8 million a second but -s rand only about 0.8 million.
+ * Random lanes take different paths through the decode, so a random
+ * cycle takes nearly four times the element evaluations.  Random
+ * cycles therefore fall short of millions a second; use -s seq for
+ * long runs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "netlist.h"
+#include "pal.h"
+
+#define NETLIST		"../Culbertson-32016/netlist"
+#define LANES		64
+#define ALL		(~(pal_word)0)
+#define MAXPASS		16		/* sweeps of a settle: oscillating */
+#define MAXWAIT		64		/* wait states before giving up */
+#define PERWAITS	5		/* the TCU's peripheral cycle */
+#define MAXCS		16
+#define MAXTRACE	16
+#define PAGES		65536		/* of 256 bytes, for -s map */
+
+/* Elements.  Inputs marked in inv are taken inverted, so that each
+ * model sees its inputs asserted high.
+ */
+#define K_AND		0		/* gates: all inputs, maybe negated */
+#define K_OR		1
+#define K_TRI		2		/* in[0], enabled by the rest */
+#define K_LATCH		3		/* d, le, oe */
+#define K_MUX		4		/* sel, strobe, a, b */
+#define K_DEC		5		/* a, b, c, three enables */
+#define K_MEM		6		/* enables; outputs are data */
+#define K_PAL		7		/* in and out by pin */
+#define K_8419		8
+#define K_BUS		9		/* CPU, MMU and TCU */
+#define K_XCV		10		/* in the models table only */
+
+#define F_NEG		1		/* output inverted */
+#define F_OC		2		/* open collector */
+
+struct elem {
+  int kind, flags;
+  int part;				/* in the netlist */
+  int nin, nout;
+  int *in;				/* nets, or -1 */
+  unsigned long inv;
+  pal_word *ix;				/* ALL where inv, else 0 */
+  int *out;				/* nets, or -1 */
+  pal_word *q, *en;			/* output values, and where driven */
+  pal_word *st, *nx;			/* state, and next state on a clock */
+  struct pal *pal;
+  unsigned long fb;			/* PAL outputs its equations read */
+  int clk;				/* net clocked on, or -1 */
+  pal_word lastclk, rise;
+};
+
+/* Models of the parts, by type: 74 parts by number without the
+ * family.  Pins are grouped by commas, / before an active low input;
+ * what a group means depends on the kind:
+ *
+ *	K_AND, K_OR	inputs then output
+ *	K_TRI		enables, data in, data out
+ *	K_XCV		dir, enable, a, b
+ *	K_LATCH		enable, le, d, q
+ *	K_MUX		select, strobe, a, b, y
+ *	K_DEC		a, b, c, three enables, y0 to y7
+ *	K_MEM		one group of enables, then one of data pins
+ */
+static struct model {
+  char *type;
+  int kind, flags;
+  char *pins;
+} models[] = {
+  {"00", K_AND, F_NEG, "1 2 3, 4 5 6, 10 9 8, 13 12 11"},
+  {"02", K_OR, F_NEG, "2 3 1, 5 6 4, 8 9 10, 11 12 13"},
+  {"04", K_AND, F_NEG, "1 2, 3 4, 5 6, 9 8, 11 10, 13 12"},
+  {"06", K_AND, F_NEG | F_OC, "1 2, 3 4, 5 6, 9 8, 11 10, 13 12"},
+  {"08", K_AND, 0, "1 2 3, 4 5 6, 10 9 8, 13 12 11"},
+  {"14", K_AND, F_NEG, "1 2, 3 4, 5 6, 9 8, 11 10, 13 12"},
+  {"32", K_OR, 0, "1 2 3, 4 5 6, 10 9 8, 13 12 11"},
+  {"38", K_AND, F_NEG | F_OC, "1 2 3, 4 5 6, 10 9 8, 13 12 11"},
+  {"125", K_TRI, 0, "/1 2 3, /4 5 6, /10 9 8, /13 12 11"},
+  {"126", K_TRI, 0, "1 2 3, 4 5 6, 10 9 8, 13 12 11"},
+  {"133", K_AND, F_NEG, "1 2 3 4 5 6 7 10 11 12 13 14 15 9"},
+  {"138", K_DEC, 0, "1 2 3 6 /4 /5 15 14 13 12 11 10 9 7"},
+  {"157", K_MUX, 0, "1 /15 2 3 4, 1 /15 5 6 7, 1 /15 11 10 9, 1 /15 14 13 12"},
+  {"244", K_TRI, 0, "/1 2 18, /1 4 16, /1 6 14, /1 8 12, \
+/19 11 9, /19 13 7, /19 15 5, /19 17 3"},
+  {"245", K_XCV, 0, "1 /19 2 18, 1 /19 3 17, 1 /19 4 16, 1 /19 5 15, \
+1 /19 6 14, 1 /19 7 13, 1 /19 8 12, 1 /19 9 11"},
+  {"373", K_LATCH, 0, "/1 11 3 2, /1 11 4 5, /1 11 7 6, /1 11 8 9, \
+/1 11 13 12, /1 11 14 15, /1 11 17 16, /1 11 18 19"},
+  {"27256", K_MEM, 0, "/20 /22, 11 12 13 15 16 17 18 19"},
+  {"43256", K_MEM, 0, "/20 /22 27, 11 12 13 15 16 17 18 19"},
+  {"tc51100p-10", K_MEM, 0, "/3 /16 2, 17"},
+  {"ddu-7-20", K_AND, 0, "1 2, 1 3, 1 4, 1 5, 1 6, 1 8, 1 9, 1 10, 1 11, \
+1 12, 1 13"},
+  {NULL}
+};
+
+/* Parts with nothing to simulate.
+ */
+static char *passive[] = {"capacitor", "resistor", "resister", "resisters",
+  "diode", "crystal", "switch", "dip_header", "connector", "oscillator",
+  NULL};
+
+/* The bus model's signals: outputs, then the TCU inputs it samples.
+ * S_AD(0) to S_AD(23) are AD0-15 and A16-23.
+ */
+#define S_AD(i)		(i)
+#define S_ADS		24
+#define S_PAV		25
+#define S_DDIN		26
+#define S_HBE		27
+#define S_HLDA		28
+#define S_DBE		29
+#define S_RD		30
+#define S_WR		31
+#define S_RSTO		32
+#define S_RDY		33
+#define S_FCLK		34
+#define S_CTTL		35
+#define S_TSO		36
+#define NSIG		37
+
+#define I_WAIT8		0
+#define I_WAIT4		1
+#define I_WAIT2		2
+#define I_WAIT1		3
+#define I_CWAIT		4
+#define I_PER		5
+#define NBUSIN		6
+
+static struct {
+  char *type;
+  int pin, sig, input;
+} buspins[] = {
+  {"ns32016", 32, S_HBE}, {"ns32016", 37, S_ADS}, {"ns32016", 38, S_DDIN},
+  {"ns32016", 47, S_AD(23)},
+  {"ns32082", 44, S_PAV}, {"ns32082", 32, S_HLDA},
+  {"ns32201", 1, S_DBE}, {"ns32201", 3, S_RD}, {"ns32201", 4, S_WR},
+  {"ns32201", 8, S_RSTO}, {"ns32201", 9, S_RDY}, {"ns32201", 15, S_FCLK},
+  {"ns32201", 16, S_CTTL}, {"ns32201", 17, S_TSO},
+  {"ns32201", 18, I_WAIT8, 1}, {"ns32201", 19, I_WAIT4, 1},
+  {"ns32201", 20, I_WAIT2, 1}, {"ns32201", 21, I_WAIT1, 1},
+  {"ns32201", 22, I_CWAIT, 1}, {"ns32201", 23, I_PER, 1},
+  {NULL}
+};
+
+#define TI		0
+#define T1		1
+#define T2		2
+#define T3		3
+#define TW		4
+#define T4		5
+static char *tname[] = {"Ti", "T1", "T2", "T3", "Tw", "T4"};
+
+static struct netlist *nl;
+static char *paldir;
+
+static struct elem *elem;
+static int nelem, maxelem, bus = -1;
+static int *order, *rank, nsweep;	/* evaluated elements, level order */
+static pal_word *dirty;			/* by rank, to be evaluated */
+static int ndirty, next;		/* words of dirty, lowest nonzero */
+static int *clocked, nclocked;
+static int nlevels, nloop;
+static char *kind_of;			/* of each part: 'l' logic, 'm' memory */
+
+/* Nets: the level of each lane, where driven, where driven twice.
+ */
+static pal_word *val, *drv, *clash;
+static char *fixed;
+static int *dstart, *dslot;		/* drivers of each net */
+static pal_word *outq, *outen;		/* every q and en, by slot */
+static int *rstart, *relem;		/* readers */
+static pal_word *rmask;			/* readers by rank, ndirty words */
+static long evals, oscillations;
+
+/* Workload
+ */
+static char *synth = "rand", *synths[] = {"rand", "seq", "map", NULL};
+static int mode;			/* index in synths */
+#define W_RAND		0
+#define W_SEQ		1
+#define W_MAP		2
+static long count = 1000000, gap, started;
+static unsigned long seed = 1;
+static long nextpage;
+
+/* Bus state, lane by lane: the mask of lanes in each T state, and the
+ * access of each.
+ */
+static pal_word tsm[6], live, rdm, hbem, counting, stay, leave;
+static pal_word adrw[24], datw[16];
+static unsigned long adr[LANES];
+static int ws[LANES], wc[LANES];
+static long idle[LANES];
+
+/* Results
+ */
+static int csnet[MAXCS], ncs, answered[MAXCS];
+static pal_word csw[MAXCS], memw;	/* selects, lanes a memory reads */
+static struct {
+  long cycles, reads, writes, waits, nodata;
+  int maxwait;
+} region[MAXCS + 1];
+static long cycles, states, conflicts, hung;
+static unsigned long conflict_adr;
+static int conflict_a, conflict_b;
+static long *nclash;
+static unsigned char *pagecs, *pagew, *pagenod;
+static int trace[MAXTRACE], ntrace;
+static long verbose;
+
+static void
+usage()
+{
+  fprintf(stderr, "usage: boardsim [-v] [-p partlist] [-d paldir] [-n count]\n\
+	[-g idle] [-t net]... [-s rand|seq|map] [netlist]\n\
+-s rand runs about 0.8 million bus cycles a second, seq about 1.8\n");
+  exit(2);
+}
+
+static void *
+alloc(n)
+long n;
+{
+  void *p;
+
+  if ((p = calloc(n > 0? n: 1, 1)) == NULL) {
+    fprintf(stderr, "boardsim: out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+static int
+popcount(w)
+pal_word w;
+{
+  int n;
+
+  for (n = 0; w != 0; w &= w - 1) ++n;
+  return n;
+}
+
+/* Lowest lane set in w, which is not 0: the lowest bit alone, times a
+ * de Bruijn sequence, has a different top six bits for each lane.
+ */
+static char debruijn[64];
+#define DEBRUIJN	0x03f79d71b4cb0a89ULL
+
+static int
+lane(w)
+pal_word w;
+{
+  return debruijn[((w & -w) * DEBRUIJN) >> 58];
+}
+
+/* Net on pin of part, or -1.
+ */
+static int
+pnet(part, pin)
+int part, pin;
+{
+  int k = nl_pin(nl, part, pin);
+
+  return (k < 0)? -1: nl->node[k].net;
+}
+
+static struct elem *
+new_elem(kind, flags, part, nin, nout)
+int kind, flags, part, nin, nout;
+{
+  struct elem *e;
+
+  if (nelem == maxelem) {
+    maxelem = maxelem? maxelem * 2: 256;
+    if ((elem = (struct elem *)realloc(elem, maxelem * sizeof *elem)) == NULL)
+    {
+      fprintf(stderr, "boardsim: out of memory\n");
+      exit(1);
+    }
+  }
+  e = &elem[nelem];
+  memset(e, 0, sizeof *e);
+  e->kind = kind;
+  e->flags = flags;
+  e->part = part;
+  e->nin = nin;
+  e->nout = nout;
+  e->in = (int *)alloc((long)(nin + 1) * sizeof(int));
+  e->out = (int *)alloc((long)(nout + 1) * sizeof(int));
+  e->q = (pal_word *)alloc((long)(nout + 1) * sizeof(pal_word));
+  e->en = (pal_word *)alloc((long)(nout + 1) * sizeof(pal_word));
+  e->clk = -1;
+  ++nelem;
+  return e;
+}
+
+/* Drop the element just made if none of its outputs is connected.
+ */
+static void
+keep()
+{
+  struct elem *e = &elem[nelem - 1];
+  int o;
+
+  for (o = 0; o < e->nout; ++o)
+    if (e->out[o] >= 0) return;
+  free(e->in);
+  free(e->out);
+  free(e->q);
+  free(e->en);
+  --nelem;
+}
+
+/* Evaluation
+ */
+#define in(e,i)		(val[(e)->in[i]] ^ (e)->ix[i])
+#define LANE(l)		((pal_word)1 << (l))
+
+/* Element of rank r is to be evaluated.
+ */
+#define touch_rank(r)	(dirty[(r) >> 6] |= LANE((r) & 63), \
+			 (r) >> 6 < next? next = (r) >> 6: 0)
+
+static void
+mark(n)
+int n;
+{
+  pal_word *m = rmask + (long)n * ndirty;
+  int w;
+
+  for (w = 0; w < ndirty; ++w)
+    if (m[w] != 0) {
+      dirty[w] |= m[w];
+      if (w < next) next = w;
+    }
+}
+
+/* The level of net n from its drivers: low wins, and undriven lanes
+ * float high.
+ */
+static void
+resolve(n)
+int n;
+{
+  pal_word lo = 0, d1 = 0, d2 = 0, en, v;
+  int i;
+
+  if (fixed[n]) return;
+  for (i = dstart[n]; i < dstart[n + 1]; ++i) {
+    en = outen[dslot[i]];
+    lo |= en & ~outq[dslot[i]];
+    d2 |= d1 & en;
+    d1 |= en;
+  }
+  clash[n] = d2;
+  v = ~lo;
+  if (v != val[n] || d1 != drv[n]) {
+    val[n] = v;
+    drv[n] = d1;
+    mark(n);
+  }
+}
+
+static void
+put(e, o, q, en)
+struct elem *e;
+int o;
+pal_word q, en;
+{
+  pal_word was = e->q[o];
+
+  if (e->flags & F_OC) en &= ~q;
+  e->q[o] = q;				/* counts only where driven */
+  if (e->en[o] == en && !((was ^ q) & en)) return;
+  e->en[o] = en;
+  if (e->out[o] >= 0) resolve(e->out[o]);
+}
+
+/* The PAL's pins, asserted, with its combinational outputs settled
+ * through their feedback; then what pal_comb64() makes of them.  A pin
+ * not driven by its own output reads its net.  Only a change of an
+ * output which the equations read needs another pass.
+ */
+static void
+pal_run(e, pin, out, en)
+struct elem *e;
+pal_word *pin, *out, *en;
+{
+  struct pal *p = e->pal;
+  pal_word low, v;
+  unsigned long changed;
+  int i, k;
+
+  for (i = 0; i < PAL_PINS; ++i) {
+    low = (p->low & PAL_BIT(i))? ALL: 0;
+    if (p->regmask & PAL_BIT(i)) pin[i] = e->st[i];
+    else if (p->outs & PAL_BIT(i))
+      pin[i] = (e->en[i] & (e->q[i] ^ low)) | (~e->en[i] & (in(e, i) ^ low));
+    else pin[i] = in(e, i) ^ low;
+  }
+  for (k = 0; k < MAXPASS; ++k) {
+    pal_comb64(p, pin, out, en);
+    changed = 0;
+    for (i = 0; i < PAL_PINS; ++i) {
+      if (!(p->outs & PAL_BIT(i)) || (p->regmask & PAL_BIT(i))) continue;
+      low = (p->low & PAL_BIT(i))? ALL: 0;
+      v = (en[i] & out[i]) | (~en[i] & (in(e, i) ^ low));
+      if (v != pin[i]) pin[i] = v, changed |= PAL_BIT(i);
+    }
+    if (!(changed & e->fb)) break;
+  }
+}
+
+static void
+eval_pal(e)
+struct elem *e;
+{
+  struct pal *p = e->pal;
+  pal_word pin[PAL_PINS], out[PAL_PINS], en[PAL_PINS], low, oe;
+  int i;
+
+  pal_run(e, pin, out, en);
+  oe = ~in(e, 10);			/* /OE of registered parts */
+  for (i = 0; i < PAL_PINS; ++i) {
+    if (!(p->outs & PAL_BIT(i))) continue;
+    low = (p->low & PAL_BIT(i))? ALL: 0;
+    if (p->regmask & PAL_BIT(i)) put(e, i, e->st[i] ^ low, oe);
+    else put(e, i, out[i] ^ low, en[i]);
+  }
+}
+
+/* DP8419 inputs: RFCK, RFSH, CS, RASIN, B0, B1, R0-8, C0-8.  Outputs:
+ * RAS0-3, CAS, Q0-8, RFI/O.  st[0] is the refresh request.
+ */
+static int dp_in[] = {1, 5, 47, 48, 27, 26, 7, 9, 11, 14, 16, 18, 20, 22, 24,
+  8, 10, 12, 15, 17, 19, 21, 23, 25};
+#define DP_INV		0xeUL		/* RFSH, CS and RASIN active low */
+static int dp_out[] = {28, 29, 30, 31, 32, 43, 42, 41, 40, 39, 37, 35, 34,
+  33, 46};
+
+static void
+eval_8419(e)
+struct elem *e;
+{
+  pal_word rfsh = in(e, 1), acc, sel;
+  int b, i;
+
+  e->st[0] &= ~rfsh;			/* request taken */
+  acc = in(e, 2) & in(e, 3) & ~rfsh;
+  for (b = 0; b < 4; ++b) {
+    sel = ((b & 1)? in(e, 4): ~in(e, 4)) & ((b & 2)? in(e, 5): ~in(e, 5));
+    put(e, b, ~((acc & sel) | rfsh), ALL);
+  }
+  put(e, 4, ~acc, ALL);
+  for (i = 0; i < 9; ++i)
+    put(e, 5 + i, (acc & in(e, 15 + i)) | (~acc & in(e, 6 + i)), ALL);
+  put(e, 14, ~e->st[0], ALL);
+}
+
+static void
+eval(e)
+struct elem *e;
+{
+  pal_word v, en;
+  int i, o;
+
+  ++evals;
+  switch (e->kind) {
+    case K_AND:
+      for (v = ALL, i = 0; i < e->nin; ++i) v &= in(e, i);
+      put(e, 0, (e->flags & F_NEG)? ~v: v, ALL);
+      break;
+    case K_OR:
+      for (v = 0, i = 0; i < e->nin; ++i) v |= in(e, i);
+      put(e, 0, (e->flags & F_NEG)? ~v: v, ALL);
+      break;
+    case K_TRI:
+      for (en = ALL, i = 1; i < e->nin; ++i) en &= in(e, i);
+      put(e, 0, in(e, 0), en);
+      break;
+    case K_LATCH:
+      v = in(e, 1);
+      e->st[0] = (v & in(e, 0)) | (~v & e->st[0]);
+      put(e, 0, e->st[0], in(e, 2));
+      break;
+    case K_MUX:
+      v = in(e, 0);
+      put(e, 0, in(e, 1) & ((v & in(e, 3)) | (~v & in(e, 2))), ALL);
+      break;
+    case K_DEC:
+      en = in(e, 3) & in(e, 4) & in(e, 5);
+      for (o = 0; o < 8; ++o) {
+	for (v = en, i = 0; i < 3; ++i)
+	  v &= ((o >> i) & 1)? in(e, i): ~in(e, i);
+	put(e, o, ~v, ALL);
+      }
+      break;
+    case K_MEM:
+      for (en = ALL, i = 0; i < e->nin; ++i) en &= in(e, i);
+      for (o = 0; o < e->nout; ++o) put(e, o, e->st[o], en);
+      break;
+    case K_PAL:
+      eval_pal(e);
+      break;
+    case K_8419:
+      eval_8419(e);
+      break;
+  }
+}
+
+/* Evaluate the marked elements, lowest rank first, until nothing
+ * changes.  A tree of gates is evaluated once, each after what feeds
+ * it; a loop goes round until it settles, or MAXPASS times as many
+ * evaluations as there are elements, when it is taken to oscillate.
+ */
+static void
+settle()
+{
+  long left = (long)MAXPASS * nsweep;
+  pal_word w;
+  int r;
+
+  while (next < ndirty) {
+    if ((w = dirty[next]) == 0) {
+      ++next;
+      continue;
+    }
+    if (--left < 0) {
+      ++oscillations;
+      memset(dirty, 0, ndirty * sizeof *dirty);
+      next = ndirty;
+      break;
+    }
+    r = (next << 6) + lane(w);
+    dirty[next] = w & (w - 1);
+    eval(&elem[order[r]]);
+  }
+}
+
+static void
+touch(k)
+int k;
+{
+  if (rank[k] >= 0) touch_rank(rank[k]);
+}
+
+/* Settle, then clock everything that saw a rising edge, each on what
+ * it saw before the edge; until no more edges.
+ */
+static void
+edges()
+{
+  pal_word pin[PAL_PINS], out[PAL_PINS], en[PAL_PINS], v;
+  struct elem *e;
+  int i, j, k, any;
+
+  settle();
+  for (k = 0; k < MAXPASS; ++k) {
+    for (any = i = 0; i < nclocked; ++i) {
+      e = &elem[clocked[i]];
+      v = val[e->clk];
+      e->rise = v & ~e->lastclk;
+      e->lastclk = v;
+      if (e->rise == 0) continue;
+      any = 1;
+      if (e->kind == K_8419) e->nx[0] = ALL;
+      else {
+	pal_run(e, pin, out, en);
+	pal_eval64(e->pal, pin, out, en);
+	for (j = 0; j < PAL_PINS; ++j) e->nx[j] = out[j];
+      }
+    }
+    if (!any) return;
+    for (i = 0; i < nclocked; ++i) {
+      e = &elem[clocked[i]];
+      if (e->rise == 0) continue;
+      for (j = 0; j < (e->kind == K_8419? 1: PAL_PINS); ++j)
+	if (e->kind == K_8419 || (e->pal->regmask & PAL_BIT(j)))
+	  e->st[j] = (e->st[j] & ~e->rise) | (e->nx[j] & e->rise);
+      touch(clocked[i]);
+    }
+    settle();
+  }
+}
+
+/* The bus model
+ */
+static void
+drive(sig, q, en)
+int sig;
+pal_word q, en;
+{
+  if (bus >= 0) put(&elem[bus], sig, q, en);
+}
+
+static int busnet[NBUSIN];
+
+static unsigned long
+rnd()
+{
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+/* Next access: its address, whether a read, whether a word.  Return 0
+ * at the end of the workload.
+ */
+static int
+workload(a, rd, word)
+unsigned long *a;
+int *rd, *word;
+{
+  if (mode == W_MAP) {
+    if (nextpage >= 2 * PAGES) return 0;
+    *a = (unsigned long)(nextpage++ % PAGES) << 8;
+    *rd = *word = 1;
+    return 1;
+  }
+  if (started >= count) return 0;
+  if (mode == W_SEQ) {
+    *a = (0x200000 + 2 * started) & 0xfffffe;
+    *rd = *word = 1;
+  } else {
+    switch (rnd() & 3) {			/* I/O and the ROM and RAM */
+      case 0: *a = 0xff0000 | (rnd() & 0xffff); break;	/* more often */
+      case 1: *a = rnd() & 0x1ffff; break;
+      default: *a = rnd() & 0xffffff; break;
+    }
+    *rd = (rnd() & 3) != 0;
+    *word = !(*a & 1) && (rnd() & 3) != 0;
+  }
+  ++started;
+  return 1;
+}
+
+/* Load lane l's next access.
+ */
+static int
+start(l)
+int l;
+{
+  pal_word bit = LANE(l);
+  unsigned long a, d;
+  int rd, word, i;
+
+  if (!workload(&a, &rd, &word)) return 0;
+  adr[l] = a;
+  d = (a >> 1) ^ 0x5a5a;
+  for (i = 0; i < 24; ++i)
+    adrw[i] = (adrw[i] & ~bit) | (pal_word)((a >> i) & 1) << l;
+  for (i = 0; i < 16; ++i)
+    datw[i] = (datw[i] & ~bit) | (pal_word)((d >> i) & 1) << l;
+  rdm = rd? rdm | bit: rdm & ~bit;
+  hbem = (word || (a & 1))? hbem | bit: hbem & ~bit;
+  ws[l] = wc[l] = 0;
+  idle[l] = gap;
+  return 1;
+}
+
+static void
+drive_bus(half)
+int half;
+{
+  pal_word busy = tsm[T1] | tsm[T2] | tsm[T3] | tsm[TW] | tsm[T4];
+  pal_word data = busy & ~tsm[T1];
+  pal_word strobe = tsm[T2] | tsm[T3] | tsm[TW];
+  pal_word ads = half? tsm[T1]: 0;
+  int i;
+
+  drive(S_ADS, ~ads, ALL);
+  drive(S_PAV, ~ads, ALL);
+  drive(S_DDIN, ~(busy & rdm), ALL);
+  drive(S_HBE, ~(busy & hbem), ALL);
+  drive(S_TSO, ~data, ALL);
+  drive(S_RD, ~(strobe & rdm), ALL);
+  drive(S_WR, ~(strobe & ~rdm), ALL);
+  drive(S_DBE, ~((half? 0: tsm[T2]) | tsm[T3] | tsm[TW] |
+    (half? tsm[T4]: 0)), ALL);
+  for (i = 0; i < 16; ++i)
+    drive(S_AD(i), (tsm[T1] & adrw[i]) | (~tsm[T1] & datw[i]),
+      tsm[T1] | (data & ~rdm));
+  for (i = 16; i < 24; ++i) drive(S_AD(i), adrw[i], ALL);
+}
+
+/* Lane l leaves T3 or Tw: what did the cycle select, and did anything
+ * answer a read?
+ */
+static void
+record(l)
+int l;
+{
+  pal_word bit = LANE(l);
+  int j, k, nod = 0, lo, hi;
+
+  for (k = 0; k < ncs && !(csw[k] & bit); ++k);
+  for (j = k + 1; j < ncs && !(csw[j] & bit); ++j);
+  if (j < ncs && conflicts++ == 0) {
+    conflict_adr = adr[l];
+    conflict_a = csnet[k];
+    conflict_b = csnet[j];
+  }
+  ++region[k].cycles;
+  if (rdm & bit) {
+    ++region[k].reads;
+    lo = elem[bus].out[S_AD(0)];
+    hi = elem[bus].out[S_AD(8)];
+    nod = !(memw & bit) ||
+      (!(adr[l] & 1) && lo >= 0 && !(drv[lo] & bit)) ||
+      ((hbem & bit) && hi >= 0 && !(drv[hi] & bit));
+    region[k].nodata += nod;
+  } else ++region[k].writes;
+  region[k].waits += ws[l];
+  if (ws[l] > region[k].maxwait) region[k].maxwait = ws[l];
+  if (pagecs != NULL) {
+    pagecs[adr[l] >> 8] = k;
+    if (ws[l] < pagew[adr[l] >> 8]) pagew[adr[l] >> 8] = ws[l];
+    pagenod[adr[l] >> 8] = nod;
+  }
+  ++cycles;
+}
+
+/* End of the second half: what the TCU samples.
+ */
+static void
+sample()
+{
+  pal_word w[NBUSIN], b, bit, busy3 = tsm[T3] | tsm[TW];
+  struct elem *e;
+  int i, l;
+
+  for (i = 0; i < NBUSIN; ++i) w[i] = (busnet[i] < 0)? 0: ~val[busnet[i]];
+  b = tsm[T2] & (w[I_WAIT8] | w[I_WAIT4] | w[I_WAIT2] | w[I_WAIT1] |
+    w[I_PER]);
+  for (; b != 0; b &= b - 1) {
+    bit = LANE(l = lane(b));
+    wc[l] = ((w[I_WAIT8] & bit)? 8: 0) + ((w[I_WAIT4] & bit)? 4: 0) +
+      ((w[I_WAIT2] & bit)? 2: 0) + ((w[I_WAIT1] & bit)? 1: 0) +
+      ((w[I_PER] & bit)? PERWAITS: 0);
+    counting |= bit;
+  }
+  stay = busy3 & (w[I_CWAIT] | counting);
+  for (b = stay; b != 0; b &= b - 1) {
+    bit = LANE(l = lane(b));
+    if (wc[l] > 0 && --wc[l] == 0) counting &= ~bit;
+    if (++ws[l] > MAXWAIT) {
+      ++hung;
+      stay &= ~bit;
+      counting &= ~bit;
+    }
+  }
+  leave = busy3 & ~stay;
+  for (i = 0; i < ncs; ++i) csw[i] = ~val[csnet[i]];
+  for (memw = 0, e = elem; e < elem + nelem; ++e)
+    if (e->kind == K_MEM) {
+      for (b = ALL, i = 0; i < e->nin; ++i) b &= in(e, i);
+      memw |= b;
+    }
+  for (b = leave; b != 0; b &= b - 1) record(lane(b));
+}
+
+/* CTTL rises: every lane's next T state.
+ */
+static void
+advance()
+{
+  pal_word o[6], b, bit;
+  int l;
+
+  memcpy(o, tsm, sizeof o);
+  tsm[TI] = tsm[T1] = 0;
+  tsm[T2] = o[T1];
+  tsm[T3] = o[T2];
+  tsm[TW] = stay;
+  tsm[T4] = leave;
+  stay = leave = 0;
+  for (b = (o[T4] | o[TI]) & live; b != 0; b &= b - 1) {
+    bit = LANE(l = lane(b));
+    if (o[TI] & bit) {
+      tsm[(--idle[l] > 0)? TI: T1] |= bit;
+      continue;
+    }
+    if (!start(l)) live &= ~bit;
+    else tsm[(idle[l] > 0)? TI: T1] |= bit;
+  }
+}
+
+static int *multi, nmulti;		/* nets with more than one driver */
+
+static void
+show(half)
+int half;
+{
+  int i, t;
+
+  if (verbose <= 0) return;
+  --verbose;
+  for (t = 0; t < 6 && !(tsm[t] & 1); ++t);
+  printf("%6ld %s %s ", states, (t < 6)? tname[t]: "--", half? "hi": "lo");
+  for (i = 0; i < ntrace; ++i)
+    if ((val[trace[i]] & 1) == (nl->net[trace[i]].name[0] != '-'))
+      printf(" %s", nl->net[trace[i]].name);
+  printf("\n");
+}
+
+static void
+tstate()
+{
+  int half, i;
+
+  advance();
+  for (half = 1; half >= 0; --half) {
+    drive(S_CTTL, half? ALL: 0, ALL);
+    drive(S_FCLK, 0, ALL);
+    edges();
+    drive_bus(half);
+    settle();
+    if (!half) sample();
+    for (i = 0; i < nmulti; ++i)
+      if (clash[multi[i]] != 0) nclash[multi[i]] += popcount(clash[multi[i]]);
+    show(half);
+    drive(S_FCLK, ALL, ALL);
+    edges();
+  }
+  ++states;
+}
+
+/* Building the board
+ */
+static void
+lower(to, s, n)
+char *to, *s;
+int n;
+{
+  while (--n > 0 && *s) *to++ = tolower((unsigned char)*s++);
+  *to = '\0';
+}
+
+/* 74ALS245 is 245, 7406 is 06; other types whole.
+ */
+static char *
+family(type)
+char *type;
+{
+  char *p;
+
+  if (strncmp(type, "74", 2) != 0) return type;
+  for (p = type + 2; isalpha((unsigned char)*p); ++p);
+  return isdigit((unsigned char)*p)? p: type;
+}
+
+static char *
+group(s, pin, inv, n)
+char *s;
+int *pin, *n;
+unsigned long *inv;
+{
+  *n = 0;
+  *inv = 0;
+  while (*s != '\0' && *s != ',') {
+    if (isspace((unsigned char)*s)) {
+      ++s;
+      continue;
+    }
+    if (*s == '/') {
+      *inv |= 1UL << *n;
+      ++s;
+    }
+    pin[(*n)++] = strtol(s, &s, 10);
+  }
+  return (*s == ',')? s + 1: NULL;
+}
+
+static void
+add_model(part, m)
+int part;
+struct model *m;
+{
+  struct elem *e;
+  unsigned long inv, inv2;
+  int pin[32], pin2[32], n, n2, i;
+  char *s;
+
+  for (s = m->pins; s != NULL; ) {
+    s = group(s, pin, &inv, &n);
+    switch (m->kind) {
+      case K_AND:
+      case K_OR:
+	e = new_elem(m->kind, m->flags, part, n - 1, 1);
+	for (i = 0; i < n - 1; ++i) e->in[i] = pnet(part, pin[i]);
+	e->inv = inv & ~(1UL << (n - 1));
+	e->out[0] = pnet(part, pin[n - 1]);
+	keep();
+	break;
+      case K_TRI:
+	e = new_elem(K_TRI, m->flags, part, n - 1, 1);
+	e->in[0] = pnet(part, pin[n - 2]);
+	for (i = 0; i < n - 2; ++i) e->in[i + 1] = pnet(part, pin[i]);
+	e->inv = (inv & ((1UL << (n - 2)) - 1)) << 1;
+	e->out[0] = pnet(part, pin[n - 1]);
+	keep();
+	break;
+      case K_XCV:
+	for (i = 0; i < 2; ++i) {
+	  e = new_elem(K_TRI, m->flags, part, 3, 1);
+	  e->in[0] = pnet(part, pin[2 + i]);
+	  e->in[1] = pnet(part, pin[0]);
+	  e->in[2] = pnet(part, pin[1]);
+	  e->inv = ((inv & 1) << 1 ^ (i? 2: 0)) | (inv & 2) << 1;
+	  e->out[0] = pnet(part, pin[3 - i]);
+	  keep();
+	}
+	break;
+      case K_LATCH:
+	e = new_elem(K_LATCH, m->flags, part, 3, 1);
+	e->in[0] = pnet(part, pin[2]);
+	e->in[1] = pnet(part, pin[1]);
+	e->in[2] = pnet(part, pin[0]);
+	e->inv = (inv & 1) << 2;
+	e->out[0] = pnet(part, pin[3]);
+	e->st = (pal_word *)alloc((long)sizeof(pal_word));
+	keep();
+	break;
+      case K_MUX:
+	e = new_elem(K_MUX, m->flags, part, 4, 1);
+	for (i = 0; i < 4; ++i) e->in[i] = pnet(part, pin[i]);
+	e->inv = inv & 0xf;
+	e->out[0] = pnet(part, pin[4]);
+	keep();
+	break;
+      case K_DEC:
+	e = new_elem(K_DEC, m->flags, part, 6, 8);
+	for (i = 0; i < 6; ++i) e->in[i] = pnet(part, pin[i]);
+	e->inv = inv & 0x3f;
+	for (i = 0; i < 8; ++i) e->out[i] = pnet(part, pin[6 + i]);
+	keep();
+	break;
+      case K_MEM:			/* enables, then data */
+	if (s == NULL) break;
+	s = group(s, pin2, &inv2, &n2);
+	e = new_elem(K_MEM, m->flags, part, n, n2);
+	for (i = 0; i < n; ++i) e->in[i] = pnet(part, pin[i]);
+	e->inv = inv;
+	e->st = (pal_word *)alloc((long)n2 * sizeof(pal_word));
+	for (i = 0; i < n2; ++i) {
+	  e->out[i] = pnet(part, pin2[i]);
+	  e->st[i] = (((part * 0x9d + 0x5a) >> i) & 1)? ALL: 0;
+	}
+	keep();
+	break;
+    }
+  }
+  kind_of[part] = (m->kind == K_MEM)? 'm': 'l';
+}
+
+static int
+add_pal(part, type)
+int part;
+char *type;
+{
+  struct elem *e;
+  struct pal *p;
+  char path[512];
+  int i, j;
+
+  p = (struct pal *)alloc((long)sizeof *p);
+  sprintf(path, "%.200s/%.200s", paldir, nl->part[part].name);
+  if (pal_read(p, path) < 0) {
+    sprintf(path, "%.200s/%.200s", paldir, type);
+    if (pal_read(p, path) < 0) {
+      fprintf(stderr, "boardsim: %s\n", pal_error);
+      free(p);
+      return 0;
+    }
+  }
+  e = new_elem(K_PAL, 0, part, PAL_PINS, PAL_PINS);
+  e->pal = p;
+  for (i = 0; i < p->neqn; ++i) {
+    for (j = 0; j < p->eqn[i].nterm; ++j)
+      e->fb |= p->eqn[i].term[j].on | p->eqn[i].term[j].off;
+    for (j = 0; j < p->eqn[i].nen; ++j)
+      e->fb |= p->eqn[i].en[j].on | p->eqn[i].en[j].off;
+  }
+  e->fb &= p->outs & ~p->regmask;
+  e->st = (pal_word *)alloc((long)PAL_PINS * sizeof(pal_word));
+  e->nx = (pal_word *)alloc((long)PAL_PINS * sizeof(pal_word));
+  for (i = 0; i < PAL_PINS; ++i) {
+    e->in[i] = pnet(part, i + 1);
+    e->out[i] = (p->outs & PAL_BIT(i))? e->in[i]: -1;
+  }
+  if (p->regmask != 0) e->clk = e->in[0];
+  kind_of[part] = 'l';
+  return 1;
+}
+
+static void
+add_8419(part)
+int part;
+{
+  struct elem *e = new_elem(K_8419, 0, part, 24, 15);
+  int i;
+
+  for (i = 0; i < 24; ++i) e->in[i] = pnet(part, dp_in[i]);
+  for (i = 0; i < 15; ++i) e->out[i] = pnet(part, dp_out[i]);
+  e->inv = DP_INV;
+  e->st = (pal_word *)alloc((long)sizeof(pal_word));
+  e->nx = (pal_word *)alloc((long)sizeof(pal_word));
+  e->clk = e->in[0];
+  kind_of[part] = 'c';
+}
+
+static void
+add_bus(part, type)
+int part;
+char *type;
+{
+  struct elem *e;
+  int i;
+
+  if (bus < 0) {
+    e = new_elem(K_BUS, 0, part, 0, NSIG);
+    bus = nelem - 1;
+    for (i = 0; i < NSIG; ++i) e->out[i] = -1;
+    for (i = 0; i < NBUSIN; ++i) busnet[i] = -1;
+  }
+  e = &elem[bus];
+  if (strcmp(type, "ns32016") == 0) {
+    for (i = 0; i < 16; ++i) e->out[S_AD(i)] = pnet(part, 23 - i);
+    for (i = 0; i < 7; ++i) e->out[S_AD(16 + i)] = pnet(part, 7 - i);
+  }
+  for (i = 0; buspins[i].type != NULL; ++i)
+    if (strcmp(type, buspins[i].type) == 0) {
+      if (buspins[i].input) busnet[buspins[i].sig] = pnet(part, buspins[i].pin);
+      else e->out[buspins[i].sig] = pnet(part, buspins[i].pin);
+    }
+  kind_of[part] = 'b';
+}
+
+static int
+drives(e, n)
+struct elem *e;
+int n;
+{
+  int o;
+
+  for (o = 0; o < e->nout; ++o)
+    if (e->out[o] == n) return 1;
+  return 0;
+}
+
+static void
+driver_table()
+{
+  struct elem *e;
+  long nslot;
+  int k, o, n;
+
+  dstart = (int *)alloc((long)(nl->nnets + 2) * sizeof(int));
+  for (nslot = k = 0; k < nelem; ++k) {
+    for (e = &elem[k], o = 0; o < e->nout; ++o)
+      if (e->out[o] >= 0) ++dstart[e->out[o] + 2];
+    nslot += e->nout;
+  }
+  for (n = 0; n < nl->nnets; ++n) dstart[n + 2] += dstart[n + 1];
+  dslot = (int *)alloc((long)(dstart[nl->nnets + 1] + 1) * sizeof(int));
+
+  /* The outputs move to outq and outen, so that resolve() finds
+   * them without going through the elements.
+   */
+  outq = (pal_word *)alloc(nslot * sizeof(pal_word));
+  outen = (pal_word *)alloc(nslot * sizeof(pal_word));
+  for (nslot = k = 0; k < nelem; ++k) {
+    e = &elem[k];
+    memcpy(outq + nslot, e->q, e->nout * sizeof(pal_word));
+    memcpy(outen + nslot, e->en, e->nout * sizeof(pal_word));
+    free(e->q);
+    free(e->en);
+    e->q = outq + nslot;
+    e->en = outen + nslot;
+    for (o = 0; o < e->nout; ++o)
+      if ((n = e->out[o]) >= 0) dslot[dstart[n + 1]++] = nslot + o;
+    nslot += e->nout;
+  }
+}
+
+/* Series terminations: a resistor pack with no pin on a power net
+ * joins pin i to the pin across from it, and passes on the signal from
+ * whichever side something drives.
+ */
+static void
+terminations()
+{
+  struct nl_part *p;
+  struct elem *e;
+  int *driven, k, i, a, b, t, last, changed;
+  char type[64];
+
+  driven = (int *)alloc((long)nl->nnets * sizeof(int));
+  do {
+    for (i = 0; i < nl->nnets; ++i) driven[i] = 0;
+    for (k = 0; k < nelem; ++k)
+      for (i = 0; i < elem[k].nout; ++i)
+	if (elem[k].out[i] >= 0) driven[elem[k].out[i]] = 1;
+    changed = 0;
+    for (k = 0; k < nl->nparts; ++k) {
+      p = &nl->part[k];
+      if (p->type == NULL || kind_of[k] == 'l') continue;
+      lower(type, p->type, sizeof type);
+      if (strcmp(type, "resister_pack") != 0) continue;
+      for (last = 0, i = 1; i < p->npin; ++i) {
+	if (nl_pin(nl, k, i) >= 0) last = i;
+	if ((a = pnet(k, i)) >= 0 && fixed[a]) break;
+      }
+      if (i < p->npin) continue;		/* pullups */
+      for (i = 1; i <= last / 2; ++i) {
+	a = pnet(k, i);
+	b = pnet(k, last + 1 - i);
+	if (a < 0 || b < 0 || driven[a] == driven[b]) continue;
+	if (driven[b]) t = a, a = b, b = t;
+	e = new_elem(K_AND, 0, k, 1, 1);
+	e->in[0] = a;
+	e->out[0] = b;
+	driven[b] = changed = 1;
+	kind_of[k] = 'l';
+      }
+    }
+  } while (changed);
+  free(driven);
+}
+
+/* Tarjan's strongly connected components: each is put in order[], from
+ * the end, after everything it feeds.
+ */
+static int *num, *low, *stack, *level, *comp, nnum, nstack, ncomp;
+
+static void
+strong(k)
+int k;
+{
+  struct elem *e = &elem[k];
+  int o, n, i, r, top;
+
+  num[k] = low[k] = ++nnum;
+  stack[nstack++] = k;
+  for (o = 0; o < e->nout; ++o) {
+    if ((n = e->out[o]) < 0) continue;
+    for (i = rstart[n]; i < rstart[n + 1]; ++i) {
+      if ((r = relem[i]) == bus) continue;
+      if (num[r] == 0) {
+	strong(r);
+	if (low[r] < low[k]) low[k] = low[r];
+      } else if (rank[r] < 0 && num[r] < low[k]) low[k] = num[r];
+    }
+  }
+  if (low[k] != num[k]) return;
+  top = nstack;
+  do {
+    r = stack[--nstack];
+    order[nsweep--] = r;
+    rank[r] = 0;			/* placed */
+    comp[r] = ncomp;
+  } while (r != k);
+  ++ncomp;
+  if (top - nstack > 1) nloop += top - nstack;
+}
+
+/* Which parts become which elements, then the tables of drivers and
+ * readers, and the order of evaluation.
+ */
+static void
+build()
+{
+  struct nl_part *p;
+  struct model *m;
+  struct elem *e;
+  char type[64], *f, *name;
+  int k, i, j, n, o, r;
+
+  fixed = alloc(nl->nnets + 1L);		/* and one for n/c inputs */
+  val = (pal_word *)alloc((nl->nnets + 1L) * sizeof(pal_word));
+  drv = (pal_word *)alloc((nl->nnets + 1L) * sizeof(pal_word));
+  clash = (pal_word *)alloc((nl->nnets + 1L) * sizeof(pal_word));
+  fixed[nl->nnets] = 1;
+  val[nl->nnets] = ALL;
+  nclash = (long *)alloc((long)nl->nnets * sizeof(long));
+  for (n = 0; n < nl->nnets; ++n) {
+    lower(type, nl->net[n].name, sizeof type);
+    val[n] = ALL;
+    if (strcmp(type, "gnd") == 0) fixed[n] = 1, val[n] = 0;
+    else if (strcmp(type, "+5v") == 0 || strcmp(type, "vcc") == 0 ||
+      strcmp(type, "+tie_high") == 0) fixed[n] = 1;
+  }
+
+  kind_of = alloc((long)nl->nparts);
+  for (k = 0; k < nl->nparts; ++k) {
+    p = &nl->part[k];
+    kind_of[k] = '?';
+    if (p->type == NULL) {
+      lower(type, p->name, sizeof type);
+      if (strcmp(type, "pullup") == 0) kind_of[k] = 'p';
+      continue;
+    }
+    lower(type, p->type, sizeof type);
+    f = family(type);
+    if (strcmp(type, "ns32016") == 0 || strcmp(type, "ns32082") == 0 ||
+      strcmp(type, "ns32201") == 0) {
+      add_bus(k, type);
+      continue;
+    }
+    lower(name = (char *)alloc(64L), p->name, 64);
+    if ((strncmp(type, "pal", 3) == 0 || strcmp(type, name) == 0) &&
+      add_pal(k, type)) {
+      free(name);
+      continue;
+    }
+    free(name);
+    for (m = models; m->type != NULL && strcmp(m->type, f) != 0; ++m);
+    if (m->type != NULL) add_model(k, m);
+    else if (strcmp(type, "dp8419") == 0) add_8419(k);
+    else if (strcmp(type, "resister_pack") == 0) kind_of[k] = 'p';
+    else {
+      for (i = 0; passive[i] != NULL && strcmp(passive[i], type) != 0; ++i);
+      if (passive[i] != NULL) kind_of[k] = 'p';
+    }
+  }
+  if (bus < 0) {
+    fprintf(stderr, "boardsim: %s: no ns32016, ns32082 or ns32201\n",
+      nl->file);
+    exit(1);
+  }
+  terminations();
+  driver_table();
+
+  /* Readers: every input of an element, except of its own outputs.
+   */
+  rstart = (int *)alloc((long)(nl->nnets + 2) * sizeof(int));
+  for (k = 0; k < nelem; ++k)
+    for (e = &elem[k], i = 0; i < e->nin; ++i)
+      if (e->in[i] >= 0 && !drives(e, e->in[i])) ++rstart[e->in[i] + 2];
+  for (n = 0; n < nl->nnets; ++n) rstart[n + 2] += rstart[n + 1];
+  relem = (int *)alloc((long)(rstart[nl->nnets + 1] + 1) * sizeof(int));
+  for (k = 0; k < nelem; ++k)
+    for (e = &elem[k], i = 0; i < e->nin; ++i)
+      if (e->in[i] >= 0 && !drives(e, e->in[i]))
+	relem[rstart[e->in[i] + 1]++] = k;
+
+  /* Level order: the loops (strongly connected elements) found, and
+   * everything sorted so that each element or loop comes after what
+   * feeds it.
+   */
+  order = (int *)alloc((long)nelem * sizeof(int));
+  rank = (int *)alloc((long)nelem * sizeof(int));
+  num = (int *)alloc((long)nelem * sizeof(int));
+  low = (int *)alloc((long)nelem * sizeof(int));
+  stack = (int *)alloc((long)nelem * sizeof(int));
+  level = (int *)alloc((long)nelem * sizeof(int));
+  comp = (int *)alloc((long)nelem * sizeof(int));
+  for (k = 0; k < nelem; ++k) rank[k] = -1;
+  nsweep = nelem - 1;			/* filled from the end */
+  for (k = 0; k < nelem; ++k)
+    if (k != bus && num[k] == 0) strong(k);
+  nsweep = nelem - 1;
+  for (i = 0; i < nsweep; ++i) order[i] = order[i + 1];
+
+  /* Inside a loop, what is nearer the bus first: num[] becomes the
+   * distance from it.
+   */
+  for (k = 0; k < nelem; ++k) num[k] = nelem;
+  stack[0] = bus;
+  num[bus] = 0;
+  for (i = 0, j = 1; i < j; ++i) {
+    e = &elem[k = stack[i]];
+    for (o = 0; o < e->nout; ++o)
+      if ((n = e->out[o]) >= 0)
+	for (r = rstart[n]; r < rstart[n + 1]; ++r)
+	  if (num[relem[r]] == nelem) {
+	    num[relem[r]] = num[k] + 1;
+	    stack[j++] = relem[r];
+	  }
+  }
+  for (i = 1; i < nsweep; ++i)
+    for (j = i; j > 0 && comp[order[j]] == comp[order[j - 1]] &&
+      num[order[j]] < num[order[j - 1]]; --j)
+      k = order[j], order[j] = order[j - 1], order[j - 1] = k;
+  for (i = 0; i < nsweep; ++i) rank[order[i]] = i;
+  for (i = 0; i < nsweep; ++i) {
+    e = &elem[k = order[i]];
+    if (level[k] + 1 > nlevels) nlevels = level[k] + 1;
+    for (o = 0; o < e->nout; ++o)
+      if ((n = e->out[o]) >= 0)
+	for (j = rstart[n]; j < rstart[n + 1]; ++j)
+	  if (rank[r = relem[j]] > i && level[r] < level[k] + 1)
+	    level[r] = level[k] + 1;
+  }
+  free(num);
+  free(low);
+  free(stack);
+  free(level);
+  free(comp);
+
+  ndirty = (nsweep + 63) / 64;
+  dirty = (pal_word *)alloc((long)ndirty * sizeof(pal_word));
+  next = ndirty;
+  rmask = (pal_word *)alloc((long)nl->nnets * ndirty * sizeof(pal_word));
+  for (n = 0; n < nl->nnets; ++n)
+    for (i = rstart[n]; i < rstart[n + 1]; ++i)
+      if ((r = rank[relem[i]]) >= 0)
+	rmask[(long)n * ndirty + (r >> 6)] |= LANE(r & 63);
+  clocked = (int *)alloc((long)nelem * sizeof(int));
+  for (k = 0; k < nelem; ++k) {
+    e = &elem[k];
+    if (e->clk >= 0) clocked[nclocked++] = k;
+    e->ix = (pal_word *)alloc((long)(e->nin + 1) * sizeof(pal_word));
+    for (i = 0; i < e->nin; ++i) {
+      if (e->in[i] < 0) e->in[i] = nl->nnets;	/* floats high */
+      e->ix[i] = ((e->inv >> i) & 1)? ALL: 0;
+    }
+  }
+  multi = (int *)alloc((long)nl->nnets * sizeof(int));
+  for (n = 0; n < nl->nnets; ++n)
+    if (dstart[n + 1] - dstart[n] > 1) multi[nmulti++] = n;
+}
+
+/* Chip selects: active low nets called _cs, which reach something
+ * more than logic.
+ */
+static void
+find_selects()
+{
+  char *s;
+  int n, d, reach;
+
+  for (n = 0; n < nl->nnets && ncs < MAXCS; ++n) {
+    s = nl->net[n].name;
+    if (s[0] != '-' || (strstr(s, "_cs_") == NULL &&
+      (strlen(s) < 4 || strcmp(s + strlen(s) - 3, "_cs") != 0)))
+      continue;
+    for (reach = 0, d = nl->net[n].first; d >= 0; d = nl->node[d].next) {
+      switch (kind_of[nl->node[d].part]) {
+	case 'm':
+	case 'c':
+	  answered[ncs] = 1;
+	  /* FALLTHROUGH */
+	case 'b':
+	case '?':
+	  reach = 1;
+      }
+    }
+    if (reach) csnet[ncs++] = n;
+  }
+}
+
+static void
+report(secs)
+double secs;
+{
+  int k, n, j, i;
+  long page, end;
+
+  printf("%-16s %9s %9s %9s %6s %4s %8s\n", "chip select", "cycles",
+    "reads", "writes", "waits", "max", "no data");
+  for (k = 0; k <= ncs; ++k) {
+    if (region[k].cycles == 0) continue;
+    printf("%-16s %9ld %9ld %9ld %6.2f %4d ",
+      (k < ncs)? nl->net[csnet[k]].name: "(none)", region[k].cycles,
+      region[k].reads, region[k].writes,
+      (double)region[k].waits / region[k].cycles, region[k].maxwait);
+    if (k < ncs && answered[k]) printf("%8ld\n", region[k].nodata);
+    else printf("%8s\n", "-");
+  }
+  if (conflicts > 0)
+    printf("%ld cycles with two chip selects, the first at %06lx: %s and %s\n",
+      conflicts, conflict_adr, nl->net[conflict_a].name,
+      nl->net[conflict_b].name);
+  else printf("no cycles with two chip selects\n");
+  for (j = i = 0; i < nmulti; ++i) {
+    if (nclash[n = multi[i]] == 0) continue;
+    if (j++ == 0) printf("nets driven by two parts at once, lanes by halves:\n");
+    printf("  %-16s %ld\n", nl->net[n].name, nclash[n]);
+  }
+  if (j == 0) printf("no nets driven by two parts at once\n");
+  if (hung > 0) printf("%ld cycles gave up after %d wait states\n", hung,
+    MAXWAIT);
+  if (oscillations > 0) printf("%ld settles did not settle\n", oscillations);
+
+  if (pagecs != NULL) {
+    printf("memory map:\n");
+    for (page = 0; page < PAGES; page = end) {
+      for (end = page + 1; end < PAGES && pagecs[end] == pagecs[page] &&
+	pagew[end] == pagew[page] && pagenod[end] == pagenod[page]; ++end);
+      k = pagecs[page];
+      printf("  %06lx-%06lx %-16s %d waits%s\n", page << 8,
+	(end << 8) - 1, (k < ncs)? nl->net[csnet[k]].name: "(none)",
+	pagew[page], pagenod[page]? ", reads not answered": "");
+    }
+  }
+  printf("%ld bus cycles in %ld T states, %ld evaluations, %.2f s", cycles,
+    states, evals, secs);
+  if (secs > 0) printf(": %.2f million bus cycles a second", cycles / secs / 1e6);
+  printf("\n");
+}
+
+int
+main(argc, argv)
+int argc;
+char **argv;
+{
+  static char *deftrace[] = {"-pav", "-ddin", "-tso", "-rd", "-wr", "-dbe",
+    "-cwait", "-rasin", "-mode", "+rfio", "-dram_cs", "-ras12", "-cas2",
+    NULL};
+  char *file = NETLIST, *partlist = NULL, *tnames[MAXTRACE], path[512], *p;
+  int i, k, n, nt = 0, nparts[128];
+  clock_t t0;
+  FILE *f;
+
+  for (i = 1; i < argc; ++i) {
+    if (argv[i][0] != '-') {
+      file = argv[i];
+      continue;
+    }
+    switch (argv[i][1]) {
+      case 'v':
+	verbose = 400;
+	break;
+      case 'p':
+      case 'd':
+      case 'n':
+      case 'g':
+      case 's':
+      case 't':
+	if (++i >= argc) usage();
+	p = argv[i];
+	switch (argv[i - 1][1]) {
+	  case 'p': partlist = p; break;
+	  case 'd': paldir = p; break;
+	  case 'n': count = strtol(p, (char **)0, 0); break;
+	  case 'g': gap = strtol(p, (char **)0, 0); break;
+	  case 's': synth = p; break;
+	  case 't': if (nt < MAXTRACE) tnames[nt++] = p; break;
+	}
+	break;
+      default:
+	usage();
+    }
+  }
+  for (mode = 0; synths[mode] != NULL && strcmp(synths[mode], synth) != 0;
+    ++mode);
+  if (synths[mode] == NULL) usage();
+
+  if ((nl = nl_read(file)) == NULL) {
+    fprintf(stderr, "boardsim: %s\n", nl_error);
+    exit(1);
+  }
+  if (strlen(file) < sizeof path - 10) {
+    strcpy(path, file);
+    p = strrchr(path, '/');
+    *(p? p: path) = '\0';
+    if (paldir == NULL) paldir = strcpy((char *)alloc(strlen(path) + 2L),
+      p? path: ".");
+    if (partlist == NULL && !nl->xml) {
+      strcat(path, p? "/partlist": "partlist");
+      if ((f = fopen(path, "r")) != NULL) {
+	fclose(f);
+	partlist = path;
+      }
+    }
+  }
+  if (paldir == NULL) paldir = ".";
+  if (partlist != NULL && nl_types(nl, partlist) < 0) {
+    fprintf(stderr, "boardsim: %s\n", nl_error);
+    exit(1);
+  }
+  for (i = 0; i < LANES; ++i) debruijn[(LANE(i) * DEBRUIJN) >> 58] = i;
+  build();
+  find_selects();
+
+  for (i = 0; i < 128; ++i) nparts[i] = 0;
+  for (k = 0; k < nl->nparts; ++k) ++nparts[kind_of[k] & 127];
+  printf("%s: %d parts: %d simulated, %d as the bus, %d passive, %d not\n",
+    file, nl->nparts, nparts['l'] + nparts['m'] + nparts['c'], nparts['b'],
+    nparts['p'], nparts['?']);
+  if (nparts['?'] > 0) {
+    printf("not simulated:");
+    for (k = 0; k < nl->nparts; ++k)
+      if (kind_of[k] == '?')
+	printf(" %s (%s)", nl->part[k].name,
+	  nl->part[k].type? nl->part[k].type: "?");
+    printf("\n");
+  }
+  printf("%d elements in %d levels, %d of them in loops; %d clocked; %d chip selects\n",
+    nsweep, nlevels, nloop, nclocked, ncs);
+
+  if (nt == 0)
+    for (i = 0; deftrace[i] != NULL; ++i) tnames[nt++] = deftrace[i];
+  for (i = 0; i < nt; ++i)
+    if ((n = nl_net(nl, tnames[i])) >= 0) trace[ntrace++] = n;
+    else if (nt != i && tnames[i] != deftrace[i])
+      fprintf(stderr, "boardsim: no net %s\n", tnames[i]);
+  if (mode == W_MAP) {
+    pagecs = (unsigned char *)alloc((long)PAGES);
+    pagew = (unsigned char *)alloc((long)PAGES);
+    pagenod = (unsigned char *)alloc((long)PAGES);
+    for (i = 0; i < PAGES; ++i) pagecs[i] = ncs, pagew[i] = 255;
+  }
+
+  /* Power up: nets high, registers clear, the TCU out of reset and
+   * every lane idle for a state before its first access.
+   */
+  for (k = 0; k < nsweep; ++k) touch_rank(k);
+  drive(S_HLDA, ALL, ALL);
+  drive(S_RSTO, ALL, ALL);
+  drive(S_RDY, ALL, ALL);
+  drive(S_CTTL, 0, ALL);
+  drive(S_FCLK, 0, ALL);
+  drive_bus(0);
+  for (n = 0; n < nl->nnets; ++n) resolve(n);
+  settle();
+  for (i = 0; i < nclocked; ++i)
+    elem[clocked[i]].lastclk = val[elem[clocked[i]].clk];
+  for (i = 0; i < LANES; ++i)
+    if (start(i)) {
+      live |= LANE(i);
+      tsm[TI] |= LANE(i);
+      ++idle[i];
+    }
+
+  t0 = clock();
+  while (live != 0 || (tsm[T1] | tsm[T2] | tsm[T3] | tsm[TW] | tsm[T4]))
+    tstate();
+  report((double)(clock() - t0) / CLOCKS_PER_SEC);
+  exit(conflicts > 0);
+}
@@ -0,0 +1,378 @@
+/* DRAM bandwidth model of the NS32016 board.
+ *
+ * Runs the CPU bus against the board's own PAL equations, every FCLK
+ * edge: memcspal decodes the address, dramcpal (the DP84412 equivalent)
+ * sequences the DP8419 and asks the TCU for wait states, and rfshpal
+ * divides CTTL down to the refresh clock.  The accesses come from a
+ * trace file or a synthetic workload.  The result is how many wait
+ * states the DRAM costs, how often refresh gets in the way, and the
+ * bandwidth left.
+ *
+ * Usage: dramsim [-v] [-w] [-d <pal dir>] [-m <MHz>] [-n <count>]
+ *		  [-g <idle clocks>] [-s seq|write|copy|rand|fetch | <trace>]
+ *
+ * A trace has one access per line: r <hex address> or w <hex address>,
+ * optionally i <n> for n idle clocks, and # comments.  -w asserts the
+ * WAITRD and WAITWR jumpers, which are tied off on the board.
+ *
+ * What is modelled, and what is not:
+ *
+ *	FCLK runs at twice CTTL, and CTTL is high in the first half of
+ *	each T state.  The PALs see each input as it was in the half
+ *	period before the clock edge.
+ *
+ *	A bus cycle is T1 T2 T3 [Tw...] T4.  PAV (ADS) is asserted in the
+ *	first half of T1, TSO from T2 through T4, DDIN for the whole of a
+ *	read.  The latched address, and so CS, holds until the next T1.
+ *	The TCU adds a Tw after T3 or Tw whenever CWAIT is asserted at the
+ *	end of it.
+ *
+ *	The DP8419 is only modelled as far as the PAL can see it: each
+ *	rising edge of the refresh clock (/Q7 of rfshpal) raises a refresh
+ *	request on RFIO, and the request is taken when dramcpal asserts
+ *	MODE.  Memory timing inside the 8419 and the delay lines is not
+ *	modelled; it does not change when CWAIT is released.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pal.h"
+
+#define PALDIR		"../Culbertson-32016"
+#define MAXWAIT		64		/* wait states before giving up */
+#define BUSBYTES	2		/* NS32016 data bus */
+
+#define TI		0
+#define T1		1
+#define T2		2
+#define T3		3
+#define TW		4
+#define T4		5
+static char *tname[] = {"Ti", "T1", "T2", "T3", "Tw", "T4"};
+
+struct pal dramc, memcs, rfsh;
+
+/* Pins of the signals used, looked up by name so that an edited PAL
+ * still works.
+ */
+static int p_tso, p_rfio, p_ads, p_ddin, p_waitwr, p_cttl, p_cs, p_waitrd;
+static int p_cwait, p_mode, p_rasin, p_dram, p_q7, p_adr[9];
+
+/* Workload
+ */
+static FILE *trace;
+static char *synth;
+static long count = 10000, gap, generated;
+static unsigned long seed = 1, seqadr = 0x20000;
+
+/* Results
+ */
+static long clocks, busclocks, reads, writes, dreads, dwrites;
+static long rwaits, wwaits, maxwait, refreshes, collisions, hist[MAXWAIT + 1];
+
+static void
+usage()
+{
+  fprintf(stderr, "usage: dramsim [-v] [-w] [-d paldir] [-m MHz] [-n count]\n\
+	[-g idle] [-s seq|write|copy|rand|fetch | trace]\n");
+  exit(2);
+}
+
+static void
+load(pal, dir, file)
+struct pal *pal;
+char *dir, *file;
+{
+  char path[512];
+
+  sprintf(path, "%s/%s", dir, file);
+  if (pal_read(pal, path) < 0) {
+    fprintf(stderr, "dramsim: %s\n", pal_error);
+    exit(1);
+  }
+}
+
+static int
+pin(pal, name)
+struct pal *pal;
+char *name;
+{
+  int p;
+
+  if ((p = pal_pin(pal, name)) < 0) {
+    fprintf(stderr, "dramsim: %s has no pin %s\n", pal->type, name);
+    exit(1);
+  }
+  return p;
+}
+
+#define SET(v,p,x)	((x)? (v) | PAL_BIT(p): (v) & ~PAL_BIT(p))
+#define GET(v,p)	(((v) >> (p)) & 1)
+
+/* Is adr in DRAM?  Asks memcspal.
+ */
+static int
+is_dram(adr)
+unsigned long adr;
+{
+  unsigned long v = 0;
+  int i;
+
+  for (i = 0; i < 9; ++i) v = SET(v, p_adr[i], (adr >> (15 + i)) & 1);
+  return GET(pal_comb(&memcs, v), p_dram);
+}
+
+static unsigned long
+rnd()
+{
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+/* Next access: 'r' or 'w' and its address, after *idle idle clocks.
+ * Return 0 at the end of the workload.
+ */
+static int
+next_access(adr, idle)
+unsigned long *adr;
+long *idle;
+{
+  char line[256], op;
+
+  *idle = gap;
+  if (trace != NULL) {
+    while (fgets(line, sizeof line, trace) != NULL) {
+      if (sscanf(line, " %c %lx", &op, adr) != 2) continue;
+      if (op == 'i') *idle += *adr;
+      else if (op == 'r' || op == 'w') return op;
+    }
+    return 0;
+  }
+  if (generated >= count) return 0;
+  ++generated;
+  if (strcmp(synth, "seq") == 0) {
+    *adr = seqadr;
+    seqadr += BUSBYTES;
+    return 'r';
+  } else if (strcmp(synth, "write") == 0) {
+    *adr = seqadr;
+    seqadr += BUSBYTES;
+    return 'w';
+  } else if (strcmp(synth, "copy") == 0) {
+    *adr = seqadr + ((generated & 1)? 0: 0x100000);
+    if (!(generated & 1)) seqadr += BUSBYTES;
+    return (generated & 1)? 'r': 'w';
+  } else if (strcmp(synth, "rand") == 0) {
+    *adr = rnd() & 0x7ffffe;
+    return (rnd() & 3)? 'r': 'w';
+  } else if (strcmp(synth, "fetch") == 0) {
+    *adr = seqadr;			/* code from DRAM, data from SRAM, */
+    seqadr += BUSBYTES;			/* some execute cycles between */
+    if (rnd() % 4 == 0) *adr = 0x8000 + (rnd() & 0x7ffe);
+    *idle += rnd() % 3;
+    return 'r';
+  }
+  usage();
+  return 0;				/* not reached */
+}
+
+/* Set the dramcpal inputs for one half of T state ts of an access of
+ * kind op.  The first half is the one with CTTL high.
+ */
+static unsigned long
+inputs(v, ts, first, op, cs, request)
+unsigned long v;
+int ts, first, op, cs, request;
+{
+  v = SET(v, p_cttl, first);
+  v = SET(v, p_ads, ts == T1 && first);
+  v = SET(v, p_tso, ts >= T2);
+  v = SET(v, p_ddin, ts != TI && op == 'r');
+  v = SET(v, p_cs, cs);
+  v = SET(v, p_rfio, !request);		/* RFIO low asks for refresh */
+  return SET(v, p_cwait, 0);		/* pulled up unless driven */
+}
+
+static void
+report(mhz)
+double mhz;
+{
+  double sec = clocks / (mhz * 1e6);
+  long dram = dreads + dwrites, acc = reads + writes;
+  int i;
+
+  printf("%ld accesses, %ld to DRAM (%ld reads, %ld writes)\n", acc, dram,
+    dreads, dwrites);
+  printf("%ld clocks, %ld in bus cycles, %.3f ms at %.1f MHz\n", clocks,
+    busclocks, sec * 1e3, mhz);
+  printf("wait states: reads %.2f, writes %.2f on average, %ld at most\n",
+    dreads? (double)rwaits / dreads: 0.0,
+    dwrites? (double)wwaits / dwrites: 0.0, maxwait);
+  printf("waits per DRAM access:");
+  for (i = 0; i <= maxwait; ++i)
+    if (hist[i] != 0) printf(" %d:%ld", i, hist[i]);
+  printf("\n%ld refreshes, one per %.1f us; %ld DRAM accesses waited for one\n",
+    refreshes, refreshes? sec * 1e6 / refreshes: 0.0, collisions);
+  if (sec > 0)
+    printf("%.2f MB/s, %.2f MB/s without wait states\n",
+      acc * BUSBYTES / sec / 1e6,
+      acc * BUSBYTES / ((clocks - rwaits - wwaits) / (mhz * 1e6)) / 1e6);
+}
+
+int
+main(argc, argv)
+int argc;
+char **argv;
+{
+  char *dir = PALDIR, *p, name[8];
+  double mhz = 10.0;
+  unsigned long v, r, adr;
+  long idle, verbose = 0;
+  int i, ts, op, cs, request, waits, rfclk, oldclk, jumpers = 0, touched;
+  int cwait;
+
+  synth = "seq";
+  for (i = 1; i < argc; ++i) {
+    if (argv[i][0] != '-') {
+      if ((trace = fopen(argv[i], "r")) == NULL) {
+	perror(argv[i]);
+	exit(1);
+      }
+      continue;
+    }
+    switch (argv[i][1]) {
+      case 'v':
+	verbose = 400;
+	break;
+      case 'w':
+	jumpers = 1;
+	break;
+      case 'd':
+      case 'm':
+      case 'n':
+      case 'g':
+      case 's':
+	if (++i >= argc) usage();
+	p = argv[i];
+	switch (argv[i - 1][1]) {
+	  case 'd': dir = p; break;
+	  case 'm': mhz = atof(p); break;
+	  case 'n': count = strtol(p, (char **)0, 0); break;
+	  case 'g': gap = strtol(p, (char **)0, 0); break;
+	  case 's': synth = p; break;
+	}
+	break;
+      default:
+	usage();
+    }
+  }
+  if (mhz <= 0) usage();
+  load(&dramc, dir, "dramcpal");
+  load(&memcs, dir, "memcspal");
+  load(&rfsh, dir, "rfshpal");
+  p_tso = pin(&dramc, "TSO");
+  p_rfio = pin(&dramc, "RFIO");
+  p_ads = pin(&dramc, "ADS");
+  p_ddin = pin(&dramc, "DDIN");
+  p_waitwr = pin(&dramc, "WAITWR");
+  p_cttl = pin(&dramc, "CTTL");
+  p_cs = pin(&dramc, "CS");
+  p_waitrd = pin(&dramc, "WAITRD");
+  p_cwait = pin(&dramc, "CWAIT");
+  p_mode = pin(&dramc, "MODE");
+  p_rasin = pin(&dramc, "RASIN");
+  p_dram = pin(&memcs, "DRAM");
+  p_q7 = pin(&rfsh, "Q7");
+  for (i = 0; i < 9; ++i) {
+    sprintf(name, "A%d", 15 + i);
+    p_adr[i] = pin(&memcs, name);
+  }
+
+  /* Registers power up clear: every registered output negated and the
+   * refresh counter at 0.
+   */
+  v = SET(SET(0UL, p_waitwr, jumpers), p_waitrd, jumpers);
+  r = 0;
+  ts = TI;
+  cs = request = oldclk = waits = touched = cwait = 0;
+  op = next_access(&adr, &idle);
+
+  while (op != 0 || ts != TI) {
+    /* CTTL rises: the next T state.
+     */
+    switch (ts) {
+      case TI:
+	if (idle > 0) --idle;
+	else ts = T1;
+	break;
+      case T1:
+	ts = T2;
+	break;
+      case T2:
+	ts = T3;
+	break;
+      case T3:
+      case TW:
+	if (!cwait) ts = T4;
+	else if (ts = TW, ++waits > MAXWAIT) {
+	  fprintf(stderr, "dramsim: bus hung at %08lx after %ld clocks\n",
+	    adr, clocks);
+	  exit(1);
+	}
+	break;
+      case T4:
+	if (cs) {
+	  if (op == 'r') ++dreads, rwaits += waits;
+	  else ++dwrites, wwaits += waits;
+	  if (waits > maxwait) maxwait = waits;
+	  ++hist[waits];
+	  collisions += touched;
+	}
+	if (op == 'r') ++reads;
+	else ++writes;
+	op = next_access(&adr, &idle);
+	ts = (op != 0 && idle == 0)? T1: TI;
+	if (idle > 0) --idle;
+	break;
+    }
+    if (op == 0 && ts == TI) break;
+    if (ts == T1) {			/* address latched and decoded */
+      cs = is_dram(adr);
+      waits = touched = 0;
+    }
+    ++clocks;
+    if (ts != TI) ++busclocks;
+
+    /* rfshpal counts on CTTL.  The 8419 asks for refresh on each rising
+     * edge of its output.
+     */
+    r = pal_clock(&rfsh, r);
+    rfclk = !GET(r, p_q7);
+    if (rfclk && !oldclk) request = 1;
+    oldclk = rfclk;
+
+    /* The two halves of the T state, each ending with an FCLK edge.
+     */
+    for (i = 1; i >= 0; --i) {
+      v = pal_comb(&dramc, inputs(v, ts, i, op, cs, request));
+      if (verbose > 0) {
+	--verbose;
+	printf("%6ld %s %s  %s%s%s%s%s%s%s\n", clocks, tname[ts],
+	  i? "hi": "lo", GET(v, p_ads)? "ADS ": "", GET(v, p_tso)? "TSO ": "",
+	  GET(v, p_cs)? "CS ": "", request? "RFRQ ": "",
+	  GET(v, p_mode)? "MODE ": "", GET(v, p_rasin)? "RASIN ": "",
+	  GET(v, p_cwait)? "CWAIT": "");
+      }
+      if (GET(v, p_mode)) {
+	if (request) ++refreshes;
+	request = 0;
+	if (ts != TI && cs) touched = 1;
+      }
+      cwait = GET(v, p_cwait);		/* as the TCU sees it at the edge */
+      v = pal_clock(&dramc, v);
+    }
+  }
+  report(mhz);
+  exit(0);
+}
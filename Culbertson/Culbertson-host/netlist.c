@@ -0,0 +1,389 @@
+/* Board netlists: reading, and finding parts, nets and pins.
+ *
+ * The triples file is read a line at a time:
+ *
+ *	part	pin	net	[! comment]
+ *
+ * The KiCad export is read a tag at a time, taking only the <comp> and
+ * <value> tags of the components and the <net> and <node> tags of the
+ * nets.  Neither file is held in memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "netlist.h"
+
+#define MAXLINE		512
+#define FIRSTHASH	1024		/* power of 2 */
+
+char nl_error[MAXLINE + 80];
+
+static char *
+save(s)
+char *s;
+{
+  char *p;
+
+  if ((p = malloc(strlen(s) + 1)) != NULL) strcpy(p, s);
+  return p;
+}
+
+static void *
+grow(p, max, size)
+void *p;
+int *max, size;
+{
+  *max = (*max == 0)? 64: *max * 2;
+  return realloc(p, (long)*max * size);
+}
+
+static unsigned
+hash(s)
+char *s;
+{
+  unsigned h = 0;
+
+  while (*s) h = h * 31 + tolower((unsigned char)*s++);
+  return h;
+}
+
+static int
+same(a, b)
+char *a, *b;
+{
+  while (*a && tolower((unsigned char)*a) == tolower((unsigned char)*b))
+    ++a, ++b;
+  return *a == '\0' && *b == '\0';
+}
+
+/* Slot in table h (parts or nets) for name: where it is, or the empty
+ * slot where it would go.
+ */
+static int
+slot(nl, h, name, isnet)
+struct netlist *nl;
+int *h, isnet;
+char *name;
+{
+  int i, k;
+
+  for (i = hash(name) & (nl->hsize - 1); (k = h[i]) >= 0;
+    i = (i + 1) & (nl->hsize - 1))
+    if (same(isnet? nl->net[k].name: nl->part[k].name, name)) break;
+  return i;
+}
+
+/* Double the hash tables when half full.
+ */
+static int
+rehash(nl)
+struct netlist *nl;
+{
+  int i;
+
+  if (2 * (nl->nparts + 1) < nl->hsize && 2 * (nl->nnets + 1) < nl->hsize)
+    return 0;
+  nl->hsize = (nl->hsize == 0)? FIRSTHASH: nl->hsize * 2;
+  free(nl->phash);
+  free(nl->nhash);
+  nl->phash = (int *)malloc(nl->hsize * sizeof(int));
+  nl->nhash = (int *)malloc(nl->hsize * sizeof(int));
+  if (nl->phash == NULL || nl->nhash == NULL) return -1;
+  for (i = 0; i < nl->hsize; ++i) nl->phash[i] = nl->nhash[i] = -1;
+  for (i = 0; i < nl->nparts; ++i)
+    nl->phash[slot(nl, nl->phash, nl->part[i].name, 0)] = i;
+  for (i = 0; i < nl->nnets; ++i)
+    nl->nhash[slot(nl, nl->nhash, nl->net[i].name, 1)] = i;
+  return 0;
+}
+
+int
+nl_part(nl, name)
+struct netlist *nl;
+char *name;
+{
+  return nl->phash[slot(nl, nl->phash, name, 0)];
+}
+
+int
+nl_net(nl, name)
+struct netlist *nl;
+char *name;
+{
+  return nl->nhash[slot(nl, nl->nhash, name, 1)];
+}
+
+int
+nl_pin(nl, part, pin)
+struct netlist *nl;
+int part, pin;
+{
+  struct nl_part *p = &nl->part[part];
+
+  return (pin >= 0 && pin < p->npin)? p->node[pin]: -1;
+}
+
+/* Part or net called name, made if new.  Return its index, or -1 if
+ * out of memory.
+ */
+static int
+add_part(nl, name)
+struct netlist *nl;
+char *name;
+{
+  struct nl_part *p;
+  int k;
+
+  if ((k = nl_part(nl, name)) >= 0) return k;
+  if (rehash(nl) < 0) return -1;
+  if (nl->nparts == nl->maxparts && (nl->part = (struct nl_part *)
+    grow(nl->part, &nl->maxparts, sizeof *nl->part)) == NULL) return -1;
+  p = &nl->part[k = nl->nparts];
+  if ((p->name = save(name)) == NULL) return -1;
+  p->type = NULL;
+  p->npin = 0;
+  p->node = NULL;
+  nl->phash[slot(nl, nl->phash, name, 0)] = k;
+  ++nl->nparts;
+  return k;
+}
+
+static int
+add_net(nl, name)
+struct netlist *nl;
+char *name;
+{
+  struct nl_net *n;
+  int k;
+
+  if ((k = nl_net(nl, name)) >= 0) return k;
+  if (rehash(nl) < 0) return -1;
+  if (nl->nnets == nl->maxnets && (nl->net = (struct nl_net *)
+    grow(nl->net, &nl->maxnets, sizeof *nl->net)) == NULL) return -1;
+  n = &nl->net[k = nl->nnets];
+  if ((n->name = save(name)) == NULL) return -1;
+  n->first = n->last = -1;
+  n->count = 0;
+  nl->nhash[slot(nl, nl->nhash, name, 1)] = k;
+  ++nl->nnets;
+  return k;
+}
+
+/* Connect pin of part to net, which is NL_NC for no connection.  A pin
+ * given twice is counted as bad and keeps its first net.  Return -1 if
+ * out of memory.
+ */
+static int
+add_node(nl, part, pin, net, note, line)
+struct netlist *nl;
+char *part, *pin, *net, *note;
+int line;
+{
+  struct nl_part *p;
+  struct nl_node *d;
+  int k, n, num;
+  char *end;
+
+  num = strtol(pin, &end, 10);
+  if (*pin == '\0' || *end != '\0' || num < 0 || *net == '\0') {
+    if (nl->nbad++ == 0) nl->badline = line;
+    return 0;
+  }
+  if ((k = add_part(nl, part)) < 0) return -1;
+  if (same(net, NL_NC)) n = -1;
+  else if ((n = add_net(nl, net)) < 0) return -1;
+  p = &nl->part[k];
+  if (num >= p->npin) {
+    int i, old = p->npin;
+
+    p->npin = num + 8;
+    if ((p->node = (int *)realloc(p->node, p->npin * sizeof(int))) == NULL)
+      return -1;
+    for (i = old; i < p->npin; ++i) p->node[i] = -1;
+  }
+  if (p->node[num] >= 0) {
+    if (nl->nbad++ == 0) nl->badline = line;
+    return 0;
+  }
+  if (nl->nnodes == nl->maxnodes && (nl->node = (struct nl_node *)
+    grow(nl->node, &nl->maxnodes, sizeof *nl->node)) == NULL) return -1;
+  d = &nl->node[p->node[num] = nl->nnodes++];
+  d->part = k;
+  d->pin = num;
+  d->net = n;
+  d->note = (note != NULL && *note != '\0')? save(note): NULL;
+  d->next = -1;
+  if (n >= 0) {				/* keep nets in file order */
+    if (nl->net[n].last < 0) nl->net[n].first = d - nl->node;
+    else nl->node[nl->net[n].last].next = d - nl->node;
+    nl->net[n].last = d - nl->node;
+    ++nl->net[n].count;
+  }
+  return 0;
+}
+
+/* Triples, one to a line.
+ */
+static int
+read_triples(nl, f)
+struct netlist *nl;
+FILE *f;
+{
+  char line[MAXLINE], part[MAXLINE], pin[MAXLINE], net[MAXLINE], *note;
+  int lineno = 0;
+
+  while (fgets(line, sizeof line, f) != NULL) {
+    ++lineno;
+    line[strcspn(line, "\r\n")] = '\0';
+    if ((note = strchr(line, '!')) != NULL) {
+      *note++ = '\0';
+      while (isspace((unsigned char)*note)) ++note;
+    }
+    part[0] = pin[0] = net[0] = '\0';
+    if (sscanf(line, "%s %s %s", part, pin, net) <= 0) continue;
+    if (add_node(nl, part, pin, net, note, lineno) < 0) return -1;
+  }
+  return 0;
+}
+
+/* Attribute name of a tag, entities replaced, into out.
+ */
+static int
+attr(tag, name, out)
+char *tag, *name, *out;
+{
+  static struct {
+    char *ent;
+    char c;
+  } ents[] = {{"&lt;", '<'}, {"&gt;", '>'}, {"&amp;", '&'}, {"&quot;", '"'},
+    {"&apos;", '\''}};
+  char *p;
+  int i, len = strlen(name);
+
+  for (p = tag; (p = strstr(p, name)) != NULL; p += len)
+    if (isspace((unsigned char)p[-1]) && p[len] == '=' && p[len + 1] == '"')
+      break;
+  if (p == NULL) return 0;
+  for (p += len + 2; *p != '\0' && *p != '"'; ) {
+    if (*p == '&') {
+      for (i = 0; i < 5 && strncmp(p, ents[i].ent, strlen(ents[i].ent)); ++i);
+      if (i < 5) {
+	*out++ = ents[i].c;
+	p += strlen(ents[i].ent);
+	continue;
+      }
+    }
+    *out++ = *p++;
+  }
+  *out = '\0';
+  return 1;
+}
+
+/* The KiCad export.  text holds what came before each tag.
+ */
+static int
+read_xml(nl, f)
+struct netlist *nl;
+FILE *f;
+{
+  char tag[MAXLINE], text[MAXLINE], ref[MAXLINE], pin[MAXLINE];
+  char net[MAXLINE];
+  int c, n, t, lineno = 1, comp = -1, value = 0;
+
+  net[0] = '\0';
+  for (;;) {
+    for (t = 0; (c = getc(f)) != EOF && c != '<'; ) {
+      if (c == '\n') ++lineno;
+      if (t < MAXLINE - 1) text[t++] = c;
+    }
+    text[t] = '\0';
+    if (c == EOF) break;
+    for (n = 0; (c = getc(f)) != EOF && c != '>'; ) {
+      if (c == '\n') ++lineno, c = ' ';
+      if (n < MAXLINE - 1) tag[n++] = c;
+    }
+    tag[n] = '\0';
+    if (value && comp >= 0 && strncmp(tag, "/value", 6) == 0 &&
+      nl->part[comp].type == NULL) {
+      if ((nl->part[comp].type = save(text)) == NULL) return -1;
+    }
+    value = (strncmp(tag, "value", 5) == 0);
+    if (strncmp(tag, "comp ", 5) == 0 && attr(tag, "ref", ref)) {
+      if ((comp = add_part(nl, ref)) < 0) return -1;
+    } else if (strcmp(tag, "/comp") == 0) comp = -1;
+    else if (strncmp(tag, "net ", 4) == 0) {
+      if (!attr(tag, "name", net)) net[0] = '\0';
+    } else if (strcmp(tag, "/net") == 0) net[0] = '\0';
+    else if (strncmp(tag, "node ", 5) == 0 && attr(tag, "ref", ref) &&
+      attr(tag, "pin", pin)) {
+      if (add_node(nl, ref, pin, net, (char *)0, lineno) < 0) return -1;
+    }
+  }
+  return 0;
+}
+
+/* Read a netlist of either kind.  Return NULL with the reason in
+ * nl_error if it cannot be read at all; lines not understood are only
+ * counted.
+ */
+struct netlist *
+nl_read(file)
+char *file;
+{
+  struct netlist *nl;
+  FILE *f;
+  int c, ret;
+
+  if ((f = fopen(file, "r")) == NULL) {
+    sprintf(nl_error, "%s: cannot open", file);
+    return NULL;
+  }
+  if ((nl = (struct netlist *)calloc(1, sizeof *nl)) == NULL ||
+    (nl->file = save(file)) == NULL || rehash(nl) < 0) {
+    sprintf(nl_error, "%s: out of memory", file);
+    fclose(f);
+    return NULL;
+  }
+  while ((c = getc(f)) != EOF && isspace(c));
+  ungetc(c, f);
+  nl->xml = (c == '<');
+  ret = nl->xml? read_xml(nl, f): read_triples(nl, f);
+  fclose(f);
+  if (ret < 0) {
+    sprintf(nl_error, "%s: out of memory", file);
+    return NULL;
+  }
+  return nl;
+}
+
+/* Part types from a parts list: part, type, and maybe ! comment.  A
+ * part not in the netlist is added with no pins.
+ */
+int
+nl_types(nl, file)
+struct netlist *nl;
+char *file;
+{
+  char line[MAXLINE], part[MAXLINE], type[MAXLINE], *p;
+  FILE *f;
+  int k;
+
+  if ((f = fopen(file, "r")) == NULL) {
+    sprintf(nl_error, "%s: cannot open", file);
+    return -1;
+  }
+  while (fgets(line, sizeof line, f) != NULL) {
+    if ((p = strchr(line, '!')) != NULL) *p = '\0';
+    if (sscanf(line, "%s %s", part, type) != 2) continue;
+    if ((k = add_part(nl, part)) < 0 ||
+      (nl->part[k].type = save(type)) == NULL) {
+      sprintf(nl_error, "%s: out of memory", file);
+      fclose(f);
+      return -1;
+    }
+  }
+  fclose(f);
+  return 0;
+}
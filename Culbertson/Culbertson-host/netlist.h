@@ -0,0 +1,51 @@
+/* Board netlists.
+ *
+ * Either the part/pin/net triples of Culbertson-32016/netlist, with the
+ * part types from its partlist, or a KiCad XML netlist export.  Parts
+ * and nets are kept once each, found by name through hash tables, and
+ * nodes (one per connected pin) are found by part and pin number
+ * through a table per part.  Names are looked up without regard to
+ * case, since the two sources disagree on it.
+ */
+
+struct nl_part {
+  char *name;
+  char *type;				/* 74ALS00, or NULL if unknown */
+  int npin;				/* size of node[] */
+  int *node;				/* node of each pin, or -1 */
+};
+
+struct nl_net {
+  char *name;
+  int first, last;			/* nodes, linked through next */
+  int count;
+};
+
+struct nl_node {
+  int part, pin;
+  int net;				/* -1 if marked n/c */
+  int next;				/* next node on the net, or -1 */
+  char *note;				/* ! comment, or NULL */
+};
+
+struct netlist {
+  char *file;
+  int xml;				/* read from a KiCad export */
+  int nparts, nnets, nnodes;
+  struct nl_part *part;
+  struct nl_net *net;
+  struct nl_node *node;
+  int nbad, badline;			/* lines not understood, first */
+  int maxparts, maxnets, maxnodes;	/* allocated */
+  int hsize, *phash, *nhash;		/* name to index, -1 empty */
+};
+
+#define NL_NC		"n/c"		/* net of unconnected pins */
+
+extern char nl_error[];			/* why nl_read() failed */
+
+struct netlist *nl_read();		/* (file): NULL on error */
+int nl_types();				/* (nl, partlist file): 0 or -1 */
+int nl_part();				/* (nl, name): part or -1 */
+int nl_net();				/* (nl, name): net or -1 */
+int nl_pin();				/* (nl, part, pin): node or -1 */
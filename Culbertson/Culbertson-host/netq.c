@@ -0,0 +1,595 @@
+/* Netlist queries.
+ *
+ * Usage: netq [-p <partlist>] <netlist> [net <name> | pin <part>.<pin> |
+ *		part <name> | nets | parts]
+ *	  netq -d [-v | -q] <netlist> <other netlist>
+ *
+ * Either netlist may be the triples of Culbertson-32016 or a KiCad XML
+ * export.  The part types of a triples netlist come from partlist in the
+ * same directory unless -p names another.  With no query, netq says how
+ * big the netlist is.
+ *
+ * -d compares two netlists, which need not use the same part names:
+ * the triples against the XML KiCad exports from its schematic, say.
+ * Parts are paired by the nets on their pins: first by net names, then,
+ * once some parts are paired, by which nets their pins share.  Parts
+ * still unpaired are paired by the shape of the graph around them (see
+ * refine()).  Then every pin of each pair of parts is checked, and the
+ * difference called missing, extra, swapped or moved.  A net of one pin
+ * counts as no connection.  -v also lists the pairs; -q gives only the
+ * counts, and the exit status says whether there were any.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netlist.h"
+
+#define ROUNDS		4		/* of pairing parts and nets */
+#define WL_ROUNDS	4		/* of colour refinement */
+#define BIGNET		16		/* power: too common to tell by */
+
+static void
+usage()
+{
+  fprintf(stderr, "usage: netq [-p partlist] netlist [net name | pin part.pin |\n\
+	part name | nets | parts]\n\
+       netq -d [-v | -q] netlist other\n");
+  exit(2);
+}
+
+static struct netlist *
+load(file, partlist)
+char *file, *partlist;
+{
+  struct netlist *nl;
+  char path[512], *p;
+  FILE *f;
+
+  if ((nl = nl_read(file)) == NULL) {
+    fprintf(stderr, "netq: %s\n", nl_error);
+    exit(1);
+  }
+  if (nl->nbad > 0)
+    fprintf(stderr, "netq: %s: line %d not understood, and %d more\n",
+      file, nl->badline, nl->nbad - 1);
+  if (partlist == NULL && !nl->xml && strlen(file) < sizeof path - 10) {
+    strcpy(path, file);
+    p = strrchr(path, '/');
+    strcpy(p? p + 1: path, "partlist");
+    if ((f = fopen(path, "r")) != NULL) {
+      fclose(f);
+      partlist = path;
+    }
+  }
+  if (partlist != NULL && nl_types(nl, partlist) < 0) {
+    fprintf(stderr, "netq: %s\n", nl_error);
+    exit(1);
+  }
+  return nl;
+}
+
+static char *
+type(nl, part)
+struct netlist *nl;
+int part;
+{
+  return nl->part[part].type? nl->part[part].type: "?";
+}
+
+/* Net of a node as far as connectivity goes: -1 for n/c or alone.
+ */
+static int
+conn(nl, node)
+struct netlist *nl;
+int node;
+{
+  int n;
+
+  if (node < 0 || (n = nl->node[node].net) < 0 || nl->net[n].count < 2)
+    return -1;
+  return n;
+}
+
+/* Queries
+ */
+static void
+show_net(nl, name)
+struct netlist *nl;
+char *name;
+{
+  struct nl_node *d;
+  int n, k;
+
+  if ((n = nl_net(nl, name)) < 0) {
+    printf("no net %s\n", name);
+    return;
+  }
+  printf("%s: %d pins\n", nl->net[n].name, nl->net[n].count);
+  for (k = nl->net[n].first; k >= 0; k = d->next) {
+    d = &nl->node[k];
+    printf("  %s.%d\t%s", nl->part[d->part].name, d->pin, type(nl, d->part));
+    if (d->note) printf("\t! %s", d->note);
+    printf("\n");
+  }
+}
+
+static void
+show_pin(nl, arg)
+struct netlist *nl;
+char *arg;
+{
+  struct nl_node *d;
+  char *dot;
+  int p, k, n;
+
+  if ((dot = strrchr(arg, '.')) == NULL) usage();
+  *dot = '\0';
+  if ((p = nl_part(nl, arg)) < 0) {
+    printf("no part %s\n", arg);
+    return;
+  }
+  if ((k = nl_pin(nl, p, atoi(dot + 1))) < 0) {
+    printf("%s.%s is not in the netlist\n", arg, dot + 1);
+    return;
+  }
+  d = &nl->node[k];
+  if ((n = d->net) < 0) {
+    printf("%s.%d is not connected%s%s\n", nl->part[p].name, d->pin,
+      d->note? "\t! ": "", d->note? d->note: "");
+    return;
+  }
+  printf("%s.%d is on %s%s%s\n", nl->part[p].name, d->pin, nl->net[n].name,
+    d->note? "\t! ": "", d->note? d->note: "");
+  for (k = nl->net[n].first; k >= 0; k = nl->node[k].next)
+    if (&nl->node[k] != d)
+      printf("  %s.%d\t%s\n", nl->part[nl->node[k].part].name,
+	nl->node[k].pin, type(nl, nl->node[k].part));
+}
+
+static void
+show_part(nl, name)
+struct netlist *nl;
+char *name;
+{
+  struct nl_part *p;
+  int k, i;
+
+  if ((k = nl_part(nl, name)) < 0) {
+    printf("no part %s\n", name);
+    return;
+  }
+  p = &nl->part[k];
+  printf("%s: %s\n", p->name, type(nl, k));
+  for (i = 0; i < p->npin; ++i) {
+    if (p->node[i] < 0) continue;
+    if (nl->node[p->node[i]].net < 0) printf("  %3d\t%s\n", i, NL_NC);
+    else printf("  %3d\t%s\t(%d)\n", i,
+      nl->net[nl->node[p->node[i]].net].name,
+      nl->net[nl->node[p->node[i]].net].count - 1);
+  }
+}
+
+/* Comparison.  pmap and nmap pair parts and nets of a with b.
+ */
+static struct netlist *a, *b;
+static int *pmap, *pback, *nmap, *votes;
+
+/* Pair nets: each net of a with the net of b holding most of the pins
+ * of paired parts, if that is at least half of them or it has the same
+ * name.  Before any part is paired, by name.
+ */
+static void
+pair_nets(named)
+int named;
+{
+  int n, k, d, m, best, most, total, same;
+
+  for (m = 0; m < b->nnets; ++m) votes[m] = 0;
+  for (n = 0; n < a->nnets; ++n) {
+    nmap[n] = -1;
+    if (named) {
+      if ((m = nl_net(b, a->net[n].name)) >= 0 && b->net[m].count > 1)
+	nmap[n] = m;
+      continue;
+    }
+    best = -1;
+    most = total = 0;
+    for (k = a->net[n].first; k >= 0; k = a->node[k].next) {
+      if (pmap[a->node[k].part] < 0) continue;
+      ++total;
+      d = nl_pin(b, pmap[a->node[k].part], a->node[k].pin);
+      if ((m = conn(b, d)) >= 0 && ++votes[m] > most) {
+	most = votes[m];
+	best = m;
+      }
+    }
+    if ((same = nl_net(b, a->net[n].name)) >= 0 && best >= 0 &&
+      votes[same] == most) best = same;	/* a tie goes to the name */
+    for (k = a->net[n].first; k >= 0; k = a->node[k].next)
+      if (pmap[a->node[k].part] >= 0) {
+	d = nl_pin(b, pmap[a->node[k].part], a->node[k].pin);
+	if ((m = conn(b, d)) >= 0) votes[m] = 0;
+      }
+    if (best >= 0 && (2 * most >= total || best == same)) nmap[n] = best;
+  }
+}
+
+/* Pair parts: each part of a with the part of b whose pins are on the
+ * paired nets most often, best pairs first.  More than half the pins
+ * must agree, so that a two pin part is not paired by its ground pin.
+ * keep: add to the pairs already made rather than start again.
+ */
+struct cand {
+  int votes, pa, pb;
+};
+
+static int
+by_votes(x, y)
+struct cand *x, *y;
+{
+  return y->votes - x->votes;
+}
+
+static void
+pair_parts(keep)
+int keep;
+{
+  static struct cand *c;
+  static int maxc, *seen;
+  int nc = 0, p, i, j, m, e, q, pins, nseen;
+
+  if (seen == NULL && (seen = (int *)malloc(b->nparts * sizeof(int))) == NULL)
+    goto nomem;
+  for (p = 0; p < a->nparts; ++p) {
+    for (i = pins = nseen = 0; i < a->part[p].npin; ++i) {
+      if ((m = conn(a, a->part[p].node[i])) < 0) continue;
+      ++pins;
+      if ((m = nmap[m]) < 0) continue;
+      for (e = b->net[m].first; e >= 0; e = b->node[e].next)
+	if (b->node[e].pin == i && votes[q = b->node[e].part]++ == 0)
+	  seen[nseen++] = q;
+    }
+    for (j = 0; j < nseen; ++j) {
+      q = seen[j];
+      if (2 * votes[q] > pins) {
+	if (nc == maxc) {
+	  maxc = maxc? 2 * maxc: 256;
+	  if ((c = (struct cand *)realloc(c, maxc * sizeof *c)) == NULL)
+	    goto nomem;
+	}
+	c[nc].votes = votes[q];
+	c[nc].pa = p;
+	c[nc++].pb = q;
+      }
+      votes[q] = 0;
+    }
+  }
+  qsort(c, nc, sizeof *c, by_votes);
+  for (p = 0; p < a->nparts && !keep; ++p) pmap[p] = -1;
+  for (p = 0; p < b->nparts && !keep; ++p) pback[p] = -1;
+  for (i = 0; i < nc; ++i)
+    if (pmap[c[i].pa] < 0 && pback[c[i].pb] < 0) {
+      pmap[c[i].pa] = c[i].pb;
+      pback[c[i].pb] = c[i].pa;
+    }
+  return;
+nomem:
+  fprintf(stderr, "netq: out of memory\n");
+  exit(1);
+}
+
+/* Colour refinement, for the parts voting cannot pair: those on nets
+ * named only in one list, like the Net-(...) nets of KiCad.  Nets named
+ * in both lists, and power nets, are fixed colours.  Each round a part
+ * takes its colour from the colours of the nets on its pins, with the
+ * pin numbers, and a net from the colours of the parts on it.  Parts
+ * whose colour is unique in both lists are the same part.
+ */
+static unsigned long
+mix(x)
+unsigned long x;
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdUL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53UL;
+  return x ^ x >> 33;
+}
+
+static unsigned long
+name_colour(s)
+char *s;
+{
+  unsigned long h = 0;
+
+  for (; *s; ++s) h = h * 131 + (*s >= 'A' && *s <= 'Z'? *s - 'A' + 'a': *s);
+  return mix(h);
+}
+
+/* Part colours after each round: pc[r * nparts + part].
+ */
+static unsigned long *
+refine(nl, other)
+struct netlist *nl, *other;
+{
+  unsigned long *pc, *nc, *nn, *t, h;
+  int r, p, n, i, k, m;
+  char *fixed;
+
+  pc = (unsigned long *)malloc((WL_ROUNDS + 1) * nl->nparts * sizeof *pc);
+  nc = (unsigned long *)malloc(nl->nnets * sizeof *nc);
+  nn = (unsigned long *)malloc(nl->nnets * sizeof *nn);
+  fixed = malloc(nl->nnets + 1);
+  if (!pc || !nc || !nn || !fixed) {
+    fprintf(stderr, "netq: out of memory\n");
+    exit(1);
+  }
+  for (n = 0; n < nl->nnets; ++n) {
+    if (nl_net(other, nl->net[n].name) >= 0)
+      nc[n] = name_colour(nl->net[n].name);
+    else if (nl->net[n].count > BIGNET) nc[n] = mix(BIGNET);
+    else nc[n] = mix(0);
+    fixed[n] = nl_net(other, nl->net[n].name) >= 0 ||
+      nl->net[n].count > BIGNET;
+  }
+  for (p = 0; p < nl->nparts; ++p) {
+    for (h = i = 0; i < nl->part[p].npin; ++i)
+      h += conn(nl, nl->part[p].node[i]) >= 0;
+    pc[p] = mix(h);
+  }
+  for (r = 1; r <= WL_ROUNDS; ++r) {
+    for (p = 0; p < nl->nparts; ++p) {
+      h = pc[(r - 1) * nl->nparts + p];
+      for (i = 0; i < nl->part[p].npin; ++i)
+	if ((m = conn(nl, nl->part[p].node[i])) >= 0)
+	  h += mix(mix(i + 1) ^ nc[m]);
+      pc[r * nl->nparts + p] = mix(h);
+    }
+    for (n = 0; n < nl->nnets; ++n) {
+      if (fixed[n]) {
+	nn[n] = nc[n];
+	continue;
+      }
+      for (h = nc[n], k = nl->net[n].first; k >= 0; k = nl->node[k].next)
+	h += mix(mix(nl->node[k].pin + 1) ^
+	  pc[r * nl->nparts + nl->node[k].part]);
+      nn[n] = mix(h);
+    }
+    t = nc, nc = nn, nn = t;
+  }
+  free(nc);
+  free(nn);
+  free(fixed);
+  return pc;
+}
+
+static int *by_colour;			/* pairs made by pair_colours() */
+
+static int
+pair_colours()
+{
+  unsigned long *ca, *cb, c;
+  int r, p, q, i, na, nb, paired = 0;
+
+  ca = refine(a, b);
+  cb = refine(b, a);
+  for (r = WL_ROUNDS; r > 0; --r)
+    for (p = 0; p < a->nparts; ++p) {
+      if (pmap[p] >= 0) continue;
+      c = ca[r * a->nparts + p];
+      for (na = i = 0; i < a->nparts; ++i)
+	na += (pmap[i] < 0 && ca[r * a->nparts + i] == c);
+      for (nb = i = 0, q = -1; i < b->nparts; ++i)
+	if (pback[i] < 0 && cb[r * b->nparts + i] == c) ++nb, q = i;
+      if (na == 1 && nb == 1) {
+	pmap[p] = q;
+	pback[q] = p;
+	by_colour[p] = 1;
+	++paired;
+      }
+    }
+
+  /* Parts still alike after every round, like two bypass capacitors on
+   * the same nets, can be paired in either order.
+   */
+  r = WL_ROUNDS;
+  for (p = 0; p < a->nparts; ++p) {
+    if (pmap[p] >= 0) continue;
+    c = ca[r * a->nparts + p];
+    for (na = i = 0; i < a->nparts; ++i)
+      na += (pmap[i] < 0 && ca[r * a->nparts + i] == c);
+    for (nb = i = 0, q = -1; i < b->nparts; ++i)
+      if (pback[i] < 0 && cb[r * b->nparts + i] == c && nb++ == 0) q = i;
+    if (na == nb && na > 1) {
+      pmap[p] = q;
+      pback[q] = p;
+      by_colour[p] = 1;
+      ++paired;
+    }
+  }
+  free(ca);
+  free(cb);
+  return paired;
+}
+
+/* Colours can agree by chance when the lists differ near a part.  Undo
+ * a pair made by colour unless, with the nets paired again, more than
+ * half of its pins agree.  Return how many are left.
+ */
+static int
+check_colours()
+{
+  int p, q, i, ma, mb, pins, agree, left = 0;
+
+  for (p = 0; p < a->nparts; ++p) {
+    if (!by_colour[p] || (q = pmap[p]) < 0) continue;
+    for (pins = agree = i = 0; i < a->part[p].npin; ++i) {
+      if ((ma = conn(a, nl_pin(a, p, i))) < 0) continue;
+      ++pins;
+      mb = conn(b, nl_pin(b, q, i));
+      agree += (nmap[ma] == mb);
+    }
+    if (2 * agree > pins) {
+      ++left;
+      continue;
+    }
+    pmap[p] = pback[q] = -1;
+    by_colour[p] = 0;
+  }
+  return left;
+}
+
+/* Kinds of difference on a pin of a pair of parts
+ */
+#define D_SAME		0
+#define D_MISSING	1		/* connected in a, not in b */
+#define D_EXTRA		2		/* connected in b, not in a */
+#define D_SWAPPED	3		/* with another pin of the part */
+#define D_MOVED		4		/* to another net */
+static char *dname[] = {"", "missing", "extra", "swapped", "moved"};
+
+static int
+compare(verbose, quiet)
+int verbose, quiet;
+{
+  int p, q, i, j, n, m, npin, only, maxpin, *ma, *mb, *kind;
+  long count[5];
+
+  pmap = (int *)malloc(a->nparts * sizeof(int));
+  pback = (int *)malloc(b->nparts * sizeof(int));
+  nmap = (int *)malloc(a->nnets * sizeof(int));
+  votes = (int *)calloc(b->nnets + b->nparts, sizeof(int));
+  by_colour = (int *)calloc(a->nparts + 1, sizeof(int));
+  for (maxpin = p = 0; p < a->nparts; ++p)
+    if (a->part[p].npin > maxpin) maxpin = a->part[p].npin;
+  for (p = 0; p < b->nparts; ++p)
+    if (b->part[p].npin > maxpin) maxpin = b->part[p].npin;
+  ma = (int *)malloc((maxpin + 1) * sizeof(int));
+  mb = (int *)malloc((maxpin + 1) * sizeof(int));
+  kind = (int *)malloc((maxpin + 1) * sizeof(int));
+  if (!pmap || !pback || !nmap || !votes || !by_colour || !ma || !mb ||
+    !kind) {
+    fprintf(stderr, "netq: out of memory\n");
+    exit(1);
+  }
+  pair_nets(1);
+  for (i = 0; i < ROUNDS; ++i) {
+    pair_parts(0);
+    pair_nets(0);
+  }
+  for (i = 0; i < ROUNDS && pair_colours() > 0; ++i) {
+    pair_nets(0);
+    check_colours();
+    pair_nets(0);
+    pair_parts(1);
+    pair_nets(0);
+  }
+
+  if (verbose)
+    for (p = 0; p < a->nparts; ++p)
+      if (pmap[p] >= 0)
+	printf("%-16s %-16s %s\n", a->part[p].name, b->part[pmap[p]].name,
+	  type(b, pmap[p]));
+  for (only = p = 0; p < a->nparts && !quiet; ++p)
+    if (pmap[p] < 0) {
+      if (only++ == 0) printf("parts only in %s:\n", a->file);
+      printf("  %s\t%s\n", a->part[p].name, type(a, p));
+    }
+  for (only = p = 0; p < b->nparts && !quiet; ++p)
+    if (pback[p] < 0) {
+      if (only++ == 0) printf("parts only in %s:\n", b->file);
+      printf("  %s\t%s\n", b->part[p].name, type(b, p));
+    }
+
+  /* Every pin of every pair.  Two pins whose nets are exchanged are a
+   * swap rather than two moves.
+   */
+  for (i = 0; i < 5; ++i) count[i] = 0;
+  for (only = p = 0; p < a->nparts; ++p) {
+    if ((q = pmap[p]) < 0) continue;
+    npin = a->part[p].npin > b->part[q].npin? a->part[p].npin:
+      b->part[q].npin;
+    for (i = 0; i < npin; ++i) {
+      ma[i] = conn(a, nl_pin(a, p, i));
+      mb[i] = conn(b, nl_pin(b, q, i));
+      if ((ma[i] < 0 && mb[i] < 0) || (ma[i] >= 0 && nmap[ma[i]] == mb[i]))
+	kind[i] = D_SAME;
+      else if (mb[i] < 0) kind[i] = D_MISSING;
+      else if (ma[i] < 0) kind[i] = D_EXTRA;
+      else kind[i] = D_MOVED;
+    }
+    for (i = 0; i < npin; ++i)
+      for (j = i + 1; kind[i] == D_MOVED && j < npin; ++j)
+	if (kind[j] == D_MOVED && nmap[ma[i]] == mb[j] &&
+	  nmap[ma[j]] == mb[i]) kind[i] = kind[j] = D_SWAPPED;
+    for (i = 0; i < npin; ++i) {
+      if (kind[i] == D_SAME) continue;
+      ++count[kind[i]];
+      if (quiet) continue;
+      if (only++ == 0) printf("pins which differ:\n");
+      printf("  %-8s %s.%d %s\t%s.%d %s\n", dname[kind[i]], a->part[p].name,
+	i, (ma[i] >= 0)? a->net[ma[i]].name: NL_NC, b->part[q].name, i,
+	(mb[i] >= 0)? b->net[mb[i]].name: NL_NC);
+    }
+  }
+
+  /* Nets paired but named differently.  A KiCad net named for one of
+   * its pins, Net-(...), has no name to compare.
+   */
+  for (only = n = 0; n < a->nnets && !quiet; ++n) {
+    if ((m = nmap[n]) < 0 || nl_net(b, a->net[n].name) == m ||
+      strncmp(b->net[m].name, "Net-(", 5) == 0) continue;
+    if (only++ == 0) printf("nets named differently:\n");
+    printf("  %s\t%s\n", a->net[n].name, b->net[m].name);
+  }
+  for (n = p = 0; p < a->nparts; ++p) n += (pmap[p] >= 0);
+  printf("%d parts paired; pins %ld missing, %ld extra, %ld swapped, %ld moved\n",
+    n, count[D_MISSING], count[D_EXTRA], count[D_SWAPPED], count[D_MOVED]);
+  for (i = 1; i < 5 && count[i] == 0; ++i);
+  return i < 5;
+}
+
+int
+main(argc, argv)
+int argc;
+char **argv;
+{
+  char *partlist = NULL, *file = NULL, *other = NULL, *cmd = NULL, *arg = NULL;
+  int i, diff = 0, verbose = 0, quiet = 0, n;
+  struct netlist *nl;
+
+  for (i = 1; i < argc && argv[i][0] == '-'; ++i) {
+    if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) partlist = argv[++i];
+    else if (strcmp(argv[i], "-d") == 0) diff = 1;
+    else if (strcmp(argv[i], "-v") == 0) verbose = 1;
+    else if (strcmp(argv[i], "-q") == 0) quiet = 1;
+    else usage();
+  }
+  if (i < argc) file = argv[i++];	/* names after may start with - */
+  if (diff && i < argc) other = argv[i++];
+  if (i < argc) cmd = argv[i++];
+  if (i < argc) arg = argv[i++];
+  if (i < argc) usage();
+  if (file == NULL || (diff && other == NULL)) usage();
+  if (diff) {
+    a = load(file, partlist);
+    b = load(other, (char *)0);
+    exit(compare(verbose, quiet));
+  }
+  nl = load(file, partlist);
+  if (cmd == NULL)
+    printf("%s: %d parts, %d nets, %d pins\n", file, nl->nparts, nl->nnets,
+      nl->nnodes);
+  else if (strcmp(cmd, "net") == 0 && arg) show_net(nl, arg);
+  else if (strcmp(cmd, "pin") == 0 && arg) show_pin(nl, arg);
+  else if (strcmp(cmd, "part") == 0 && arg) show_part(nl, arg);
+  else if (strcmp(cmd, "nets") == 0)
+    for (n = 0; n < nl->nnets; ++n)
+      printf("%s\t%d\n", nl->net[n].name, nl->net[n].count);
+  else if (strcmp(cmd, "parts") == 0)
+    for (n = 0; n < nl->nparts; ++n)
+      printf("%s\t%s\n", nl->part[n].name, type(nl, n));
+  else usage();
+  exit(0);
+}
@@ -0,0 +1,473 @@
+/* PAL design files.
+ *
+ * Reader and evaluator for the PALASM style sources in Culbertson-32016.
+ * Equations are sums of products of pin names, each name optionally
+ * preceded by / for its inverse:
+ *
+ *	NAME := term + term ...		registered, loaded on the clock
+ *	NAME = term + term ...		combinational
+ *	IF (term) NAME = ...		three-state, driven while term is true
+ *
+ * A term is names joined by *.  Comments run from ; to the end of the
+ * line.  An equation ends where the next name is not joined to it by *
+ * or +, so no terminator is needed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "pal.h"
+
+#define T_FALSE		(1UL << 31)	/* in on and off: never true */
+#define MAXLINE		256
+
+char pal_error[MAXLINE + 80];
+
+/* Tokens
+ */
+#define K_END		0
+#define K_NAME		1
+#define K_NOT		'/'
+#define K_AND		'*'
+#define K_OR		'+'
+#define K_REG		':'		/* := */
+#define K_EQ		'='
+#define K_LP		'('
+#define K_RP		')'
+
+static FILE *pf;
+static char *pfile, line[MAXLINE], *lp, tok[MAXLINE];
+static int lineno, kind, peeked;
+
+static int
+err(msg)
+char *msg;
+{
+  sprintf(pal_error, "%s: line %d: %s", pfile, lineno, msg);
+  return -1;
+}
+
+/* Next line of the file, or NULL.  Comments are stripped.
+ */
+static char *
+getline1()
+{
+  char *p;
+
+  if (fgets(line, sizeof line, pf) == NULL) return NULL;
+  ++lineno;
+  if ((p = strchr(line, ';')) != NULL) *p = '\0';
+  return lp = line;
+}
+
+/* Read the next token into tok and return its kind.
+ */
+static int
+next()
+{
+  char *q;
+
+  if (peeked) {
+    peeked = 0;
+    return kind;
+  }
+  for (;;) {
+    while (*lp != '\0' && isspace(*lp)) ++lp;
+    if (*lp != '\0') break;
+    if (getline1() == NULL) return kind = K_END;
+  }
+  if (isalnum(*lp) || *lp == '_') {
+    for (q = tok; isalnum(*lp) || *lp == '_'; ++lp)
+      *q++ = toupper(*lp);
+    *q = '\0';
+    return kind = K_NAME;
+  }
+  tok[0] = *lp;
+  tok[1] = '\0';
+  if (*lp == ':' && lp[1] == '=') {
+    lp += 2;
+    return kind = K_REG;
+  }
+  if (strchr("/*+=()", *lp) == NULL) {
+    ++lp;
+    return kind = -1;
+  }
+  return kind = *lp++;
+}
+
+static void
+unget()
+{
+  peeked = 1;
+}
+
+/* Pin of a name, or -1.
+ */
+int
+pal_pin(pal, name)
+struct pal *pal;
+char *name;
+{
+  int i;
+
+  for (i = 0; i < PAL_PINS; ++i)
+    if (strcmp(pal->name[i], name) == 0) return i;
+  return -1;
+}
+
+/* Read one product term.  Return 0 or -1.
+ */
+static int
+term(pal, t)
+struct pal *pal;
+struct pal_term *t;
+{
+  int neg, pin;
+
+  t->on = t->off = 0;
+  t->non = t->noff = 0;
+  for (;;) {
+    neg = 0;
+    if (next() == K_NOT) {
+      neg = 1;
+      next();
+    }
+    if (kind != K_NAME) return err("name expected");
+    if (strcmp(tok, "VCC") == 0) {
+      if (neg) t->on |= T_FALSE, t->off |= T_FALSE;
+    } else if (strcmp(tok, "GND") == 0) {
+      if (!neg) t->on |= T_FALSE, t->off |= T_FALSE;
+    } else {
+      if ((pin = pal_pin(pal, tok)) < 0) {
+	sprintf(tok + strlen(tok), " is not a pin");
+	return err(tok);
+      }
+      if (neg) {
+	if (!(t->off & PAL_BIT(pin))) t->offpin[t->noff++] = pin;
+	t->off |= PAL_BIT(pin);
+      } else {
+	if (!(t->on & PAL_BIT(pin))) t->onpin[t->non++] = pin;
+	t->on |= PAL_BIT(pin);
+      }
+    }
+    if (next() != K_AND) {
+      unget();
+      return 0;
+    }
+  }
+}
+
+/* Read terms joined by + into t.  Return how many, or -1.
+ */
+static int
+sum(pal, t)
+struct pal *pal;
+struct pal_term *t;
+{
+  int n;
+
+  for (n = 0; ; ) {
+    if (n == PAL_TERMS) return err("too many product terms");
+    if (term(pal, &t[n++]) < 0) return -1;
+    if (next() != K_OR) {
+      unget();
+      return n;
+    }
+  }
+}
+
+/* Registered outputs of a part type, or -1 if we do not know it.
+ */
+static int
+regs_of(type)
+char *type;
+{
+  if (strncmp(type, "PAL16", 5) != 0) return -1;
+  if (type[5] == 'L' && type[6] == '8') return 0;
+  if (type[5] == 'R' && strchr("468", type[6]) && type[6] != '\0')
+    return type[6] - '0';
+  return -1;
+}
+
+/* Can pin be an output of this part, and can it be registered?
+ */
+static int
+out_ok(pal, pin, reg)
+struct pal *pal;
+int pin, reg;
+{
+  int first = 12 + (8 - pal->regs) / 2;	/* first registered pin */
+
+  if (pin < 11 || pin > 18) return 0;	/* pins 12 to 19 */
+  if (!reg) return pal->regs < 8 && (pin + 1 < first ||
+    pin + 1 >= first + pal->regs);
+  return pin + 1 >= first && pin + 1 < first + pal->regs;
+}
+
+/* Copy the names in s to pin names, if there are exactly ten.
+ */
+static int
+pins(s, name)
+char *s;
+char name[][PAL_NAMELEN];
+{
+  char buf[MAXLINE], *p, *q;
+  int i;
+
+  strcpy(buf, s);
+  for (i = 0, p = buf; (q = strtok(p, " \t\r\n")) != NULL; p = NULL, ++i)
+    if (i >= 10 || strlen(q) >= PAL_NAMELEN) return 0;
+  if (i != 10) return 0;
+  strcpy(buf, s);
+  for (i = 0, p = buf; (q = strtok(p, " \t\r\n")) != NULL; p = NULL, ++i)
+    strcpy(name[i], q);
+  return 1;
+}
+
+/* Read a PAL design file.  Return 0, or -1 with the reason in
+ * pal_error.
+ */
+int
+pal_read(pal, file)
+struct pal *pal;
+char *file;
+{
+  char *p, prev[MAXLINE];
+  struct pal_eqn *e;
+  int i, n, nt, ok;
+
+  memset(pal, 0, sizeof *pal);
+  pfile = file;
+  lineno = peeked = 0;
+  if ((pf = fopen(file, "r")) == NULL) {
+    sprintf(pal_error, "%s: cannot open", file);
+    return -1;
+  }
+
+  /* Part type, then title lines until two lines of ten pin names, the
+   * first ending with GND and the second with VCC.
+   */
+  ok = -1;
+  if (getline1() == NULL || sscanf(line, "%15s", pal->type) != 1)
+    goto done;
+  for (p = pal->type; *p != '\0'; ++p) *p = toupper(*p);
+  if ((pal->regs = regs_of(pal->type)) < 0) {
+    err("unknown part type");
+    goto done;
+  }
+  for (n = 0, prev[0] = '\0'; getline1() != NULL; strcpy(prev, line)) {
+    if (pins(line, pal->name[10]) && strcmp(pal->name[19], "VCC") == 0 &&
+      pins(prev, pal->name[0]) && strcmp(pal->name[9], "GND") == 0)
+      break;
+    if (prev[0] != '\0' && n < 4) {
+      prev[strcspn(prev, "\r\n")] = '\0';
+      sprintf(pal->title[n], "%.*s", (int)sizeof pal->title[0] - 1, prev);
+      if (pal->title[n][strspn(pal->title[n], " \t")] != '\0') ++n;
+    }
+  }
+  if (strcmp(pal->name[19], "VCC") != 0) {
+    err("no pin list");
+    goto done;
+  }
+  for (i = 0; i < PAL_PINS; ++i) {
+    p = pal->name[i];
+    if (*p == '/') {
+      pal->low |= PAL_BIT(i);
+      memmove(p, p + 1, strlen(p));
+    }
+    for (; *p != '\0'; ++p) *p = toupper(*p);
+    if (strcmp(pal->name[i], "NC") == 0) pal->name[i][0] = '\0';
+  }
+
+  /* Equations
+   */
+  *lp = '\0';
+  while (next() != K_END) {
+    if (pal->neqn == PAL_PINS) {
+      err("too many equations");
+      goto done;
+    }
+    e = &pal->eqn[pal->neqn];
+    e->line = lineno;
+    if (kind == K_NAME && strcmp(tok, "IF") == 0) {
+      if (next() != K_LP || (e->nen = sum(pal, e->en)) < 0 ||
+	next() != K_RP)
+      {
+	if (e->nen >= 0) err("bad IF");
+	goto done;
+      }
+      next();
+    }
+    if (kind == K_NOT) {
+      e->neg = 1;
+      next();
+    }
+    if (kind != K_NAME || (e->pin = pal_pin(pal, tok)) < 0) {
+      err("output pin expected");
+      goto done;
+    }
+    if (next() != K_REG && kind != K_EQ) {
+      err(":= or = expected");
+      goto done;
+    }
+    e->reg = (kind == K_REG);
+    if (!out_ok(pal, e->pin, e->reg)) {
+      sprintf(tok, "%s cannot be a%s output of a %s", pal->name[e->pin],
+	e->reg? " registered": " combinational", pal->type);
+      err(tok);
+      goto done;
+    }
+    if (pal->outs & PAL_BIT(e->pin)) {
+      err("second equation for an output");
+      goto done;
+    }
+    if ((nt = sum(pal, e->term)) < 0) goto done;
+    e->nterm = nt;
+    pal->outs |= PAL_BIT(e->pin);
+    if (e->reg) pal->regmask |= PAL_BIT(e->pin);
+    ++pal->neqn;
+  }
+  ok = 0;
+done:
+  fclose(pf);
+  if (ok < 0 && pal_error[0] == '\0') err("bad file");
+  return ok;
+}
+
+/* Value of one product term, and of a sum of n of them.
+ */
+int
+pal_termval(t, v)
+struct pal_term *t;
+unsigned long v;
+{
+  return (v & t->on) == t->on && (v & t->off) == 0;
+}
+
+int
+pal_sumval(t, n, v)
+struct pal_term *t;
+int n;
+unsigned long v;
+{
+  while (--n >= 0)
+    if (pal_termval(t++, v)) return 1;
+  return 0;
+}
+
+/* Settle the combinational outputs.  An output not driven keeps the
+ * value given in v, which is what the rest of the board puts on the
+ * pin.  Outputs fed back into themselves, like latches, are evaluated
+ * until they stop changing.
+ */
+unsigned long
+pal_comb(pal, v)
+struct pal *pal;
+unsigned long v;
+{
+  struct pal_eqn *e;
+  unsigned long old;
+  int pass;
+
+  for (pass = 0; pass < PAL_PINS; ++pass) {
+    old = v;
+    for (e = pal->eqn; e < pal->eqn + pal->neqn; ++e) {
+      if (e->reg || (e->nen > 0 && !pal_sumval(e->en, e->nen, v))) continue;
+      if (pal_sumval(e->term, e->nterm, v) != e->neg) v |= PAL_BIT(e->pin);
+      else v &= ~PAL_BIT(e->pin);
+    }
+    if (v == old) break;
+  }
+  return v;
+}
+
+/* Clock the registers on the inputs in v, then settle.
+ */
+unsigned long
+pal_clock(pal, v)
+struct pal *pal;
+unsigned long v;
+{
+  struct pal_eqn *e;
+  unsigned long q = 0;
+
+  for (e = pal->eqn; e < pal->eqn + pal->neqn; ++e)
+    if (e->reg && pal_sumval(e->term, e->nterm, v) != e->neg)
+      q |= PAL_BIT(e->pin);
+  return pal_comb(pal, (v & ~pal->regmask) | q);
+}
+
+/* One term over 64 states at once.
+ */
+static pal_word
+term64(t, in)
+struct pal_term *t;
+pal_word *in;
+{
+  pal_word w = ~(pal_word)0;
+  int i;
+
+  if (t->on & T_FALSE) return 0;
+  for (i = 0; i < t->non; ++i) w &= in[t->onpin[i]];
+  for (i = 0; i < t->noff; ++i) w &= ~in[t->offpin[i]];
+  return w;
+}
+
+static pal_word
+sum64(t, n, in)
+struct pal_term *t;
+int n;
+pal_word *in;
+{
+  pal_word w = 0;
+
+  while (--n >= 0) w |= term64(t++, in);
+  return w;
+}
+
+static void
+eval64(pal, in, out, en, regs)
+struct pal *pal;
+pal_word *in, *out, *en;
+int regs;
+{
+  struct pal_eqn *e;
+  int i;
+
+  for (i = 0; i < PAL_PINS; ++i) {
+    out[i] = in[i];
+    en[i] = 0;
+  }
+  for (e = pal->eqn; e < pal->eqn + pal->neqn; ++e) {
+    if (e->reg && !regs) continue;
+    out[e->pin] = sum64(e->term, e->nterm, in);
+    if (e->neg) out[e->pin] = ~out[e->pin];
+    en[e->pin] = (e->nen > 0)? sum64(e->en, e->nen, in): ~(pal_word)0;
+  }
+}
+
+/* Evaluate every equation once for 64 states.  out[pin] is the value
+ * an output is driven to, or would be loaded with on the clock for a
+ * registered output, and en[pin] says where it is driven.  Pins with
+ * no equation keep their input value and are never driven.  Nothing is
+ * settled: a combinational output fed back sees its value from in[].
+ */
+void
+pal_eval64(pal, in, out, en)
+struct pal *pal;
+pal_word *in, *out, *en;
+{
+  eval64(pal, in, out, en, 1);
+}
+
+/* The same for the combinational equations only, for settling between
+ * clocks: registered pins are treated as having no equation.
+ */
+void
+pal_comb64(pal, in, out, en)
+struct pal *pal;
+pal_word *in, *out, *en;
+{
+  eval64(pal, in, out, en, 0);
+}
@@ -0,0 +1,63 @@
+/* PAL design files.
+ *
+ * The PAL sources in Culbertson-32016 are PALASM style: a line naming
+ * the part, title lines, two lines naming pins 1-10 and 11-20, then the
+ * equations.  Signals are kept as asserted/not asserted: a pin named /X
+ * carries X when it is low.  A state is one bit per pin, bit n for pin
+ * n + 1, holding the asserted value of that pin's signal.
+ */
+
+#define PAL_PINS	20
+#define PAL_TERMS	16		/* product terms per output, at most */
+#define PAL_NAMELEN	16
+
+/* A product term is true when every bit of on is set and every bit of
+ * off is clear in the state.  Constants VCC and GND make t_true or
+ * t_false terms.  The same pins are listed in onpin and offpin, for
+ * pal_eval64() to go straight to them.
+ */
+struct pal_term {
+  unsigned long on, off;
+  int non, noff;
+  unsigned char onpin[PAL_PINS], offpin[PAL_PINS];
+};
+
+struct pal_eqn {
+  int pin;				/* output, 0 to 19 */
+  int reg;				/* := rather than = */
+  int neg;				/* written /NAME = ... */
+  int nterm, nen;			/* nen 0: always enabled */
+  struct pal_term term[PAL_TERMS];
+  struct pal_term en[PAL_TERMS];	/* IF (...) */
+  int line;				/* in the source, for messages */
+};
+
+struct pal {
+  char type[PAL_NAMELEN];		/* PAL16R6 etc. */
+  int regs;				/* registered outputs: 0, 4, 6, 8 */
+  char name[PAL_PINS][PAL_NAMELEN];	/* without the / */
+  unsigned long low;			/* pins named /X */
+  unsigned long outs;			/* pins with an equation */
+  unsigned long regmask;		/* pins with a := equation */
+  int neqn;
+  struct pal_eqn eqn[PAL_PINS];
+  char title[4][80];			/* lines after the part */
+};
+
+#define PAL_BIT(pin)	(1UL << (pin))	/* pin 0 to 19 */
+
+/* For pal_eval64(), a word holds one signal in 64 states, state i in
+ * bit i.
+ */
+typedef unsigned long long pal_word;
+
+extern char pal_error[];		/* why pal_read() failed */
+
+int pal_read();				/* (pal, file): 0 or -1 */
+int pal_pin();				/* (pal, name): pin or -1 */
+unsigned long pal_comb();		/* (pal, state): settle = outputs */
+unsigned long pal_clock();		/* (pal, state): after clock edge */
+int pal_termval();			/* (term, state) */
+int pal_sumval();			/* (terms, n, state) */
+void pal_eval64();			/* (pal, in[], out[], en[]) */
+void pal_comb64();			/* the same, = equations only */
@@ -0,0 +1,560 @@
+/* PAL compiler and checker.
+ *
+ * Usage: palc [-t] [-r] [-j] [-e <other pal>] [-i NAME=0|1 ...] <pal>
+ *
+ * With no option, reads the PAL source and tells how full the part is.
+ *
+ *	-t	truth table over every input and fed back output, one line
+ *		per state.  Registered outputs show the value loaded on the
+ *		next clock, three-state outputs Z where they are not driven.
+ *	-e	compare with another PAL over every state: the outputs must
+ *		be driven in the same states and to the same values there.
+ *		Since fed back outputs are inputs too, equal tables mean
+ *		equal state machines.
+ *	-r	state machine: every state of the registers (and of latches
+ *		made of fed back combinational outputs) reachable from power
+ *		up, and any from which power up cannot be reached again.
+ *	-j	JEDEC fuse map for a programmer.
+ *	-i	hold an input at a value, as a jumper would; may be repeated.
+ *
+ * -t and -e evaluate 64 states at a time with pal_eval64(), so even a
+ * PAL with all 16 array inputs in use takes well under a second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pal.h"
+
+#define FUSES		2048		/* PAL16 array: 64 rows of 32 */
+#define COLS		32
+#define MAXSTATE	(1L << PAL_PINS)
+#define STX		'\002'
+#define ETX		'\003'
+
+/* Pins (1 to 20) of the array inputs, true and complement columns in
+ * pairs, left to right.  The registered parts take feedback from all
+ * eight outputs; the 16L8 has no feedback from pins 12 and 19, but
+ * uses pins 1 and 11 as inputs.
+ */
+static int reg_cols[16] = {2, 19, 3, 18, 4, 17, 5, 16, 6, 15, 7, 14, 8, 13, 9, 12};
+static int l8_cols[16] = {2, 1, 3, 18, 4, 17, 5, 16, 6, 15, 7, 14, 8, 13, 9, 11};
+
+static struct pal pal, other;
+static unsigned long fixmask, fixval;
+static int ins[PAL_PINS], nin;		/* pins enumerated */
+
+static void
+usage()
+{
+  fprintf(stderr,
+    "usage: palc [-t] [-r] [-j] [-e other] [-i NAME=0|1 ...] pal\n");
+  exit(2);
+}
+
+static void
+load(p, file)
+struct pal *p;
+char *file;
+{
+  if (pal_read(p, file) < 0) {
+    fprintf(stderr, "palc: %s\n", pal_error);
+    exit(1);
+  }
+}
+
+/* Pins used on the right side of any equation.
+ */
+static unsigned long
+used(p)
+struct pal *p;
+{
+  struct pal_eqn *e;
+  unsigned long u = 0;
+  int i;
+
+  for (e = p->eqn; e < p->eqn + p->neqn; ++e) {
+    for (i = 0; i < e->nterm; ++i) u |= e->term[i].on | e->term[i].off;
+    for (i = 0; i < e->nen; ++i) u |= e->en[i].on | e->en[i].off;
+  }
+  return u & (PAL_BIT(PAL_PINS) - 1);
+}
+
+/* Pins whose value the equations see: named inputs, and outputs which
+ * are fed back.  The clock and output enable of a registered part are
+ * not in the array.
+ */
+static unsigned long
+inputs_of(p)
+struct pal *p;
+{
+  unsigned long m = 0;
+  int i;
+
+  for (i = 0; i < PAL_PINS; ++i) {
+    if (p->name[i][0] == '\0' || strcmp(p->name[i], "VCC") == 0 ||
+      strcmp(p->name[i], "GND") == 0) continue;
+    if (p->regs > 0 && (i == 0 || i == 10)) continue;
+    if ((p->outs & PAL_BIT(i)) && !(p->regmask & PAL_BIT(i)) &&
+      !(used(p) & PAL_BIT(i))) continue;
+    m |= PAL_BIT(i);
+  }
+  return m;
+}
+
+/* Fill ins[] from a mask of pins, less those held by -i.
+ */
+static void
+enumerate(m)
+unsigned long m;
+{
+  int i;
+
+  for (nin = i = 0; i < PAL_PINS; ++i)
+    if ((m & ~fixmask) & PAL_BIT(i)) ins[nin++] = i;
+}
+
+/* The input words for block b of 64 states: state number b * 64 + i in
+ * bit i, bit k of the state number giving ins[k].
+ */
+static void
+block(b, in)
+long b;
+pal_word *in;
+{
+  static pal_word pat[6] = {
+    0xaaaaaaaaaaaaaaaaULL, 0xccccccccccccccccULL, 0xf0f0f0f0f0f0f0f0ULL,
+    0xff00ff00ff00ff00ULL, 0xffff0000ffff0000ULL, 0xffffffff00000000ULL
+  };
+  int i;
+
+  for (i = 0; i < PAL_PINS; ++i)
+    in[i] = (fixval & PAL_BIT(i))? ~(pal_word)0: 0;
+  for (i = 0; i < nin; ++i)
+    if (i < 6) in[ins[i]] = pat[i];
+    else in[ins[i]] = (b >> (i - 6) & 1)? ~(pal_word)0: 0;
+}
+
+/* Bits of a block which are real states, when there are fewer than 64.
+ */
+static pal_word
+valid()
+{
+  return (nin >= 6)? ~(pal_word)0: ((pal_word)1 << (1 << nin)) - 1;
+}
+
+static long
+nblocks()
+{
+  return (nin > 6)? 1L << (nin - 6): 1;
+}
+
+/* -t
+ */
+static void
+table()
+{
+  pal_word in[PAL_PINS], out[PAL_PINS], en[PAL_PINS], ok = valid();
+  struct pal_eqn *e;
+  long b;
+  int i, j;
+
+  enumerate(inputs_of(&pal));
+  printf("#");
+  for (i = nin - 1; i >= 0; --i) printf(" %s", pal.name[ins[i]]);
+  printf(" :");
+  for (e = pal.eqn; e < pal.eqn + pal.neqn; ++e)
+    printf(" %s%s", pal.name[e->pin], e->reg? "+": "");
+  printf("\n");
+  for (b = 0; b < nblocks(); ++b) {
+    block(b, in);
+    pal_eval64(&pal, in, out, en);
+    for (j = 0; j < 64; ++j) {
+      if (!(ok >> j & 1)) break;
+      putchar(' ');
+      for (i = nin - 1; i >= 0; --i)
+	printf(" %*d", (int)strlen(pal.name[ins[i]]), (int)(in[ins[i]] >> j & 1));
+      printf("  ");
+      for (e = pal.eqn; e < pal.eqn + pal.neqn; ++e)
+	printf(" %*c", (int)strlen(pal.name[e->pin]) + e->reg,
+	  !(en[e->pin] >> j & 1)? 'Z': (out[e->pin] >> j & 1)? '1': '0');
+      printf("\n");
+    }
+  }
+}
+
+/* -e
+ */
+static int
+compare(file)
+char *file;
+{
+  pal_word in[PAL_PINS], o1[PAL_PINS], e1[PAL_PINS], o2[PAL_PINS],
+    e2[PAL_PINS], d, ok;
+  unsigned long outs;
+  long b, states, diffs = 0;
+  int i, j, k;
+
+  load(&other, file);
+  if (strcmp(pal.type, other.type) != 0)
+    printf("warning: %s is a %s, not a %s\n", file, other.type, pal.type);
+  enumerate(inputs_of(&pal) | inputs_of(&other));
+  outs = pal.outs | other.outs;
+  ok = valid();
+  for (b = 0; b < nblocks(); ++b) {
+    block(b, in);
+    pal_eval64(&pal, in, o1, e1);
+    pal_eval64(&other, in, o2, e2);
+    for (i = 0; i < PAL_PINS; ++i) {
+      if (!(outs & PAL_BIT(i))) continue;
+      d = ((e1[i] ^ e2[i]) | (e1[i] & e2[i] & (o1[i] ^ o2[i]))) & ok;
+      for (j = 0; d != 0; ++j, d >>= 1) {
+	if (!(d & 1)) continue;
+	if (++diffs > 10) continue;
+	printf("pin %d (%s) differs:", i + 1, pal.name[i][0]? pal.name[i]:
+	  other.name[i]);
+	for (k = nin - 1; k >= 0; --k)
+	  printf(" %s=%d", pal.name[ins[k]][0]? pal.name[ins[k]]:
+	    other.name[ins[k]], (int)(in[ins[k]] >> j & 1));
+	printf("\n");
+      }
+    }
+  }
+  states = nblocks() * ((nin >= 6)? 64: 1L << nin);
+  if (diffs == 0) printf("equivalent over all %ld states\n", states);
+  else printf("%ld differences over %ld states\n", diffs, states);
+  return diffs != 0;
+}
+
+/* -r
+ */
+#define MAXCLOSE	4096		/* states searched for closed sets */
+
+static void
+show_state(s, statemask)
+unsigned long s, statemask;
+{
+  int i;
+
+  printf("  ");
+  for (i = 0; i < PAL_PINS; ++i)
+    if (statemask & PAL_BIT(i)) printf(" %s%s", (s & PAL_BIT(i))? "": "/",
+      pal.name[i]);
+}
+
+static void *
+alloc(n)
+long n;
+{
+  void *p;
+
+  if ((p = calloc(n, 1)) == NULL) {
+    fprintf(stderr, "palc: out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+#define R(i,j)	(r[(i) * row + (j) / 8] >> ((j) % 8) & 1)
+
+/* Find the states reachable from power up, then the closed sets among
+ * them: sets which once entered are never left.  A healthy machine has
+ * one, and the states outside it are passed through only after power
+ * up.  A second closed set is a place the machine can get stuck.
+ */
+static void
+reach()
+{
+  unsigned long statemask, s, v, x, *queue;
+  long *idx, *mark, *first, *edge, *set, *stk;
+  long nq, head, nedge, maxedge, x_n, i, j, k, sp, row, nset, closed;
+  unsigned char *r;
+
+  /* Registers, and combinational outputs fed back, are the state.
+   */
+  statemask = pal.regmask | (pal.outs & used(&pal));
+  enumerate(inputs_of(&pal) & ~statemask);
+  x_n = 1L << nin;
+
+  idx = (long *)alloc(MAXSTATE * sizeof *idx);
+  mark = (long *)alloc(MAXSTATE * sizeof *mark);
+  first = (long *)alloc((MAXSTATE + 1) * sizeof *first);
+  queue = (unsigned long *)alloc(MAXSTATE * sizeof *queue);
+  maxedge = 4096;
+  edge = (long *)alloc(maxedge * sizeof *edge);
+  for (i = 0; i < MAXSTATE; ++i) idx[i] = -1;
+
+  /* Registers clear at power up, which leaves their pins high.
+   */
+  queue[0] = pal_comb(&pal, (pal.regmask & ~pal.low) | fixval) & statemask;
+  idx[queue[0]] = 0;
+  nq = 1;
+  for (nedge = head = 0; head < nq; ++head) {
+    s = queue[head];
+    first[head] = nedge;
+    for (i = 0; i < x_n; ++i) {
+      for (x = fixval, k = 0; k < nin; ++k)
+	if (i >> k & 1) x |= PAL_BIT(ins[k]);
+      v = pal_clock(&pal, pal_comb(&pal, s | x)) & statemask;
+      if (idx[v] < 0) {
+	idx[v] = nq;
+	queue[nq++] = v;
+      }
+      if (mark[idx[v]] == head + 1) continue;
+      mark[idx[v]] = head + 1;
+      if (nedge == maxedge) {
+	maxedge *= 2;
+	if ((edge = (long *)realloc(edge, maxedge * sizeof *edge)) == NULL) {
+	  fprintf(stderr, "palc: out of memory\n");
+	  exit(1);
+	}
+      }
+      edge[nedge++] = idx[v];
+    }
+  }
+  first[nq] = nedge;
+  printf("%ld states reachable from power up\n", nq);
+  if (nq > MAXCLOSE) {
+    printf("too many to look for closed sets\n");
+    return;
+  }
+
+  /* r: which states each one leads to
+   */
+  row = (nq + 7) / 8;
+  r = (unsigned char *)alloc(nq * row);
+  stk = (long *)alloc(nq * sizeof *stk);
+  for (i = 0; i < nq; ++i) {
+    r[i * row + i / 8] |= 1 << i % 8;
+    for (stk[0] = i, sp = 1; sp > 0; )
+      for (j = stk[--sp], k = first[j]; k < first[j + 1]; ++k)
+	if (!R(i, edge[k])) {
+	  r[i * row + edge[k] / 8] |= 1 << edge[k] % 8;
+	  stk[sp++] = edge[k];
+	}
+  }
+
+  /* A state is in a closed set if every state it leads to leads back.
+   * The set is named by its first state.
+   */
+  set = (long *)alloc(nq * sizeof *set);
+  for (nset = closed = i = 0; i < nq; ++i) {
+    set[i] = -1;
+    for (j = 0; j < nq; ++j)
+      if (R(i, j) && !R(j, i)) break;
+    if (j < nq) continue;
+    for (j = 0; !R(i, j) || !R(j, i); ++j);
+    set[i] = (j == i)? nset++: set[j];
+    ++closed;
+  }
+  for (i = 0; i < nq; ++i) {
+    show_state(queue[i], statemask);
+    if (set[i] < 0) printf("   after power up only");
+    else if (nset > 1) printf("   closed set %ld", set[i] + 1);
+    printf("\n");
+  }
+  if (nset == 1)
+    printf("one closed set of %ld states, %ld after power up only\n",
+      closed, nq - closed);
+  else printf("%ld closed sets: the machine can be stuck in each\n", nset);
+}
+
+/* -j
+ */
+static int
+colpin(pin)
+int pin;
+{
+  int *cols = (pal.regs > 0)? reg_cols: l8_cols, k;
+
+  for (k = 0; k < 16; ++k)
+    if (cols[k] == pin + 1) return k;
+  return -1;
+}
+
+/* Fuses of one product term into row.  A fuse left intact (0) connects
+ * its column to the term; blown (1) disconnects it.
+ */
+static int
+fuse_term(fuse, row, t)
+char *fuse;
+int row;
+struct pal_term *t;
+{
+  int i, k, comp;
+
+  if ((t->on & t->off) != 0) return 0;	/* never true: leave intact */
+  memset(fuse + row * COLS, '1', COLS);
+  for (i = 0; i < PAL_PINS; ++i) {
+    if (!((t->on | t->off) & PAL_BIT(i))) continue;
+    if ((k = colpin(i)) < 0) {
+      fprintf(stderr, "palc: pin %d (%s) is not an input of the array\n",
+	i + 1, pal.name[i]);
+      return -1;
+    }
+    comp = ((pal.low >> i) & 1) ^ ((t->off >> i) & 1);
+    fuse[row * COLS + 2 * k + comp] = '0';
+  }
+  return 0;
+}
+
+static int
+jedec(file)
+char *file;
+{
+  char fuse[FUSES + 1], buf[100], *p;
+  struct pal_eqn *e;
+  int pin, row, i, ret = 0, first, max;
+  unsigned sum, xsum;
+
+  memset(fuse, '0', FUSES);
+  fuse[FUSES] = '\0';
+  first = 12 + (8 - pal.regs) / 2;	/* first registered pin */
+  for (e = pal.eqn; e < pal.eqn + pal.neqn; ++e) {
+    pin = e->pin + 1;
+    row = (19 - pin) * 8;
+    if (((pal.low >> e->pin) & 1) == e->neg) {
+      fprintf(stderr, "palc: %s: outputs invert, so write /%s = ...\n",
+	pal.name[e->pin], pal.name[e->pin]);
+      ret = -1;
+      continue;
+    }
+    if (pin < first || pin >= first + pal.regs) {
+      if (e->nen > 1) {
+	fprintf(stderr, "palc: %s: the enable is one product term\n",
+	  pal.name[e->pin]);
+	ret = -1;
+	continue;
+      }
+      if (e->nen == 0) memset(fuse + row * COLS, '1', COLS);
+      else if (fuse_term(fuse, row, &e->en[0]) < 0) ret = -1;
+      ++row;
+      max = 7;
+    } else max = 8;
+    if (e->nterm > max) {
+      fprintf(stderr, "palc: %s: %d product terms, the part has %d\n",
+	pal.name[e->pin], e->nterm, max);
+      ret = -1;
+      continue;
+    }
+    for (i = 0; i < e->nterm; ++i)
+      if (fuse_term(fuse, row + i, &e->term[i]) < 0) ret = -1;
+  }
+  if (ret < 0) return ret;
+
+  for (sum = i = 0; i < FUSES; i += 8) {
+    int byte = 0, j;
+
+    for (j = 0; j < 8; ++j)
+      if (fuse[i + j] == '1') byte |= 1 << j;
+    sum += byte;
+  }
+
+  /* The transmission checksum covers every character from STX to ETX.
+   */
+  xsum = STX;
+  putchar(STX);
+  sprintf(buf, "\n%s %s\n", pal.type, file);
+  for (p = buf; *p; ++p) xsum += *p, putchar(*p);
+  for (i = 0; i < 4 && pal.title[i][0]; ++i) {
+    for (p = pal.title[i]; *p; ++p) {
+      if (*p == '*') *p = ' ';
+      xsum += *p;
+      putchar(*p);
+    }
+    xsum += '\n';
+    putchar('\n');
+  }
+  sprintf(buf, "*\nQP20*\nQF%d*\nG0*\nF0*\n", FUSES);
+  for (p = buf; *p; ++p) xsum += *p, putchar(*p);
+  for (row = 0; row < FUSES / COLS; ++row) {
+    sprintf(buf, "L%04d %.32s*\n", row * COLS, fuse + row * COLS);
+    for (p = buf; *p; ++p) xsum += *p, putchar(*p);
+  }
+  sprintf(buf, "C%04X*\n", sum & 0xffff);
+  for (p = buf; *p; ++p) xsum += *p, putchar(*p);
+  xsum += ETX;
+  printf("%c%04X\n", ETX, xsum & 0xffff);
+  return 0;
+}
+
+/* No option: what the part holds.
+ */
+static void
+summary(file)
+char *file;
+{
+  struct pal_eqn *e;
+  int first = 12 + (8 - pal.regs) / 2, pin;
+
+  printf("%s: %s, %d equations\n", file, pal.type, pal.neqn);
+  for (e = pal.eqn; e < pal.eqn + pal.neqn; ++e) {
+    pin = e->pin + 1;
+    printf("  pin %2d %-8s %s %d of %d product terms%s\n", pin,
+      pal.name[e->pin], e->reg? "registered   ": "combinational", e->nterm,
+      (pin >= first && pin < first + pal.regs)? 8: 7,
+      e->nen > 0? ", enabled by a term": "");
+  }
+  enumerate(inputs_of(&pal));
+  printf("  %d inputs and feedbacks, %ld states\n", nin, 1L << nin);
+}
+
+int
+main(argc, argv)
+int argc;
+char **argv;
+{
+  char *file = NULL, *with = NULL, *p;
+  int i, pin, t = 0, r = 0, j = 0, ret = 0;
+  struct {
+    char *name;
+    int val;
+  } fix[PAL_PINS];
+  int nfix = 0;
+
+  for (i = 1; i < argc; ++i) {
+    if (argv[i][0] != '-') {
+      if (file != NULL) usage();
+      file = argv[i];
+      continue;
+    }
+    switch (argv[i][1]) {
+      case 't': t = 1; break;
+      case 'r': r = 1; break;
+      case 'j': j = 1; break;
+      case 'e':
+	if (++i >= argc) usage();
+	with = argv[i];
+	break;
+      case 'i':
+	if (++i >= argc || nfix == PAL_PINS ||
+	  (p = strchr(argv[i], '=')) == NULL || (p[1] != '0' && p[1] != '1'))
+	  usage();
+	*p = '\0';
+	fix[nfix].name = argv[i];
+	fix[nfix++].val = p[1] - '0';
+	break;
+      default:
+	usage();
+    }
+  }
+  if (file == NULL) usage();
+  load(&pal, file);
+  for (i = 0; i < nfix; ++i) {
+    for (p = fix[i].name; *p; ++p)
+      if (*p >= 'a' && *p <= 'z') *p += 'A' - 'a';
+    if ((pin = pal_pin(&pal, fix[i].name)) < 0) {
+      fprintf(stderr, "palc: %s has no pin %s\n", file, fix[i].name);
+      exit(1);
+    }
+    fixmask |= PAL_BIT(pin);
+    if (fix[i].val) fixval |= PAL_BIT(pin);
+  }
+
+  if (!t && !r && !j && with == NULL) summary(file);
+  if (t) table();
+  if (r) reach();
+  if (with != NULL) ret |= compare(with);
+  if (j && jedec(file) < 0) ret = 1;
+  exit(ret);
+}
@@ -0,0 +1,218 @@
+/* ROM images from the linked monitor.
+ *
+ * Usage: romimg [-s <rom size>] [-d <dir>] <a.out>...
+ *
+ * Reads each a.out the monitor's Makefile links (rom_db, rom_db9600,
+ * rom_db19.2K, ...) and writes the ROM images for it, named by what
+ * follows "rom_db" in its name:
+ *
+ *	image.hex<v>	Intel HEX, 32 byte records, as sim32k and DOWNLOAD
+ *			HEX read
+ *	image.bin<v>	the ROM as one binary
+ *	image.even<v>	the even bytes, for eprom_e
+ *	image.odd<v>	the odd bytes, for eprom_o
+ *
+ * The ROM holds the text then the initialized data, which the monitor
+ * copies to RAM at start up; the header and symbols are left out, as
+ * dd skip=1 did.  The binaries are padded to the ROM size with 0xff,
+ * an erased EPROM.  The ROM size is the pair of EPROMs, by default each
+ * image rounded up to a power of two on its own.
+ *
+ * For each image the CRC is printed, as the monitor's CRC command
+ * computes it over the ROM, and the 16 bit sum of each EPROM, as a
+ * programmer shows it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define CONST			/* crctab.c is built with GCC=0 */
+#include "crctab.h"
+
+/* The a.out header of the 32000 tools (newtools/include/a.out.h):
+ * twelve longs, least significant byte first.
+ */
+#define HDRSIZE		48
+#define EXEC_MAGIC	0x9ec0L
+#define BLKSZ		1024		/* text offset of an executable */
+#define A_MAGIC		0
+#define A_TEXT		1
+#define A_DATA		2
+
+#define RECSZ		32		/* bytes in a HEX record */
+#define ROM_MAX		0x10000		/* largest EPROM pair */
+
+static unsigned char rom[ROM_MAX];
+static char *dir = ".";
+
+static void
+usage()
+{
+  fprintf(stderr, "usage: romimg [-s rom size] [-d dir] a.out...\n");
+  exit(2);
+}
+
+static long
+get32(p)
+unsigned char *p;
+{
+  return p[0] | p[1] << 8 | (long)p[2] << 16 | (long)p[3] << 24;
+}
+
+/* Read the text and data of file into rom.  Return their length, or
+ * -1 if the file is not an executable which fits.
+ */
+static long
+load(file)
+char *file;
+{
+  unsigned char hdr[HDRSIZE];
+  long text, data;
+  FILE *f;
+
+  if ((f = fopen(file, "rb")) == NULL) {
+    perror(file);
+    return -1;
+  }
+  if (fread(hdr, 1, HDRSIZE, f) != HDRSIZE ||
+    get32(hdr + 4 * A_MAGIC) != EXEC_MAGIC) {
+    fprintf(stderr, "romimg: %s: not an executable\n", file);
+    fclose(f);
+    return -1;
+  }
+  text = get32(hdr + 4 * A_TEXT);
+  data = get32(hdr + 4 * A_DATA);
+  if (text < 0 || data < 0 || text + data > ROM_MAX) {
+    fprintf(stderr, "romimg: %s: %ld bytes of text and data, the ROM has %d\n",
+      file, text + data, ROM_MAX);
+    fclose(f);
+    return -1;
+  }
+  memset(rom, 0xff, sizeof rom);
+  if (fseek(f, (long)BLKSZ, SEEK_SET) != 0 ||
+    fread(rom, 1, (size_t)(text + data), f) != text + data) {
+    fprintf(stderr, "romimg: %s: short file\n", file);
+    fclose(f);
+    return -1;
+  }
+  fclose(f);
+  return text + data;
+}
+
+static FILE *
+create(name, v)
+char *name, *v;
+{
+  static char path[1024];
+  FILE *f;
+
+  sprintf(path, "%s/image.%s%s", dir, name, v);
+  if ((f = fopen(path, "wb")) == NULL) perror(path);
+  return f;
+}
+
+static int
+hexfile(v, len)
+char *v;
+long len;
+{
+  FILE *f;
+  long a;
+  int i, n, sum;
+
+  if ((f = create("hex", v)) == NULL) return -1;
+  for (a = 0; a < len; a += n) {
+    n = (len - a < RECSZ)? len - a: RECSZ;
+    sum = n + (a >> 8) + a;
+    fprintf(f, ":%02X%04lX00", n, a & 0xffff);
+    for (i = 0; i < n; ++i) {
+      fprintf(f, "%02X", rom[a + i]);
+      sum += rom[a + i];
+    }
+    fprintf(f, "%02X\n", -sum & 0xff);
+  }
+  fprintf(f, ":00000001FF\n");
+  return fclose(f);
+}
+
+/* Write every step'th byte of a ROM of size bytes from first; return
+ * its sum.
+ */
+static long
+binfile(name, v, size, first, step)
+char *name, *v;
+long size;
+int first, step;
+{
+  FILE *f;
+  long a, sum = 0;
+
+  if ((f = create(name, v)) == NULL) return -1;
+  for (a = first; a < size; a += step) {
+    putc(rom[a], f);
+    sum += rom[a];
+  }
+  if (fclose(f) != 0) return -1;
+  return sum & 0xffff;
+}
+
+/* Write the images of file for a ROM of size bytes, or the smallest
+ * which holds it if size is 0.
+ */
+static int
+image(file, size)
+char *file;
+long size;
+{
+  long len, a, crc = 0, even, odd, romsize;
+  char *v;
+
+  if ((len = load(file)) < 0) return -1;
+  if ((v = strrchr(file, '/')) == NULL) v = file;
+  else ++v;
+  v = (strncmp(v, "rom_db", 6) == 0)? v + 6: v;
+  if ((romsize = size) == 0)
+    for (romsize = 2; romsize < len; romsize <<= 1);
+  if (len > romsize) {
+    fprintf(stderr, "romimg: %s: %ld bytes, the ROM has %ld\n", file, len,
+      romsize);
+    return -1;
+  }
+  if (hexfile(v, len) != 0 || binfile("bin", v, romsize, 0, 1) < 0 ||
+    (even = binfile("even", v, romsize, 0, 2)) < 0 ||
+    (odd = binfile("odd", v, romsize, 1, 2)) < 0)
+    return -1;
+  for (a = 0; a < len; ++a) crc = UPDATE_CRC(crc, rom[a]);
+  printf("image.hex%s: %ld bytes, CRC %ld, EPROM sums even %04lX odd %04lX\n",
+    v, len, crc, even, odd);
+  return 0;
+}
+
+int
+main(argc, argv)
+int argc;
+char **argv;
+{
+  int i, ret = 0;
+  long size = 0;
+  char *p;
+
+  for (i = 1; i < argc && argv[i][0] == '-'; ++i)
+    switch (argv[i][1]) {
+      case 's':
+	if (++i >= argc) usage();
+	size = strtol(argv[i], &p, 0);
+	if (*p != '\0' || size <= 0 || size > ROM_MAX || (size & 1)) usage();
+	break;
+      case 'd':
+	if (++i >= argc) usage();
+	dir = argv[i];
+	break;
+      default:
+	usage();
+    }
+  if (i == argc) usage();
+  for (; i < argc; ++i)
+    if (image(argv[i], size) < 0) ret = 1;
+  exit(ret);
+}
@@ -0,0 +1,89 @@
+/* NS32000 host simulator.
+ *
+ * Front end.  Loads a ROM image, connects the console and disks, and
+ * runs until the console input is used up and the program is waiting
+ * for more, or until an instruction limit is reached.
+ *
+ * Usage: sim32k [-t] [-n <count>] [-i <input>] [-d <id>=<disk image>]
+ *		 [<rom image>]
+ *
+ * The default ROM image is ../image.hex9600.  Without -i, the console is
+ * stdin and stdout.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim32k.h"
+
+#define DEFAULT_ROM	"../image.hex9600"
+#define TICK		64		/* instructions between device ticks */
+
+int trace;
+
+static void
+usage()
+{
+  fprintf(stderr,
+    "usage: sim32k [-t] [-n count] [-i input] [-d id=disk] [rom.hex]\n");
+  exit(2);
+}
+
+int
+main(argc, argv)
+int argc;
+char **argv;
+{
+  char *rom = DEFAULT_ROM, *p;
+  FILE *in = stdin;
+  long limit = 0, n;
+  int i, id;
+  clock_t t0, t1;
+
+  dev_reset();
+  for (i = 1; i < argc; ++i) {
+    if (argv[i][0] != '-') {
+      rom = argv[i];
+      continue;
+    }
+    switch (argv[i][1]) {
+      case 't':
+	trace = 1;
+	break;
+      case 'n':
+	if (++i >= argc) usage();
+	limit = strtol(argv[i], (char **)0, 0);
+	break;
+      case 'i':
+	if (++i >= argc) usage();
+	if ((in = fopen(argv[i], "rb")) == NULL) {
+	  perror(argv[i]);
+	  exit(1);
+	}
+	break;
+      case 'd':
+	if (++i >= argc || (p = strchr(argv[i], '=')) == NULL) usage();
+	id = atoi(argv[i]);
+	if (scsi_attach(id, p + 1) < 0) exit(1);
+	break;
+      default:
+	usage();
+    }
+  }
+  if (rom_load_hex(rom) < 0) exit(1);
+  con_file(in, stdout);
+  cpu_reset();
+
+  t0 = clock();
+  for (n = 0; !con_idle() && (limit == 0 || proc.icount < limit); ++n) {
+    cpu_step();
+    if (proc.halted && dev_irq() < 0) break;
+    if ((n & (TICK - 1)) == 0) dev_tick((long)TICK);
+  }
+  t1 = clock();
+  fflush(stdout);
+  fprintf(stderr, "\nsim32k: %ld instructions, %.3f s, pc %08x\n",
+    proc.icount, (double)(t1 - t0) / CLOCKS_PER_SEC, proc.pc);
+  exit(0);
+}
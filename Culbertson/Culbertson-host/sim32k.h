@@ -0,0 +1,96 @@
+/* NS32000 host simulator.
+ *
+ * Declarations shared by the CPU, the devices and the front end.  The
+ * instruction decoder is the monitor's own (Culbertson-mon/disasm.c), so
+ * the operand and addressing mode conventions are those of dasm.h and
+ * machine.h.
+ */
+
+#include "../Culbertson-mon/machine.h"
+#include "../Culbertson-mon/dasm.h"
+#include "../Culbertson-mon/debugger.h"
+
+typedef unsigned int	u32;		/* 32 bits on every host we use */
+
+/* Sign extend the low n bytes of x.
+ */
+#define SEXT(x,n)	((int)((((u32)(x) & szmask[n]) ^ szsign[n]) - szsign[n]))
+
+extern u32 szmask[], szsign[];		/* indexed by operand size 1, 2, 4 */
+
+/* Memory map of the pc532.
+ */
+#define RAM_SIZE	0x2000000	/* 32 megabytes at 0 */
+#define ROM_ADR		0x10000000	/* where the ROM is linked */
+#define ROM_MAX		0x10000		/* largest EPROM pair */
+#define DUART_ADR	0x28000000	/* four 2681s, eight bytes per uart */
+#define NMI_CLR_ADR	0x28000040	/* reading clears parity NMI */
+#define SC_CTL_ADR	0x30000000	/* DP8490 registers */
+#define SC_DMA_ADR	0x38000000	/* DP8490 pseudo-DMA data register */
+#define ICU_ADR		0xfffffe00	/* NS32202, byte wide */
+
+/* ICU interrupt lines used by the simulated devices.
+ */
+#define IRQ_SCSI	5		/* DP8490 */
+#define IRQ_DUART(d)	(13 - 2 * (d))	/* duart d */
+
+/* Trap vectors, same numbering as trap_string[] in init532.c.
+ */
+#define VEC_NVI		0
+#define VEC_NMI		1
+#define VEC_ABT		2
+#define VEC_SLV		3
+#define VEC_ILL		4
+#define VEC_SVC		5
+#define VEC_DVZ		6
+#define VEC_FLG		7
+#define VEC_BPT		8
+#define VEC_TRC		9
+#define VEC_UND		10
+
+/* CFG bits the CPU looks at.
+ */
+#define CFG_DE		0x100		/* 532 direct exception mode */
+
+/* Processor state.  Register numbering follows regTable so the decoder's
+ * o_reg0 values index straight into the general registers.
+ */
+struct cpu {
+  u32 r[8];
+  u32 pc, sb, fp, sp0, sp1, intbase;
+  u32 psr, mod, cfg;
+  u32 dcr, dsr, car, bpc;
+  u32 ptb0, ptb1, mcr, msr, tear;
+  u32 fsr;
+  u32 f[16];				/* eight long registers, lsw first */
+  u32 ipc;				/* address of current instruction */
+  long icount;				/* instructions executed */
+  int trapped;				/* set when an instruction trapped */
+  int halted;				/* set by WAIT with nothing pending */
+};
+
+extern struct cpu proc;
+extern int trace;			/* print each instruction */
+
+/* Memory and devices, simio.c */
+int	mem_rd8();
+u32	mem_rd();
+int	mem_wr();
+int	mem_fetch();
+void	mem_init();
+int	rom_load_hex();
+void	dev_reset();
+int	dev_irq();			/* vector of pending interrupt or -1 */
+void	dev_reti();
+void	dev_tick();
+void	con_file();
+int	con_idle();
+int	scsi_attach();
+extern char *codepage;			/* RAM pages holding decoded code */
+
+/* CPU, simcpu.c */
+void	cpu_reset();
+int	cpu_step();
+void	cpu_trap();
+void	dcache_flush();
+void	dcache_inval();
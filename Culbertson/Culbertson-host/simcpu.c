@@ -0,0 +1,1437 @@
+/* NS32000 host simulator.
+ *
+ * CPU.  Instructions are decoded by the monitor's disassembler,
+ * dasm_ns32k(), and executed from the resulting struct insn.  Decoded
+ * instructions are kept in a small cache keyed by physical address so
+ * loops do not pay for the decoder on every pass.
+ *
+ * Integer, string, bit field, procedure call, trap and MMU register
+ * instructions are done.  The FPU is only a register file: MOVF, MOVL,
+ * LFSR and SFSR work (enough for the monitor to save and restore user
+ * state); other floating point instructions take the undefined
+ * instruction trap.
+ */
+
+#include <setjmp.h>
+#include <string.h>
+#include <stdio.h>
+#include "sim32k.h"
+
+#define MAX_INSN_LEN	24
+
+/* Access classes for operands.
+ */
+#define A_READ		0
+#define A_WRITE		1
+#define A_RMW		2
+#define A_ADDR		3
+
+/* Where an operand lives.
+ */
+#define L_REG		0
+#define L_FREG		1
+#define L_MEM		2
+#define L_IMM		3
+
+struct loc {
+  int type;
+  int reg;
+  u32 adr;
+  u32 val;
+};
+
+/* Instruction formats, operand lengths and opcode numbers, as in
+ * das32k.h.  That file defines the decoder's tables so it cannot be
+ * included twice.
+ */
+#define ITYPE_FMT0	0
+#define ITYPE_FMT1	1
+#define ITYPE_FMT2	2
+#define ITYPE_FMT3	3
+#define ITYPE_FMT4	4
+#define ITYPE_FMT5	5
+#define ITYPE_FMT6	6
+#define ITYPE_FMT7	7
+#define ITYPE_FMT8	8
+#define ITYPE_FMT9	9
+#define ITYPE_NOP	10
+#define ITYPE_FMT11	11
+#define ITYPE_FMT12	12
+#define ITYPE_UNDEF	13
+#define ITYPE_FMT14	14
+
+#define IOL(x)		(((x)&0x3) + 1)
+#define FMT11_F(x)	((x)&01)
+
+#define F1_BSR		0x0
+#define F1_RET		0x1
+#define F1_CXP		0x2
+#define F1_RXP		0x3
+#define F1_RETT		0x4
+#define F1_RETI		0x5
+#define F1_SAVE		0x6
+#define F1_RESTORE	0x7
+#define F1_ENTER	0x8
+#define F1_EXIT		0x9
+#define F1_NOP		0xa
+#define F1_WAIT		0xb
+#define F1_DIA		0xc
+#define F1_FLAG		0xd
+#define F1_SVC		0xe
+#define F1_BPT		0xf
+
+#define F2_ADDQ		0x0
+#define F2_CMPQ		0x1
+#define F2_SPR		0x2
+#define F2_SCOND	0x3
+#define F2_ACB		0x4
+#define F2_MOVQ		0x5
+#define F2_LPR		0x6
+
+#define F3_CXPD		0x0
+#define F3_BICPSR	0x1
+#define F3_JUMP		0x2
+#define F3_BISPSR	0x3
+#define F3_ADJSP	0x5
+#define F3_JSR		0x6
+#define F3_CASE		0x7
+
+#define F4_ADD		0x0
+#define F4_CMP		0x1
+#define F4_BIC		0x2
+#define F4_ADDC		0x4
+#define F4_MOV		0x5
+#define F4_OR		0x6
+#define F4_SUB		0x8
+#define F4_ADDR		0x9
+#define F4_AND		0xa
+#define F4_SUBC		0xc
+#define F4_TBIT		0xd
+#define F4_XOR		0xe
+
+#define F5_MOVS		0x0
+#define F5_CMPS		0x1
+#define F5_SETCFG	0x2
+#define F5_SKPS		0x3
+
+#define F6_ROT		0x0
+#define F6_ASH		0x1
+#define F6_CBIT		0x2
+#define F6_CBITI	0x3
+#define F6_LSH		0x5
+#define F6_SBIT		0x6
+#define F6_SBITI	0x7
+#define F6_NEG		0x8
+#define F6_NOT		0x9
+#define F6_SUBP		0xb
+#define F6_ABS		0xc
+#define F6_COM		0xd
+#define F6_IBIT		0xe
+#define F6_ADDP		0xf
+
+#define F7_MOVM		0x0
+#define F7_CMPM		0x1
+#define F7_INSS		0x2
+#define F7_EXTS		0x3
+#define F7_MOVXBW	0x4
+#define F7_MOVZBW	0x5
+#define F7_MOVZD	0x6
+#define F7_MOVXD	0x7
+#define F7_MUL		0x8
+#define F7_MEI		0x9
+#define F7_DEI		0xb
+#define F7_QUO		0xc
+#define F7_REM		0xd
+#define F7_MOD		0xe
+#define F7_DIV		0xf
+
+#define F8_EXT		0x0
+#define F8_CVTP		0x1
+#define F8_INS		0x2
+#define F8_CHECK	0x3
+#define F8_INDEX	0x4
+#define F8_FFS		0x5
+#define F8_MOVUS	0x6
+
+#define F9_LFSR		0x1
+#define F9_SFSR		0x6
+
+#define F11_MOV		0x1
+
+#define F14_RDVAL	0x0
+#define F14_WRVAL	0x1
+#define F14_LMR		0x2
+#define F14_SMR		0x3
+#define F14_CINV	0x9
+
+/* PSR bits
+ */
+#define C_BIT		PSR_C
+#define T_BIT		PSR_T
+#define L_BIT		PSR_L
+#define F_BIT		PSR_F
+#define Z_BIT		PSR_Z
+#define N_BIT		PSR_N
+#define U_BIT		PSR_U
+#define S_BIT		PSR_S
+#define P_BIT		PSR_P
+#define I_BIT		PSR_I
+
+/* MCR bits, as in vaddr.c
+ */
+#define MCR_TU		0x1
+#define MCR_TS		0x2
+#define MCR_DS		0x4
+
+/* Decoded instruction cache.
+ */
+#define DCACHE_SIZE	0x4000
+#define PAGE_SHIFT	12
+
+struct dcache {
+  u32 adr;				/* physical address */
+  int len;				/* 0 if entry empty */
+  struct insn insn;
+  unsigned char raw[MAX_INSN_LEN];
+};
+
+struct cpu proc;
+u32 szmask[] = {0, 0xff, 0xffff, 0xffffff, 0xffffffff};
+u32 szsign[] = {0, 0x80, 0x8000, 0x800000, 0x80000000};
+char *codepage;
+static struct dcache dcache[DCACHE_SIZE];
+static jmp_buf trap_jb;
+static int trap_vec;
+
+
+/*===========================================================================*
+ *				stack and memory			     *
+ *===========================================================================*/
+
+/* Translate a virtual address.  The page table walk is the one in
+ * vaddr.c.  Abort on an invalid entry.
+ */
+static u32
+translate(vaddr, user)
+u32 vaddr;
+int user;
+{
+  u32 ptb, pte1, pte2;
+
+  if (user? !(proc.mcr & MCR_TU): !(proc.mcr & MCR_TS)) return vaddr;
+  ptb = (user && (proc.mcr & MCR_DS))? proc.ptb1: proc.ptb0;
+  pte1 = mem_rd((ptb & 0xfffff000) | ((vaddr >> 20) & 0xffc), 4);
+  if (pte1 & 1) {
+    pte2 = mem_rd((pte1 & 0xfffff000) | ((vaddr >> 10) & 0xffc), 4);
+    if (pte2 & 1) return (pte2 & 0xfffff000) | (vaddr & 0xfff);
+  }
+  proc.tear = vaddr;
+  trap_vec = VEC_ABT;
+  longjmp(trap_jb, 1);
+  /*NOTREACHED*/
+}
+
+#define TRANSLATING	(proc.mcr & (MCR_TU | MCR_TS))
+#define USER		((proc.psr & U_BIT) != 0)
+
+static u32
+vrd(adr, n)
+u32 adr;
+int n;
+{
+  u32 val;
+  int i;
+
+  if (!TRANSLATING) return mem_rd(adr, n);
+  if (((adr & 0xfff) + n) <= 0x1000) return mem_rd(translate(adr, USER), n);
+  for (val = 0, i = 0; i < n; ++i)
+    val |= (u32)mem_rd8(translate(adr + i, USER)) << (8 * i);
+  return val;
+}
+
+static void
+vwr(adr, n, val)
+u32 adr, val;
+int n;
+{
+  int i;
+
+  if (!TRANSLATING) {
+    mem_wr(adr, n, val);
+    return;
+  }
+  if (((adr & 0xfff) + n) <= 0x1000) {
+    mem_wr(translate(adr, USER), n, val);
+    return;
+  }
+  for (i = 0; i < n; ++i)
+    mem_wr(translate(adr + i, USER), 1, (val >> (8 * i)) & 0xff);
+}
+
+#define SP	(*((proc.psr & S_BIT)? &proc.sp1: &proc.sp0))
+
+static void
+push(val, n)
+u32 val;
+int n;
+{
+  SP -= n;
+  vwr(SP, n, val);
+}
+
+static u32
+pop(n)
+int n;
+{
+  u32 val;
+
+  val = vrd(SP, n);
+  SP += n;
+  return val;
+}
+
+/* Raise a trap from inside an instruction.  The return address is the
+ * address of the instruction.
+ */
+static void
+trap(vec)
+int vec;
+{
+  trap_vec = vec;
+  longjmp(trap_jb, 1);
+}
+
+/*===========================================================================*
+ *				operands				     *
+ *===========================================================================*/
+
+/* Value of a register named by a regTable index, as used in addressing
+ * modes.
+ */
+static u32
+basereg(reg)
+int reg;
+{
+  if (reg >= REG_R0 && reg <= REG_R7) return proc.r[reg - REG_R0];
+  switch (reg) {
+    case REG_FP:	return proc.fp;
+    case REG_SP:	return SP;
+    case REG_SB:	return proc.sb;
+    case REG_PC:	return proc.ipc;
+  }
+  trap(VEC_UND);
+  return 0;				/* not reached */
+}
+
+/* Find where an operand lives.  TOS operands adjust the stack here, so
+ * operands must be located in instruction order.
+ */
+static void
+locate(o, n, acc, l)
+struct operand *o;
+int n, acc;
+struct loc *l;
+{
+  u32 adr, link;
+
+  switch (o->o_mode) {
+    case AMODE_REG:
+    case AMODE_AREG:
+      if (o->o_iscale) {		/* r[rx:i] is 0(r)[rx:i] */
+	adr = proc.r[o->o_reg0 - REG_R0];
+	break;
+      }
+      if (o->o_reg0 >= REG_F0 && o->o_reg0 <= REG_F7) {
+	l->type = L_FREG;
+	l->reg = o->o_reg0 - REG_F0;
+      } else {
+	l->type = L_REG;
+	l->reg = o->o_reg0 - REG_R0;
+      }
+      return;
+    case AMODE_IMM:
+    case AMODE_QUICK:
+    case AMODE_BLISTB:
+    case AMODE_BLISTW:
+    case AMODE_BLISTD:
+      if (acc != A_READ) trap(VEC_UND);
+      l->type = L_IMM;
+      l->val = o->o_disp0;
+      return;
+    case AMODE_TOS:
+      if (o->o_iscale || acc == A_RMW || acc == A_ADDR) adr = SP;
+      else if (acc == A_READ) {
+	adr = SP;
+	SP += n;
+      } else {
+	SP -= n;
+	adr = SP;
+      }
+      break;
+    case AMODE_RREL:
+    case AMODE_MSPC:
+      adr = basereg(o->o_reg0) + o->o_disp0;
+      break;
+    case AMODE_MREL:
+      adr = vrd(basereg(o->o_reg0) + o->o_disp0, 4) + o->o_disp1;
+      break;
+    case AMODE_ABS:
+      adr = o->o_disp0;
+      break;
+    case AMODE_EXT:
+      link = vrd(proc.mod + 4, 4);
+      adr = vrd(link + 4 * o->o_disp0, 4) + o->o_disp1;
+      break;
+    default:
+      trap(VEC_UND);
+  }
+  if (o->o_iscale)
+    adr += proc.r[o->o_ireg] << (o->o_iscale - 1);
+  l->type = L_MEM;
+  l->adr = adr;
+}
+
+static u32
+rdloc(l, n)
+struct loc *l;
+int n;
+{
+  switch (l->type) {
+    case L_REG:		return proc.r[l->reg] & szmask[n];
+    case L_FREG:	return proc.f[2 * l->reg];
+    case L_MEM:		return vrd(l->adr, n);
+  }
+  return l->val & szmask[n];
+}
+
+static void
+wrloc(l, n, val)
+struct loc *l;
+int n;
+u32 val;
+{
+  switch (l->type) {
+    case L_REG:
+      proc.r[l->reg] = (proc.r[l->reg] & ~szmask[n]) | (val & szmask[n]);
+      return;
+    case L_FREG:
+      proc.f[2 * l->reg] = val;
+      return;
+    case L_MEM:
+      vwr(l->adr, n, val & szmask[n]);
+      return;
+  }
+  trap(VEC_UND);
+}
+
+/* Short cuts for the common cases.
+ */
+static u32
+rdop(o, n)
+struct operand *o;
+int n;
+{
+  struct loc l;
+
+  locate(o, n, A_READ, &l);
+  return rdloc(&l, n);
+}
+
+static void
+wrop(o, n, val)
+struct operand *o;
+int n;
+u32 val;
+{
+  struct loc l;
+
+  locate(o, n, A_WRITE, &l);
+  wrloc(&l, n, val);
+}
+
+static u32
+adrop(o)
+struct operand *o;
+{
+  struct loc l;
+
+  locate(o, 4, A_ADDR, &l);
+  if (l.type != L_MEM) trap(VEC_UND);
+  return l.adr;
+}
+
+/*===========================================================================*
+ *				flags and arithmetic			     *
+ *===========================================================================*/
+
+static void
+setflag(bit, on)
+u32 bit;
+int on;
+{
+  if (on) proc.psr |= bit;
+  else proc.psr &= ~bit;
+}
+
+/* CMPi src1,src2 and friends: Z if equal, N if src1 > src2 as integers,
+ * L if src1 > src2 as unsigned.
+ */
+static void
+compare(a, b, n)
+u32 a, b;
+int n;
+{
+  a &= szmask[n];
+  b &= szmask[n];
+  setflag(Z_BIT, a == b);
+  setflag(N_BIT, SEXT(a, n) > SEXT(b, n));
+  setflag(L_BIT, a > b);
+}
+
+static u32
+add(a, b, c, n)
+u32 a, b, c;
+int n;
+{
+  u32 r, m = szmask[n];
+
+  a &= m;
+  b &= m;
+  r = (a + b + c) & m;
+  setflag(C_BIT, r < a || (c && r == a));
+  setflag(F_BIT, (~(a ^ b) & (a ^ r) & szsign[n]) != 0);
+  return r;
+}
+
+/* dest - src - borrow */
+static u32
+sub(d, s, c, n)
+u32 d, s, c;
+int n;
+{
+  u32 r, m = szmask[n];
+
+  d &= m;
+  s &= m;
+  r = (d - s - c) & m;
+  setflag(C_BIT, d < s || (c && d == s));
+  setflag(F_BIT, ((d ^ s) & (d ^ r) & szsign[n]) != 0);
+  return r;
+}
+
+static int
+cond(cc)
+int cc;
+{
+  u32 psr = proc.psr;
+
+  switch (cc) {
+    case 0:	return (psr & Z_BIT) != 0;			/* eq */
+    case 1:	return (psr & Z_BIT) == 0;			/* ne */
+    case 2:	return (psr & C_BIT) != 0;			/* cs */
+    case 3:	return (psr & C_BIT) == 0;			/* cc */
+    case 4:	return (psr & L_BIT) != 0;			/* hi */
+    case 5:	return (psr & L_BIT) == 0;			/* ls */
+    case 6:	return (psr & N_BIT) != 0;			/* gt */
+    case 7:	return (psr & N_BIT) == 0;			/* le */
+    case 8:	return (psr & F_BIT) != 0;			/* fs */
+    case 9:	return (psr & F_BIT) == 0;			/* fc */
+    case 10:	return (psr & (L_BIT | Z_BIT)) == 0;		/* lo */
+    case 11:	return (psr & (L_BIT | Z_BIT)) != 0;		/* hs */
+    case 12:	return (psr & (N_BIT | Z_BIT)) == 0;		/* lt */
+    case 13:	return (psr & (N_BIT | Z_BIT)) != 0;		/* ge */
+    case 14:	return 1;					/* r */
+  }
+  return 0;
+}
+
+/* Packed decimal add or subtract.  Returns the result, sets C.
+ */
+static u32
+bcd(a, b, n, subtract)
+u32 a, b;
+int n, subtract;
+{
+  u32 r = 0;
+  int i, c, d;
+
+  c = (proc.psr & C_BIT) != 0;
+  for (i = 0; i < 2 * n; ++i) {
+    d = (subtract? -1: 1) * (int)((a >> (4 * i)) & 0xf) +
+      (int)((b >> (4 * i)) & 0xf) + (subtract? -c: c);
+    if (subtract) {
+      d = (int)((b >> (4 * i)) & 0xf) - (int)((a >> (4 * i)) & 0xf) - c;
+      c = d < 0;
+      if (c) d += 10;
+    } else {
+      c = d > 9;
+      if (c) d -= 10;
+    }
+    r |= (u32)d << (4 * i);
+  }
+  setflag(C_BIT, c);
+  return r;
+}
+
+/*===========================================================================*
+ *				bits and fields				     *
+ *===========================================================================*/
+
+/* Bit operations: TBIT, SBIT, CBIT, IBIT.  how is 0 test, 1 set, 2 clear,
+ * 3 invert.  F gets the old value of the bit.
+ */
+static void
+bitop(offo, baseo, n, how)
+struct operand *offo, *baseo;
+int n, how;
+{
+  struct loc l;
+  int off, bit;
+  u32 v;
+
+  off = SEXT(rdop(offo, n), n);
+  locate(baseo, 1, A_RMW, &l);
+  if (l.type == L_REG) {
+    bit = off & 31;
+    v = proc.r[l.reg];
+  } else {
+    l.adr += off >> 3;
+    bit = off & 7;
+    v = vrd(l.adr, 1);
+  }
+  setflag(F_BIT, (v >> bit) & 1);
+  switch (how) {
+    case 0:	return;
+    case 1:	v |= 1 << bit; break;
+    case 2:	v &= ~(1 << bit); break;
+    case 3:	v ^= 1 << bit; break;
+  }
+  if (l.type == L_REG) proc.r[l.reg] = v;
+  else vwr(l.adr, 1, v);
+}
+
+/* Extract a field of len bits starting off bits into the base.
+ */
+static u32
+getfield(l, off, len)
+struct loc *l;
+int off, len;
+{
+  u32 lo, hi, adr, m;
+
+  m = (len == 32)? 0xffffffff: (1 << len) - 1;
+  if (l->type == L_REG) return (proc.r[l->reg] >> (off & 31)) & m;
+  adr = l->adr + (off >> 3);
+  off &= 7;
+  lo = vrd(adr, 4);
+  hi = (off + len > 32)? vrd(adr + 4, 1): 0;
+  return ((lo >> off) | (off? hi << (32 - off): 0)) & m;
+}
+
+static void
+putfield(l, off, len, val)
+struct loc *l;
+int off, len;
+u32 val;
+{
+  u32 lo, hi, adr, m;
+
+  m = (len == 32)? 0xffffffff: (1 << len) - 1;
+  val &= m;
+  if (l->type == L_REG) {
+    off &= 31;
+    proc.r[l->reg] = (proc.r[l->reg] & ~(m << off)) | (val << off);
+    return;
+  }
+  adr = l->adr + (off >> 3);
+  off &= 7;
+  lo = vrd(adr, 4);
+  lo = (lo & ~(m << off)) | (val << off);
+  vwr(adr, 4, lo);
+  if (off + len > 32) {
+    hi = vrd(adr + 4, 1);
+    hi = (hi & ~(m >> (32 - off))) | (val >> (32 - off));
+    vwr(adr + 4, 1, hi);
+  }
+}
+
+/*===========================================================================*
+ *				traps and calls				     *
+ *===========================================================================*/
+
+/* Fetch the dispatch table entry for vec and enter the handler.  In
+ * direct exception mode the table holds absolute addresses; otherwise
+ * it holds module descriptors.
+ */
+static void
+dispatch(vec)
+int vec;
+{
+  u32 desc;
+
+  desc = mem_rd(proc.intbase + 4 * vec, 4);
+  if (proc.cfg & CFG_DE) {
+    proc.pc = desc;
+    return;
+  }
+  proc.mod = desc & 0xffff;
+  proc.sb = vrd(proc.mod, 4);
+  proc.pc = vrd(proc.mod + 8, 4) + (desc >> 16);
+}
+
+/* Take a trap or interrupt.  PSR and MOD go on the interrupt stack,
+ * then the return address.
+ */
+void
+cpu_trap(vec, retpc, irq)
+int vec, irq;
+u32 retpc;
+{
+  u32 psr;
+
+  psr = proc.psr;
+  proc.psr &= ~(S_BIT | U_BIT | T_BIT | P_BIT);
+  if (irq) proc.psr &= ~I_BIT;
+  push((psr << 16) | (proc.mod & 0xffff), 4);
+  push(retpc, 4);
+  dispatch(vec);
+}
+
+/* Call external procedure through descriptor desc.
+ */
+static void
+cxp(desc, retpc)
+u32 desc, retpc;
+{
+  push(proc.mod & 0xffff, 4);
+  push(retpc, 4);
+  proc.mod = desc & 0xffff;
+  proc.sb = vrd(proc.mod, 4);
+  proc.pc = vrd(proc.mod + 8, 4) + (desc >> 16);
+}
+
+/* RETT and RETI.
+ */
+static void
+rett(disp)
+u32 disp;
+{
+  u32 w;
+
+  if (USER) trap(VEC_ILL);
+  proc.pc = pop(4);
+  w = pop(4);
+  proc.psr = w >> 16;
+  if (!(proc.cfg & CFG_DE)) {
+    proc.mod = w & 0xffff;
+    proc.sb = vrd(proc.mod, 4);
+  }
+  SP += disp;
+}
+
+/*===========================================================================*
+ *				dedicated registers			     *
+ *===========================================================================*/
+
+static u32 *
+areg(reg)
+int reg;
+{
+  switch (reg) {
+    case REG_DCR:	return &proc.dcr;
+    case REG_DSR:	return &proc.dsr;
+    case REG_CAR:	return &proc.car;
+    case REG_BPC:	return &proc.bpc;
+    case REG_FP:	return &proc.fp;
+    case REG_SP:	return &SP;
+    case REG_SB:	return &proc.sb;
+    case REG_USP:	return &proc.sp1;
+    case REG_CFG:	return &proc.cfg;
+    case REG_PSR:	return &proc.psr;
+    case REG_UPSR:	return &proc.psr;
+    case REG_INTBASE:	return &proc.intbase;
+    case REG_MOD:	return &proc.mod;
+    case REG_PTB0:	return &proc.ptb0;
+    case REG_PTB1:	return &proc.ptb1;
+    case REG_TEAR:	return &proc.tear;
+    case REG_MCR:	return &proc.mcr;
+    case REG_MSR:	return &proc.msr;
+  }
+  trap(VEC_UND);
+  return NULL;				/* not reached */
+}
+
+/* LPR: privileged registers may not be loaded from user mode.
+ */
+static void
+lpr(reg, n, val)
+int reg, n;
+u32 val;
+{
+  u32 *p;
+
+  if (USER && reg != REG_UPSR && reg != REG_FP && reg != REG_SP &&
+    reg != REG_SB && reg != REG_MOD)
+    trap(VEC_ILL);
+  p = areg(reg);
+  if (reg == REG_UPSR) n = 1;
+  if (reg == REG_PSR || reg == REG_MOD || reg == REG_CFG)
+    n = n > 2? 2: n;
+  *p = (*p & ~szmask[n]) | (val & szmask[n]);
+}
+
+/*===========================================================================*
+ *				formats					     *
+ *===========================================================================*/
+
+static void
+fmt1(i, len)
+struct insn *i;
+int len;
+{
+  u32 next = proc.ipc + len, w;
+  int r;
+
+  switch (i->i_op) {
+    case F1_BSR:
+      push(next, 4);
+      proc.pc = proc.ipc + i->i_opr[0].o_disp0;
+      break;
+    case F1_RET:
+      proc.pc = pop(4);
+      SP += i->i_opr[0].o_disp0;
+      break;
+    case F1_CXP:
+      w = vrd(vrd(proc.mod + 4, 4) + 4 * i->i_opr[0].o_disp0, 4);
+      cxp(w, next);
+      break;
+    case F1_RXP:
+      proc.pc = pop(4);
+      proc.mod = pop(4) & 0xffff;
+      proc.sb = vrd(proc.mod, 4);
+      SP += i->i_opr[0].o_disp0;
+      break;
+    case F1_RETI:
+      dev_reti();
+      /* fall through */
+    case F1_RETT:
+      rett(i->i_op == F1_RETT? (u32)i->i_opr[0].o_disp0: 0);
+      break;
+    case F1_SAVE:
+      for (r = 0; r < 8; ++r)
+	if (i->i_opr[0].o_reg0 & (1 << r)) push(proc.r[r], 4);
+      break;
+    case F1_RESTORE:
+      for (r = 7; r >= 0; --r)
+	if (i->i_opr[0].o_reg0 & (1 << r)) proc.r[r] = pop(4);
+      break;
+    case F1_ENTER:
+      push(proc.fp, 4);
+      proc.fp = SP;
+      SP -= i->i_opr[1].o_disp0;
+      for (r = 0; r < 8; ++r)
+	if (i->i_opr[0].o_reg0 & (1 << r)) push(proc.r[r], 4);
+      break;
+    case F1_EXIT:
+      for (r = 7; r >= 0; --r)
+	if (i->i_opr[0].o_reg0 & (1 << r)) proc.r[r] = pop(4);
+      SP = proc.fp;
+      proc.fp = pop(4);
+      break;
+    case F1_NOP:
+    case F1_DIA:
+      break;
+    case F1_WAIT:
+      if (dev_irq() < 0 || !(proc.psr & I_BIT)) proc.halted = 1;
+      break;
+    case F1_FLAG:
+      if (proc.psr & F_BIT) trap(VEC_FLG);
+      break;
+    case F1_SVC:
+      trap(VEC_SVC);
+      break;
+    case F1_BPT:
+      trap(VEC_BPT);
+  }
+}
+
+static void
+fmt2(i, raw)
+struct insn *i;
+unsigned char *raw;
+{
+  struct loc l;
+  int n = i->i_iol;
+  u32 v, q;
+
+  q = i->i_opr[0].o_disp0;
+  switch (i->i_op) {
+    case F2_ADDQ:
+      locate(&i->i_opr[1], n, A_RMW, &l);
+      wrloc(&l, n, add(q, rdloc(&l, n), 0, n));
+      break;
+    case F2_CMPQ:
+      compare(q, rdop(&i->i_opr[1], n), n);
+      break;
+    case F2_SPR:
+      v = *areg(i->i_opr[0].o_reg0);
+      if (i->i_opr[0].o_reg0 == REG_UPSR) v &= 0xff;
+      wrop(&i->i_opr[1], n, v);
+      break;
+    case F2_SCOND:
+      wrop(&i->i_opr[0], n,
+	(u32)cond(((raw[0] & 0x80) >> 7) + ((raw[1] & 0x7) << 1)));
+      break;
+    case F2_ACB:
+      locate(&i->i_opr[1], n, A_RMW, &l);
+      v = (rdloc(&l, n) + q) & szmask[n];
+      wrloc(&l, n, v);
+      if (v != 0) proc.pc = proc.ipc + i->i_opr[2].o_disp0;
+      break;
+    case F2_MOVQ:
+      wrop(&i->i_opr[1], n, q);
+      break;
+    case F2_LPR:
+      lpr(i->i_opr[0].o_reg0, n, rdop(&i->i_opr[1], n));
+      break;
+  }
+}
+
+static void
+fmt3(i, len)
+struct insn *i;
+int len;
+{
+  int n = i->i_iol;
+  u32 v;
+
+  switch (i->i_op) {
+    case F3_CXPD:
+      cxp(rdop(&i->i_opr[0], 4), proc.ipc + len);
+      break;
+    case F3_BICPSR:
+    case F3_BISPSR:
+      v = rdop(&i->i_opr[0], n);
+      if (USER && n > 1) trap(VEC_ILL);
+      if (i->i_op == F3_BICPSR) proc.psr &= ~v;
+      else proc.psr |= v;
+      break;
+    case F3_JUMP:
+      proc.pc = adrop(&i->i_opr[0]);
+      break;
+    case F3_ADJSP:
+      SP -= SEXT(rdop(&i->i_opr[0], n), n);
+      break;
+    case F3_JSR:
+      v = adrop(&i->i_opr[0]);
+      push(proc.ipc + len, 4);
+      proc.pc = v;
+      break;
+    case F3_CASE:
+      proc.pc = proc.ipc + SEXT(rdop(&i->i_opr[0], n), n);
+      break;
+    default:
+      trap(VEC_UND);
+  }
+}
+
+static void
+fmt4(i)
+struct insn *i;
+{
+  struct loc l;
+  int n = i->i_iol;
+  u32 s;
+
+  switch (i->i_op) {
+    case F4_CMP:
+      s = rdop(&i->i_opr[0], n);
+      compare(s, rdop(&i->i_opr[1], n), n);
+      return;
+    case F4_MOV:
+      wrop(&i->i_opr[1], n, rdop(&i->i_opr[0], n));
+      return;
+    case F4_ADDR:
+      s = adrop(&i->i_opr[0]);
+      wrop(&i->i_opr[1], 4, s);
+      return;
+    case F4_TBIT:
+      bitop(&i->i_opr[0], &i->i_opr[1], n, 0);
+      return;
+  }
+  s = rdop(&i->i_opr[0], n);
+  locate(&i->i_opr[1], n, A_RMW, &l);
+  switch (i->i_op) {
+    case F4_ADD:  wrloc(&l, n, add(rdloc(&l, n), s, 0, n)); break;
+    case F4_ADDC: wrloc(&l, n, add(rdloc(&l, n), s,
+		    (proc.psr & C_BIT)? 1: 0, n)); break;
+    case F4_SUB:  wrloc(&l, n, sub(rdloc(&l, n), s, 0, n)); break;
+    case F4_SUBC: wrloc(&l, n, sub(rdloc(&l, n), s,
+		    (proc.psr & C_BIT)? 1: 0, n)); break;
+    case F4_BIC:  wrloc(&l, n, rdloc(&l, n) & ~s); break;
+    case F4_OR:   wrloc(&l, n, rdloc(&l, n) | s); break;
+    case F4_AND:  wrloc(&l, n, rdloc(&l, n) & s); break;
+    case F4_XOR:  wrloc(&l, n, rdloc(&l, n) ^ s); break;
+    default:	  trap(VEC_UND);
+  }
+}
+
+/* String instructions.  R0 count, R1 source, R2 destination, R3
+ * translation table, R4 match value.
+ */
+static void
+fmt5(i)
+struct insn *i;
+{
+  int n = i->i_iol, opt, back, uw;
+  u32 a, b;
+
+  opt = i->i_opr[0].o_disp0;
+  if (i->i_op == F5_SETCFG) {
+    if (USER) trap(VEC_ILL);
+    proc.cfg = (proc.cfg & ~0xf) | (opt & 0xf);
+    return;
+  }
+  back = opt & 2;
+  uw = (opt >> 2) & 3;			/* 1 while, 3 until */
+  proc.psr &= ~F_BIT;
+  if (i->i_op == F5_CMPS) proc.psr |= Z_BIT;
+  while (proc.r[0] != 0) {
+    a = vrd(proc.r[1], n);
+    if (opt & 1) a = vrd(proc.r[3] + (a & 0xff), 1);
+    if ((uw == 1 && a != (proc.r[4] & szmask[n])) ||
+      (uw == 3 && a == (proc.r[4] & szmask[n]))) {
+      proc.psr |= F_BIT;
+      return;
+    }
+    if (i->i_op == F5_MOVS) vwr(proc.r[2], n, a);
+    else if (i->i_op == F5_CMPS) {
+      b = vrd(proc.r[2], n);
+      compare(a, b, n);
+      if (a != b) return;
+    }
+    proc.r[1] += back? -n: n;
+    if (i->i_op != F5_SKPS) proc.r[2] += back? -n: n;
+    --proc.r[0];
+  }
+}
+
+static void
+fmt6(i, raw)
+struct insn *i;
+unsigned char *raw;
+{
+  struct loc l;
+  int n, cnt;
+  u32 s, d;
+
+  n = IOL(raw[1]);
+  switch (i->i_op) {
+    case F6_CBIT: case F6_CBITI:
+      bitop(&i->i_opr[0], &i->i_opr[1], n, 2);
+      return;
+    case F6_SBIT: case F6_SBITI:
+      bitop(&i->i_opr[0], &i->i_opr[1], n, 1);
+      return;
+    case F6_IBIT:
+      bitop(&i->i_opr[0], &i->i_opr[1], n, 3);
+      return;
+    case F6_ROT: case F6_ASH: case F6_LSH:
+      cnt = SEXT(rdop(&i->i_opr[0], 1), 1);
+      locate(&i->i_opr[1], n, A_RMW, &l);
+      d = rdloc(&l, n);
+      if (i->i_op == F6_ROT) {
+	cnt %= 8 * n;
+	if (cnt < 0) cnt += 8 * n;
+	if (cnt) d = (d << cnt) | (d >> (8 * n - cnt));
+      } else if (cnt >= 0) d = cnt >= 32? 0: d << cnt;
+      else if (i->i_op == F6_LSH) d = -cnt >= 32? 0: d >> -cnt;
+      else d = (u32)(SEXT(d, n) >> (-cnt >= 32? 31: -cnt));
+      wrloc(&l, n, d);
+      return;
+  }
+  s = rdop(&i->i_opr[0], n);
+  if (i->i_op == F6_ADDP || i->i_op == F6_SUBP) {
+    locate(&i->i_opr[1], n, A_RMW, &l);
+    wrloc(&l, n, bcd(s, rdloc(&l, n), n, i->i_op == F6_SUBP));
+    return;
+  }
+  switch (i->i_op) {
+    case F6_NEG:
+      setflag(F_BIT, (s & szmask[n]) == szsign[n]);
+      setflag(C_BIT, (s & szmask[n]) != 0);
+      d = -s;
+      break;
+    case F6_ABS:
+      setflag(F_BIT, (s & szmask[n]) == szsign[n]);
+      d = SEXT(s, n) < 0? -s: s;
+      break;
+    case F6_NOT:
+      d = s ^ 1;
+      break;
+    case F6_COM:
+      d = ~s;
+      break;
+    default:
+      trap(VEC_UND);
+  }
+  wrop(&i->i_opr[1], n, d);
+}
+
+static void
+fmt7(i)
+struct insn *i;
+{
+  struct loc l, h;
+  int n = i->i_iol, len, k;
+  u32 s, d, a, b;
+  unsigned long long q;
+  long long x, y, r;
+
+  switch (i->i_op) {
+    case F7_MOVM:
+    case F7_CMPM:
+      a = adrop(&i->i_opr[0]);
+      b = adrop(&i->i_opr[1]);
+      len = i->i_opr[2].o_disp0 + n;
+      if (i->i_op == F7_CMPM) proc.psr |= Z_BIT;
+      for (k = 0; k < len; k += n) {
+	s = vrd(a + k, n);
+	if (i->i_op == F7_MOVM) vwr(b + k, n, s);
+	else {
+	  d = vrd(b + k, n);
+	  compare(s, d, n);
+	  if (s != d) break;
+	}
+      }
+      return;
+    case F7_INSS:
+      s = rdop(&i->i_opr[0], n);
+      locate(&i->i_opr[1], 1, A_RMW, &l);
+      putfield(&l, i->i_opr[2].o_disp0, i->i_opr[3].o_disp0, s);
+      return;
+    case F7_EXTS:
+      locate(&i->i_opr[0], 1, A_RMW, &l);
+      s = getfield(&l, i->i_opr[2].o_disp0, i->i_opr[3].o_disp0);
+      wrop(&i->i_opr[1], n, s);
+      return;
+    case F7_MOVXBW:
+      wrop(&i->i_opr[1], 2, (u32)SEXT(rdop(&i->i_opr[0], n), n));
+      return;
+    case F7_MOVZBW:
+      wrop(&i->i_opr[1], 2, rdop(&i->i_opr[0], n));
+      return;
+    case F7_MOVZD:
+      wrop(&i->i_opr[1], 4, rdop(&i->i_opr[0], n));
+      return;
+    case F7_MOVXD:
+      wrop(&i->i_opr[1], 4, (u32)SEXT(rdop(&i->i_opr[0], n), n));
+      return;
+    case F7_MEI:
+    case F7_DEI:
+      s = rdop(&i->i_opr[0], n);
+      locate(&i->i_opr[1], n, A_RMW, &l);
+      h = l;
+      if (l.type == L_REG) h.reg = l.reg + 1;
+      else h.adr = l.adr + n;
+      if (i->i_op == F7_MEI) {
+	q = (unsigned long long)rdloc(&l, n) * s;
+	wrloc(&l, n, (u32)q);
+	wrloc(&h, n, (u32)(q >> (8 * n)));
+	return;
+      }
+      if ((s & szmask[n]) == 0) trap(VEC_DVZ);
+      q = ((unsigned long long)rdloc(&h, n) << (8 * n)) | rdloc(&l, n);
+      wrloc(&l, n, (u32)(q % s));
+      wrloc(&h, n, (u32)(q / s));
+      return;
+  }
+  s = rdop(&i->i_opr[0], n);
+  locate(&i->i_opr[1], n, A_RMW, &l);
+  d = rdloc(&l, n);
+  if (i->i_op == F7_MUL) {
+    wrloc(&l, n, d * s);
+    return;
+  }
+  x = SEXT(d, n);
+  y = SEXT(s, n);
+  if (y == 0) trap(VEC_DVZ);
+  switch (i->i_op) {
+    case F7_QUO: r = x / y; break;
+    case F7_REM: r = x % y; break;
+    case F7_DIV:
+      r = x / y;
+      if ((x % y) != 0 && ((x < 0) != (y < 0))) --r;
+      break;
+    case F7_MOD:
+      r = x % y;
+      if (r != 0 && ((r < 0) != (y < 0))) r += y;
+      break;
+    default:
+      trap(VEC_UND);
+  }
+  wrloc(&l, n, (u32)r);
+}
+
+static void
+fmt8(i)
+struct insn *i;
+{
+  struct loc l;
+  int n = i->i_iol, off;
+  u32 v, lo, hi;
+
+  switch (i->i_op) {
+    case F8_EXT:
+      off = proc.r[i->i_opr[0].o_reg0 - REG_R0];
+      locate(&i->i_opr[1], 1, A_RMW, &l);
+      v = getfield(&l, off, (int)i->i_opr[3].o_disp0);
+      wrop(&i->i_opr[2], n, v);
+      break;
+    case F8_INS:
+      off = proc.r[i->i_opr[0].o_reg0 - REG_R0];
+      v = rdop(&i->i_opr[1], n);
+      locate(&i->i_opr[2], 1, A_RMW, &l);
+      putfield(&l, off, (int)i->i_opr[3].o_disp0, v);
+      break;
+    case F8_CVTP:
+      v = adrop(&i->i_opr[1]) * 8 + proc.r[i->i_opr[0].o_reg0 - REG_R0];
+      wrop(&i->i_opr[2], 4, v);
+      break;
+    case F8_CHECK:
+      locate(&i->i_opr[1], n, A_ADDR, &l);
+      hi = vrd(l.adr, n);
+      lo = vrd(l.adr + n, n);
+      v = rdop(&i->i_opr[2], n);
+      if (SEXT(v, n) < SEXT(lo, n) || SEXT(v, n) > SEXT(hi, n))
+	proc.psr |= F_BIT;
+      else {
+	proc.psr &= ~F_BIT;
+	proc.r[i->i_opr[0].o_reg0 - REG_R0] = v - lo;
+      }
+      break;
+    case F8_INDEX:
+      lo = rdop(&i->i_opr[1], n);
+      v = rdop(&i->i_opr[2], n);
+      off = i->i_opr[0].o_reg0 - REG_R0;
+      proc.r[off] = proc.r[off] * (SEXT(lo, n) + 1) + SEXT(v, n);
+      break;
+    case F8_FFS:
+      v = rdop(&i->i_opr[0], n);
+      locate(&i->i_opr[1], 1, A_RMW, &l);
+      for (off = rdloc(&l, 1) & 0xff; off < 8 * n; ++off)
+	if (v & (1 << off)) break;
+      if (off < 8 * n) {
+	proc.psr &= ~F_BIT;
+	wrloc(&l, 1, (u32)off);
+      } else {
+	proc.psr |= F_BIT;
+	wrloc(&l, 1, 0);
+      }
+      break;
+    case F8_MOVUS:			/* no separate user space here */
+      wrop(&i->i_opr[2], n, rdop(&i->i_opr[1], n));
+      break;
+    default:
+      trap(VEC_UND);
+  }
+}
+
+/* Floating point: just enough to save and restore the register file.
+ */
+static void
+fmtfp(i, raw)
+struct insn *i;
+unsigned char *raw;
+{
+  struct loc s, d;
+  u32 lo, hi;
+  int single;
+
+  if (!(proc.cfg & CFG_F)) trap(VEC_UND);
+  if (i->i_format == ITYPE_FMT9) {
+    if (i->i_op == F9_LFSR) proc.fsr = rdop(&i->i_opr[0], 4);
+    else if (i->i_op == F9_SFSR) wrop(&i->i_opr[0], 4, proc.fsr);
+    else trap(VEC_UND);
+    return;
+  }
+  if (i->i_format != ITYPE_FMT11 || i->i_op != F11_MOV) trap(VEC_UND);
+  single = FMT11_F(raw[1]);
+  locate(&i->i_opr[0], single? 4: 8, A_READ, &s);
+  locate(&i->i_opr[1], single? 4: 8, A_WRITE, &d);
+  if (s.type == L_FREG) {
+    lo = proc.f[2 * s.reg];
+    hi = proc.f[2 * s.reg + 1];
+  } else if (s.type == L_MEM) {
+    lo = vrd(s.adr, 4);
+    hi = single? 0: vrd(s.adr + 4, 4);
+  } else trap(VEC_UND);
+  if (d.type == L_FREG) {
+    proc.f[2 * d.reg] = lo;
+    if (!single) proc.f[2 * d.reg + 1] = hi;
+  } else if (d.type == L_MEM) {
+    vwr(d.adr, 4, lo);
+    if (!single) vwr(d.adr + 4, 4, hi);
+  } else trap(VEC_UND);
+}
+static void
+fmt14(i)
+struct insn *i;
+{
+  if (USER) trap(VEC_ILL);
+  switch (i->i_op) {
+    case F14_LMR:
+      *areg(i->i_opr[0].o_reg0) = rdop(&i->i_opr[1], 4);
+      break;
+    case F14_SMR:
+      wrop(&i->i_opr[1], 4, *areg(i->i_opr[0].o_reg0));
+      break;
+    case F14_RDVAL:
+    case F14_WRVAL:
+      (void)adrop(&i->i_opr[0]);
+      proc.psr &= ~F_BIT;
+      break;
+    case F14_CINV:
+      (void)adrop(&i->i_opr[1]);
+      break;
+    default:
+      trap(VEC_UND);
+  }
+}
+
+/*===========================================================================*
+ *				decode and step				     *
+ *===========================================================================*/
+
+void
+dcache_flush()
+{
+  struct dcache *d;
+
+  for (d = dcache; d < dcache + DCACHE_SIZE; ++d) d->len = 0;
+  memset(codepage, 0, RAM_SIZE >> PAGE_SHIFT);
+}
+
+/* Forget decoded instructions in a RAM page which is being written.
+ */
+void
+dcache_inval(page)
+u32 page;
+{
+  struct dcache *d;
+  u32 adr;
+
+  for (adr = page << PAGE_SHIFT; adr < (page + 1) << PAGE_SHIFT; ++adr) {
+    d = dcache + (adr & (DCACHE_SIZE - 1));
+    if (d->len != 0 && (d->adr >> PAGE_SHIFT) == page) d->len = 0;
+  }
+  codepage[page] = 0;
+}
+
+/* Look up or decode the instruction at physical address adr.
+ */
+static struct dcache *
+decode(adr)
+u32 adr;
+{
+  struct dcache *d;
+  int k;
+
+  d = dcache + (adr & (DCACHE_SIZE - 1));
+  if (d->len != 0 && d->adr == adr) return d;
+  if (mem_fetch(adr, d->raw, MAX_INSN_LEN) < 0) {
+    d->len = 0;
+    trap(VEC_ABT);
+  }
+  initInsn(&d->insn);
+  d->len = dasm_ns32k(&d->insn, d->raw);
+  for (k = 0; k < 4; ++k) {		/* displacements are 32 bits */
+    d->insn.i_opr[k].o_disp0 = (int)d->insn.i_opr[k].o_disp0;
+    d->insn.i_opr[k].o_disp1 = (int)d->insn.i_opr[k].o_disp1;
+  }
+  d->adr = adr;
+  if (adr < RAM_SIZE) codepage[adr >> PAGE_SHIFT] = 1;
+  return d;
+}
+
+static void
+print_trace(d)
+struct dcache *d;
+{
+  char text[128];
+  struct insn insn;
+
+  insn = d->insn;
+  formatAsm(&insn, text);
+  fprintf(stderr, "%08x %04x  %s\n", proc.ipc, proc.psr & 0xffff, text);
+}
+
+/* Execute one instruction, or take one interrupt.  Returns the trap
+ * vector taken, or -1.
+ */
+int
+cpu_step()
+{
+  struct dcache *d;
+  struct insn *i;
+  int vec;
+  u32 pa, psr;
+
+  if ((proc.psr & I_BIT) && (vec = dev_irq()) >= 0) {
+    proc.halted = 0;
+    cpu_trap(vec, proc.pc, 1);
+    return vec;
+  }
+  if (proc.halted) return -1;
+  proc.ipc = proc.pc;
+  psr = proc.psr;
+  if (psr & T_BIT) proc.psr |= P_BIT;
+  if (setjmp(trap_jb)) {
+    if (trap_vec == VEC_ABT) {
+      proc.psr = psr;			/* restartable */
+      proc.msr = 1;
+    }
+    proc.psr &= ~P_BIT;
+    cpu_trap(trap_vec, proc.ipc, 0);
+    return trap_vec;
+  }
+  pa = TRANSLATING? translate(proc.ipc, USER): proc.ipc;
+  d = decode(pa);
+  i = &d->insn;
+  if (trace) print_trace(d);
+  proc.pc = proc.ipc + d->len;
+  ++proc.icount;
+  switch (i->i_format) {
+    case ITYPE_FMT0:
+      if (cond(i->i_op)) proc.pc = proc.ipc + i->i_opr[0].o_disp0;
+      break;
+    case ITYPE_FMT1:	fmt1(i, d->len); break;
+    case ITYPE_FMT2:	fmt2(i, d->raw); break;
+    case ITYPE_FMT3:	fmt3(i, d->len); break;
+    case ITYPE_FMT4:	fmt4(i); break;
+    case ITYPE_FMT5:	fmt5(i); break;
+    case ITYPE_FMT6:	fmt6(i, d->raw); break;
+    case ITYPE_FMT7:	fmt7(i); break;
+    case ITYPE_FMT8:	fmt8(i); break;
+    case ITYPE_FMT9:
+    case ITYPE_FMT11:
+    case ITYPE_FMT12:	fmtfp(i, d->raw); break;
+    case ITYPE_NOP:	break;
+    case ITYPE_FMT14:	fmt14(i); break;
+    default:		trap(VEC_UND);
+  }
+  if (proc.psr & P_BIT) {
+    proc.psr &= ~P_BIT;
+    cpu_trap(VEC_TRC, proc.pc, 0);
+    return VEC_TRC;
+  }
+  return -1;
+}
+
+/* Power on: PC, PSR and CFG are zero, the ROM appears at 0.
+ */
+void
+cpu_reset()
+{
+  memset(&proc, 0, sizeof proc);
+}
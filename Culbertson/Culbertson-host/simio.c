@@ -0,0 +1,827 @@
+/* NS32000 host simulator.
+ *
+ * Memory and devices: RAM, ROM, the four SCN2681 DUARTs, the NS32202 ICU
+ * and the DP8490 SCSI controller with simulated disks behind it.  Only
+ * the parts of each chip which the monitor and Minix drivers touch are
+ * done.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim32k.h"
+
+#define PAGE_SHIFT	12
+
+static unsigned char *ram, rom[ROM_MAX];
+static int rom_at_zero;			/* ICU port G0 not yet cleared */
+static u32 rom_len;
+
+static int io_rd();
+static void io_wr();
+
+/*===========================================================================*
+ *				memory					     *
+ *===========================================================================*/
+
+void
+mem_init()
+{
+  if (ram == NULL) {
+    ram = (unsigned char *)calloc(RAM_SIZE, 1);
+    codepage = (char *)calloc(RAM_SIZE >> PAGE_SHIFT, 1);
+    if (ram == NULL || codepage == NULL) {
+      fprintf(stderr, "sim: out of memory\n");
+      exit(1);
+    }
+  }
+  rom_at_zero = 1;
+}
+
+int
+mem_rd8(adr)
+u32 adr;
+{
+  if (adr < RAM_SIZE) {
+    if (rom_at_zero && adr < ROM_MAX) return rom[adr];
+    return ram[adr];
+  }
+  if (adr - ROM_ADR < ROM_MAX) return rom[adr - ROM_ADR];
+  return io_rd(adr);
+}
+
+/* Read n bytes, least significant first.
+ */
+u32
+mem_rd(adr, n)
+u32 adr;
+int n;
+{
+  unsigned char *p;
+  u32 val;
+  int i;
+
+  if (adr < RAM_SIZE - 4 && !rom_at_zero) p = ram + adr;
+  else if (adr - ROM_ADR < ROM_MAX - 4) p = rom + (adr - ROM_ADR);
+  else {
+    for (val = 0, i = 0; i < n; ++i)
+      val |= (u32)mem_rd8(adr + i) << (8 * i);
+    return val;
+  }
+  switch (n) {
+    case 1:	return p[0];
+    case 2:	return p[0] | p[1] << 8;
+  }
+  return p[0] | p[1] << 8 | p[2] << 16 | (u32)p[3] << 24;
+}
+
+int
+mem_wr(adr, n, val)
+u32 adr, val;
+int n;
+{
+  int i;
+
+  for (i = 0; i < n; ++i, ++adr, val >>= 8) {
+    if (adr < RAM_SIZE) {
+      ram[adr] = val;
+      if (codepage[adr >> PAGE_SHIFT]) dcache_inval(adr >> PAGE_SHIFT);
+    } else if (adr - ROM_ADR >= ROM_MAX) io_wr(adr, (int)(val & 0xff));
+  }
+  return 0;
+}
+
+/* Copy up to len bytes of instruction stream.  Returns -1 if adr is
+ * not memory.
+ */
+int
+mem_fetch(adr, buf, len)
+u32 adr;
+unsigned char *buf;
+int len;
+{
+  int i;
+
+  if (adr >= RAM_SIZE && adr - ROM_ADR >= ROM_MAX) return -1;
+  for (i = 0; i < len; ++i)
+    buf[i] = (adr + i < RAM_SIZE || adr + i - ROM_ADR < ROM_MAX)?
+      mem_rd8(adr + i): 0;
+  return 0;
+}
+
+/* Load an Intel hex ROM image, as made by the image.hex rule in the
+ * monitor Makefile.  Addresses are offsets into the ROM.
+ */
+int
+rom_load_hex(name)
+char *name;
+{
+  FILE *f;
+  char line[600];
+  unsigned int cnt, adr, type, b, sum;
+  int i, lineno = 0;
+
+  if ((f = fopen(name, "r")) == NULL) {
+    perror(name);
+    return -1;
+  }
+  memset(rom, 0xff, sizeof rom);
+  rom_len = 0;
+  while (fgets(line, sizeof line, f) != NULL) {
+    ++lineno;
+    if (line[0] != ':') continue;
+    if (sscanf(line + 1, "%2x%4x%2x", &cnt, &adr, &type) != 3) goto bad;
+    sum = cnt + (adr >> 8) + (adr & 0xff) + type;
+    for (i = 0; i <= cnt; ++i) {
+      if (sscanf(line + 9 + 2 * i, "%2x", &b) != 1) goto bad;
+      sum += b;
+      if (i < cnt && type == 0 && adr + i < ROM_MAX) rom[adr + i] = b;
+    }
+    if ((sum & 0xff) != 0) goto bad;
+    if (type == 0 && adr + cnt > rom_len) rom_len = adr + cnt;
+    if (type == 1) break;
+  }
+  fclose(f);
+  return 0;
+bad:
+  fprintf(stderr, "%s: line %d: bad record\n", name, lineno);
+  fclose(f);
+  return -1;
+}
+
+/*===========================================================================*
+ *				SCN2681					     *
+ *===========================================================================*/
+
+/* Per channel status and interrupt bits.
+ */
+#define SR_RXRDY	0x01
+#define SR_TXRDY	0x04
+#define SR_TXEMT	0x08
+#define ISR_TXRDYA	0x01
+#define ISR_RXRDYA	0x02
+
+struct uart {
+  FILE *in, *out;			/* NULL if not connected */
+  int rx;				/* received char or -1 */
+  int eof;				/* input exhausted */
+  int mrp;				/* MR1/MR2 pointer */
+  unsigned char mr[2];
+  int enabled;				/* CR rx/tx enable bits */
+};
+
+struct duart {
+  struct uart u[2];
+  unsigned char acr, imr, opcr, op;
+};
+
+/* Output routines may peek at the console for control-S or control-C,
+ * so only a long run of empty polls means the program wants input.
+ */
+#define IDLE_POLLS	100000
+
+static struct duart duart[4];
+static long con_polls;
+
+/* Connect uart 0, the console, to input and output files.
+ */
+void
+con_file(in, out)
+FILE *in, *out;
+{
+  duart[0].u[0].in = in;
+  duart[0].u[0].out = out;
+}
+
+/* True when the console has run out of input and the monitor is waiting
+ * for more.
+ */
+int
+con_idle()
+{
+  return con_polls > IDLE_POLLS;
+}
+
+static void
+uart_poll(u)
+struct uart *u;
+{
+  int c;
+
+  if (u->rx >= 0 || u->in == NULL || u->eof) return;
+  if (u->out != NULL) fflush(u->out);
+  if ((c = getc(u->in)) == EOF) u->eof = 1;
+  else u->rx = c;
+}
+
+static int
+duart_isr(d)
+struct duart *d;
+{
+  int isr = 0, i;
+
+  for (i = 0; i < 2; ++i) {
+    uart_poll(&d->u[i]);
+    isr |= ISR_TXRDYA << (4 * i);
+    if (d->u[i].rx >= 0) isr |= ISR_RXRDYA << (4 * i);
+  }
+  return isr;
+}
+
+static int
+duart_rd(d, reg)
+struct duart *d;
+int reg;
+{
+  struct uart *u = &d->u[reg >> 3];
+  int c;
+
+  switch (reg & 7) {
+    case 0:				/* MR1/MR2 */
+      c = u->mr[u->mrp];
+      u->mrp = 1;
+      return c;
+    case 1:				/* SR */
+      uart_poll(u);
+      if (u->rx >= 0) return SR_RXRDY | SR_TXRDY | SR_TXEMT;
+      if (u == &duart[0].u[0] && u->eof) ++con_polls;
+      return SR_TXRDY | SR_TXEMT;
+    case 3:				/* RHR */
+      uart_poll(u);
+      c = u->rx;
+      u->rx = -1;
+      return c & 0xff;
+    case 5:
+      return (reg == 5)? duart_isr(d): 0;	/* ISR */
+  }
+  return 0;
+}
+
+static void
+duart_wr(d, reg, val)
+struct duart *d;
+int reg, val;
+{
+  struct uart *u = &d->u[reg >> 3];
+
+  switch (reg) {
+    case 4:  d->acr = val; return;
+    case 5:  d->imr = val; return;
+    case 13: d->opcr = val; return;
+    case 14: d->op |= val; return;
+    case 15: d->op &= ~val; return;
+  }
+  switch (reg & 7) {
+    case 0:				/* MR1/MR2 */
+      u->mr[u->mrp] = val;
+      u->mrp = 1;
+      return;
+    case 2:				/* CR */
+      if ((val & 0x70) == 0x10) u->mrp = 0;
+      if ((val & 0x70) == 0x20) u->rx = -1;
+      if (val & 0x01) u->enabled |= 1;
+      if (val & 0x04) u->enabled |= 2;
+      return;
+    case 3:				/* THR */
+      if (u->out != NULL) putc(val, u->out);
+      con_polls = 0;
+      return;
+  }
+}
+
+/* Interrupt request from DUART d.
+ */
+static int
+duart_irq(d)
+int d;
+{
+  return duart[d].imr && (duart_isr(&duart[d]) & duart[d].imr);
+}
+
+/*===========================================================================*
+ *				NS32202					     *
+ *===========================================================================*/
+
+#define ICU_SVCT	1
+#define ICU_IMSK	10
+#define ICU_PDAT	19
+#define ICU_CCTL	22
+#define ICU_LCSV	24
+#define ICU_HCSV	26
+#define ICU_LCCV	28
+#define ICU_HCCV	30
+#define CCTL_CRUNL	0x04
+#define CCTL_CRUNH	0x08
+#define CCTL_CFNPS	0x40
+#define CCTL_CCON	0x80
+
+static unsigned char icu[32];
+static int scsi_irq();
+
+static int
+icu_rd(reg)
+int reg;
+{
+  return icu[reg];
+}
+
+static void
+icu_wr(reg, val)
+int reg, val;
+{
+  icu[reg] = val;
+  if (reg == ICU_PDAT && rom_at_zero && !(val & 1)) {
+    rom_at_zero = 0;			/* RAM now at 0 */
+    dcache_flush();
+  }
+  if (reg == ICU_LCSV + 1) {
+    icu[ICU_LCCV] = icu[ICU_LCSV];
+    icu[ICU_LCCV + 1] = icu[ICU_LCSV + 1];
+  } else if (reg == ICU_HCSV + 1) {
+    icu[ICU_HCCV] = icu[ICU_HCSV];
+    icu[ICU_HCCV + 1] = icu[ICU_HCSV + 1];
+  }
+}
+
+/* Count down the running counters by n clocks, reloading on underflow.
+ */
+static void
+icu_count(cv, sv, n)
+int cv, sv;
+long n;
+{
+  long v, start;
+
+  v = icu[cv] | icu[cv + 1] << 8;
+  start = (icu[sv] | icu[sv + 1] << 8) + 1;
+  v -= n;
+  if (v < 0) v = start - 1 - (-v - 1) % start;
+  icu[cv] = v;
+  icu[cv + 1] = v >> 8;
+}
+
+/* Both counters as one 32 bit counter, low half in L.
+ */
+static void
+icu_count32(n)
+long n;
+{
+  unsigned long v, start;
+
+  v = (unsigned long)(icu[ICU_LCCV] | icu[ICU_LCCV + 1] << 8 |
+    icu[ICU_HCCV] << 16) | (unsigned long)icu[ICU_HCCV + 1] << 24;
+  start = (unsigned long)(icu[ICU_LCSV] | icu[ICU_LCSV + 1] << 8 |
+    icu[ICU_HCSV] << 16) | (unsigned long)icu[ICU_HCSV + 1] << 24;
+  v = (v >= (unsigned long)n)? v - n: start - (n - v - 1);
+  icu[ICU_LCCV] = v;
+  icu[ICU_LCCV + 1] = v >> 8;
+  icu[ICU_HCCV] = v >> 16;
+  icu[ICU_HCCV + 1] = v >> 24;
+}
+
+/* Advance the counters by n clocks, taken as one per instruction, or
+ * n/4 through the prescaler.
+ */
+void
+dev_tick(n)
+long n;
+{
+  if (!(icu[ICU_CCTL] & CCTL_CFNPS)) n /= 4;	/* prescaler */
+  if (icu[ICU_CCTL] & CCTL_CCON) {
+    if (icu[ICU_CCTL] & CCTL_CRUNL) icu_count32(n);
+    return;
+  }
+  if (icu[ICU_CCTL] & CCTL_CRUNL) icu_count(ICU_LCCV, ICU_LCSV, n);
+  if (icu[ICU_CCTL] & CCTL_CRUNH) icu_count(ICU_HCCV, ICU_HCSV, n);
+}
+
+/* Vector of the highest priority unmasked interrupt, or -1.  Level
+ * sensitive; the device keeps its line up until serviced.
+ */
+int
+dev_irq()
+{
+  int lines, mask, i;
+
+  lines = 0;
+  for (i = 0; i < 4; ++i)
+    if (duart_irq(i)) lines |= 1 << IRQ_DUART(i);
+  if (scsi_irq()) lines |= 1 << IRQ_SCSI;
+  mask = icu[ICU_IMSK] | icu[ICU_IMSK + 1] << 8;
+  lines &= ~mask;
+  if (lines == 0) return -1;
+  for (i = 15; !(lines & (1 << i)); --i);
+  if (!(proc.cfg & CFG_I)) return VEC_NVI;
+  return (icu[ICU_SVCT] & 0xf0) | i;	/* bias | line */
+}
+
+void
+dev_reti()
+{
+}
+
+/*===========================================================================*
+ *				DP8490					     *
+ *===========================================================================*/
+
+/* Register bits, named as in Culbertson-mon/scsi.c
+ */
+#define SC_A_RST	0x80
+#define SC_A_SEL	0x04
+#define SC_S_SEL	0x02
+#define SC_S_REQ	0x20
+#define SC_S_BSY	0x40
+#define SC_S_BSYERR	0x04
+#define SC_S_PHASE	0x08
+#define SC_S_IRQ	0x10
+#define SC_S_DRQ	0x40
+#define SC_M_DMA	0x02
+#define SC_M_BSY	0x04
+
+#define PH_ODATA	0
+#define PH_IDATA	1
+#define PH_CMD		2
+#define PH_STAT		3
+#define PH_IMSG		7
+#define PH_NONE		8
+#define PH_IN(phase)	((phase) & 1)
+
+#define BLOCK_SIZE	512
+#define SENSE_LEN	24
+
+struct disk {
+  FILE *f;
+  u32 blocks;
+};
+
+static struct disk disk[8];
+
+static struct {
+  int phase;				/* target's bus phase */
+  int id;				/* selected target */
+  unsigned char icr, mode, tcr, odr;
+  int irq, bsyerr, mismatch;
+  unsigned char cmd[12];
+  int cmdlen;
+  unsigned char *buf;			/* data phase buffer */
+  u32 len, pos;
+  int writing;				/* data out is a WRITE */
+  u32 block;
+  unsigned char status, sense[SENSE_LEN];
+} sc;
+
+/* Attach a disk image at SCSI id.
+ */
+int
+scsi_attach(id, name)
+int id;
+char *name;
+{
+  FILE *f;
+
+  if (id < 0 || id > 7) return -1;
+  if ((f = fopen(name, "r+b")) == NULL) {
+    perror(name);
+    return -1;
+  }
+  fseek(f, 0L, 2);
+  disk[id].f = f;
+  disk[id].blocks = ftell(f) / BLOCK_SIZE;
+  return 0;
+}
+
+static void
+sc_bus_free()
+{
+  sc.phase = PH_NONE;
+  free(sc.buf);
+  sc.buf = NULL;
+  sc.len = sc.pos = 0;
+  if (sc.mode & SC_M_BSY) sc.bsyerr = sc.irq = 1;
+}
+
+/* Enter a phase with len bytes to transfer.
+ */
+static void
+sc_phase(phase, len)
+int phase;
+u32 len;
+{
+  sc.phase = phase;
+  sc.len = len;
+  sc.pos = 0;
+  if (phase == PH_STAT) sc.buf[0] = sc.status;
+  else if (phase == PH_IMSG) sc.buf[0] = 0;	/* command complete */
+}
+
+static void
+sc_check(key, code)
+int key, code;
+{
+  memset(sc.sense, 0, SENSE_LEN);
+  sc.sense[0] = 0x70;
+  sc.sense[2] = key;
+  sc.sense[7] = SENSE_LEN - 8;
+  sc.sense[12] = code;
+  sc.status = 2;			/* CHECK CONDITION */
+}
+
+/* The whole command has arrived.  Work out what the target does next.
+ */
+static void
+sc_execute()
+{
+  struct disk *d = &disk[sc.id];
+  u32 blk, cnt;
+  unsigned char *c = sc.cmd;
+
+  sc.status = 0;
+  blk = cnt = 0;
+  switch (c[0]) {
+    case 0x08: case 0x0a:		/* READ(6), WRITE(6) */
+      blk = (c[1] & 0x1f) << 16 | c[2] << 8 | c[3];
+      cnt = c[4]? c[4]: 256;
+      break;
+    case 0x28: case 0x2a:		/* READ(10), WRITE(10) */
+      blk = (u32)c[2] << 24 | c[3] << 16 | c[4] << 8 | c[5];
+      cnt = c[7] << 8 | c[8];
+      break;
+  }
+  free(sc.buf);
+  sc.buf = (unsigned char *)malloc(cnt * BLOCK_SIZE + 256);
+  sc.writing = 0;
+  switch (c[0]) {
+    case 0x00:				/* TEST UNIT READY */
+      break;
+    case 0x03:				/* REQUEST SENSE */
+      memcpy(sc.buf, sc.sense, SENSE_LEN);
+      memset(sc.sense, 0, SENSE_LEN);
+      sc_phase(PH_IDATA, (u32)(c[4] < SENSE_LEN? c[4]: SENSE_LEN));
+      return;
+    case 0x12:				/* INQUIRY */
+      memset(sc.buf, 0, 36);
+      sc.buf[4] = 31;
+      memcpy(sc.buf + 8, "SIM32K  DISK            0001", 28);
+      sc_phase(PH_IDATA, (u32)(c[4] < 36? c[4]: 36));
+      return;
+    case 0x25:				/* READ CAPACITY */
+      cnt = d->blocks - 1;
+      sc.buf[0] = cnt >> 24; sc.buf[1] = cnt >> 16;
+      sc.buf[2] = cnt >> 8; sc.buf[3] = cnt;
+      sc.buf[4] = 0; sc.buf[5] = 0;
+      sc.buf[6] = BLOCK_SIZE >> 8; sc.buf[7] = BLOCK_SIZE & 0xff;
+      sc_phase(PH_IDATA, 8L);
+      return;
+    case 0x08: case 0x28:
+    case 0x0a: case 0x2a:
+      if (blk + cnt > d->blocks) {
+	sc_check(5, 0x21);		/* LBA out of range */
+	break;
+      }
+      sc.block = blk;
+      if (c[0] == 0x0a || c[0] == 0x2a) {
+	sc.writing = 1;
+	sc_phase(PH_ODATA, cnt * BLOCK_SIZE);
+	return;
+      }
+      fseek(d->f, (long)blk * BLOCK_SIZE, 0);
+      if (fread(sc.buf, BLOCK_SIZE, cnt, d->f) != cnt) {
+	sc_check(3, 0x11);		/* unrecovered read error */
+	break;
+      }
+      sc_phase(PH_IDATA, cnt * BLOCK_SIZE);
+      return;
+    default:
+      sc_check(5, 0x20);		/* invalid command */
+      break;
+  }
+  sc_phase(PH_STAT, 1L);
+}
+
+/* The current phase has moved all its bytes.
+ */
+static void
+sc_next_phase()
+{
+  struct disk *d = &disk[sc.id];
+
+  switch (sc.phase) {
+    case PH_CMD:
+      sc_execute();
+      return;
+    case PH_ODATA:
+      if (sc.writing) {
+	fseek(d->f, (long)sc.block * BLOCK_SIZE, 0);
+	if (fwrite(sc.buf, 1, sc.len, d->f) != sc.len) sc_check(3, 0x03);
+	fflush(d->f);
+      }
+      /* fall through */
+    case PH_IDATA:
+      sc_phase(PH_STAT, 1L);
+      return;
+    case PH_STAT:
+      sc_phase(PH_IMSG, 1L);
+      return;
+    case PH_IMSG:
+      sc_bus_free();
+      return;
+  }
+}
+
+/* Length of a command from its group code.
+ */
+static int
+sc_cdb_len(op)
+int op;
+{
+  switch (op >> 5) {
+    case 0:		return 6;
+    case 1: case 2:	return 10;
+    case 5:		return 12;
+  }
+  return 6;
+}
+
+static int
+sc_req()
+{
+  return sc.phase != PH_NONE && sc.pos < sc.len;
+}
+
+/* Latch an interrupt when the target asks for a phase the initiator is
+ * not expecting.
+ */
+static void
+sc_update()
+{
+  int mismatch;
+
+  mismatch = (sc.mode & SC_M_DMA) && sc_req() && (sc.tcr & 7) != sc.phase;
+  if (mismatch && !sc.mismatch) sc.irq = 1;
+  sc.mismatch = mismatch;
+}
+
+static int
+scsi_irq()
+{
+  return sc.irq;
+}
+
+static int
+sc_rd(reg)
+int reg;
+{
+  int v;
+
+  switch (reg) {
+    case 0:				/* current data */
+      return (sc.phase != PH_NONE && sc.pos < sc.len && PH_IN(sc.phase))?
+	sc.buf[sc.pos]: 0;
+    case 1:
+      return sc.icr;
+    case 2:
+      return sc.mode;
+    case 3:
+      return sc.tcr;
+    case 4:				/* bus status */
+      v = 0;
+      if (sc.phase != PH_NONE) v |= SC_S_BSY | (sc.phase & 7) << 2;
+      if (sc_req()) v |= SC_S_REQ;
+      if (sc.icr & SC_A_SEL) v |= SC_S_SEL;
+      return v;
+    case 5:				/* bus and status */
+      v = 0;
+      if ((sc.tcr & 7) == sc.phase) {
+	v |= SC_S_PHASE;
+	if ((sc.mode & SC_M_DMA) && sc_req()) v |= SC_S_DRQ;
+      }
+      if (sc.irq) v |= SC_S_IRQ;
+      if (sc.bsyerr) v |= SC_S_BSYERR;
+      return v;
+    case 7:				/* reset interrupt */
+      sc.irq = sc.bsyerr = 0;
+      return 0;
+  }
+  return 0;
+}
+
+static void
+sc_wr(reg, val)
+int reg, val;
+{
+  switch (reg) {
+    case 0:
+      sc.odr = val;
+      break;
+    case 1:
+      if (val & SC_A_RST) {
+	sc.phase = PH_NONE;
+	sc.irq = sc.bsyerr = 0;
+	free(sc.buf);
+	sc.buf = NULL;
+      } else if ((val & SC_A_SEL) && sc.phase == PH_NONE) {
+	for (sc.id = 0; sc.id < 8; ++sc.id)
+	  if ((sc.odr & (1 << sc.id)) && disk[sc.id].f != NULL) break;
+      } else if (!(val & SC_A_SEL) && (sc.icr & SC_A_SEL) && sc.id < 8) {
+	sc.phase = PH_CMD;		/* target has the bus */
+	sc.cmdlen = 0;
+	sc.len = 1;
+	sc.pos = 0;
+      }
+      sc.icr = val;
+      break;
+    case 2:
+      sc.mode = val;
+      break;
+    case 3:
+      sc.tcr = val;
+      break;
+  }
+  sc_update();
+}
+
+/* Status register 1 shows BSY as soon as a target answers SELECT.
+ */
+static int
+sc_selected()
+{
+  return (sc.icr & SC_A_SEL) && sc.phase == PH_NONE && sc.id < 8 &&
+    (sc.odr & (1 << sc.id)) && disk[sc.id].f != NULL;
+}
+
+/* Pseudo-DMA data register.
+ */
+static int
+sc_dma_rd()
+{
+  int c;
+
+  if (sc.phase == PH_NONE || !PH_IN(sc.phase) || sc.pos >= sc.len)
+    return 0;
+  c = sc.buf[sc.pos++];
+  if (sc.pos >= sc.len) sc_next_phase();
+  sc_update();
+  return c;
+}
+
+static void
+sc_dma_wr(val)
+int val;
+{
+  if (sc.phase == PH_CMD) {
+    sc.cmd[sc.cmdlen++] = val;
+    if (sc.cmdlen == 1) sc.len = sc_cdb_len(val);
+    if (++sc.pos >= sc.len) sc_next_phase();
+  } else if (sc.phase == PH_ODATA && sc.pos < sc.len) {
+    sc.buf[sc.pos++] = val;
+    if (sc.pos >= sc.len) sc_next_phase();
+  }
+  sc_update();
+}
+
+/*===========================================================================*
+ *				address decode				     *
+ *===========================================================================*/
+
+static int
+io_rd(adr)
+u32 adr;
+{
+  if (adr >= ICU_ADR) return icu_rd((int)(adr & 0x1f));
+  if (adr - DUART_ADR < 0x40)
+    return duart_rd(&duart[(adr >> 4) & 3], (int)(adr & 0xf));
+  if (adr - SC_DMA_ADR < 0x8000000) return sc_dma_rd();
+  if (adr - SC_CTL_ADR < 0x8000000) {
+    if ((adr & 7) == 4 && sc_selected()) return SC_S_BSY | SC_S_SEL;
+    return sc_rd((int)(adr & 7));
+  }
+  return 0xff;				/* NMI clear and unused space */
+}
+
+static void
+io_wr(adr, val)
+u32 adr;
+int val;
+{
+  if (adr >= ICU_ADR) icu_wr((int)(adr & 0x1f), val);
+  else if (adr - DUART_ADR < 0x40)
+    duart_wr(&duart[(adr >> 4) & 3], (int)(adr & 0xf), val);
+  else if (adr - SC_DMA_ADR < 0x8000000) sc_dma_wr(val);
+  else if (adr - SC_CTL_ADR < 0x8000000) sc_wr((int)(adr & 7), val);
+}
+
+void
+dev_reset()
+{
+  int i;
+
+  memset(icu, 0, sizeof icu);
+  icu[ICU_PDAT] = 0xff;
+  for (i = 0; i < 4; ++i) {
+    duart[i].u[0].rx = duart[i].u[1].rx = -1;
+    duart[i].imr = 0;
+  }
+  sc.phase = PH_NONE;
+  sc.id = 8;
+  mem_init();
+}
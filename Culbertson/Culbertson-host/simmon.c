@@ -0,0 +1,67 @@
+/* NS32000 host simulator.
+ *
+ * The monitor's disassembler (disasm.c) and register table (newreg.c)
+ * are linked in unchanged.  These are the pieces of the rest of the
+ * monitor which they refer to.
+ */
+
+#include <stdlib.h>
+#include "../Culbertson-mon/debugger.h"
+
+struct MachState machState;
+struct bkpt bkpt[NUM_SW_BKPT];
+unsigned char *Dot;
+char *fileBase;
+long defaultBase = 16, debug, screenLength = 24;
+
+/* As in debugutil.c
+ */
+int
+myStrCmp (p1, p2)
+register char *p1, *p2;
+{
+  while (*p1 == *p2 && *p1 != '\0') {
+    ++p1;
+    ++p2;
+  }
+  if (*p1 == '\0')
+    return (*p2 == '\0')? CMP_MATCH: CMP_SUBSTR;
+  return CMP_NOMATCH;
+}
+
+/* As in debugger.c
+ */
+int
+scan (p)
+char **p;
+{
+  while (**p == ' ' || **p == '\t') ++(*p);
+  return 0;
+}
+
+/* Numbers only; the simulator has no use for the monitor's expressions.
+ */
+int
+getIntScan (p, c)
+char **p;
+long *c;
+{
+  char *q;
+
+  scan (p);
+  if (**p == '\0' || **p == '\n') return NO_NUM;
+  *c = strtol (*p, &q, (int)defaultBase);
+  if (q == *p) return BAD_NUM;
+  *p = q;
+  return GOT_NUM;
+}
+
+/* As in ioutil.c, less the <MORE> paging.
+ */
+int
+morePrintf(increment, a0, a1, a2, a3, a4 ,a5, a6, a7, a8, a9)
+int increment;
+char *a0, *a1, *a2, *a3, *a4, *a5, *a6, *a7, *a8, *a9;
+{
+  return myPrintf(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9);
+}
@@ -0,0 +1,207 @@
+/* NSC 32000 ROM debugger.
+ *
+ * SCSI benchmark.  BENCH reads or writes a range of blocks, in order or
+ * at random, through the request queue in scsi.c, and times each batch
+ * of requests with the ICU counter (timer.c).  The depth is how many
+ * requests are queued before the queue is flushed, so sequential
+ * requests may be joined into one command.  The results, including
+ * a histogram of the batch times, are left in benchRes for DUMP or an
+ * upload, and start with a magic number so they can be found in a
+ * memory image.  The histogram has four buckets per power of two, so a
+ * percentile is the top of its bucket, at most 25% high; min and max
+ * are exact.  Keeping every batch time would cost kilobytes of bss in
+ * the RAM below the user's buffers.
+ */
+
+#include "debugger.h"
+
+#define OK 		0
+#define NOT_OK		OK+1
+#define DISK_READ	3
+#define DISK_WRITE	4
+
+#define MAX_DEPTH	16		/* SC_QLEN in scsi.c */
+#define NHIST		96		/* batch time buckets, to 2^24 ticks */
+#define BENCH_MAGIC	0x42454e43	/* "BENC" */
+#define USEC(t)		((t) / 576 * 625 + (t) % 576 * 625 / 576)
+
+struct bench {
+  long magic;
+  long test;				/* 0 sr, 1 sw, 2 rr, 3 rw */
+  long start, blocks, len, count, depth;
+  long sc_adr, lun, blksize;
+  long hz;				/* TIMER_HZ */
+  long bytes, ticks;			/* whole run */
+  long done;				/* batches timed */
+  long min, max;			/* batch ticks */
+  long usec [5];			/* min, 50%, 90%, 99%, max batch */
+  long hist [NHIST];			/* batches by ticks, see benchBucket */
+};
+struct bench benchRes;
+
+static char *testName [] = {"sr", "sw", "rr", "rw"};
+static unsigned long benchSeed = 1;
+
+/* Next pseudo random number, 0 to 2^31-1.
+ */
+static long
+benchRand ()
+{
+  benchSeed = benchSeed * 1103515245 + 12345;
+  return (benchSeed >> 1) & 0x7fffffff;
+}
+
+/* Histogram bucket for a batch of t ticks.  Times below 4 ticks get a
+ * bucket each; above that, 4 * (log2 (t) - 1) plus the two bits below
+ * the top one.
+ */
+static int
+benchBucket (t)
+register long t;
+{
+  register int k;
+
+  if (t < 4) return t < 0? 0: t;
+  for (k = 2; t >> (k + 1); ++k);
+  k = 4 * (k - 1) + ((t >> (k - 2)) & 3);
+  return k < NHIST? k: NHIST - 1;
+}
+
+/* Largest time in a bucket.
+ */
+static long
+benchTop (k)
+register int k;
+{
+  if (k < 4) return k;
+  return ((long)(4 + (k & 3) + 1) << (k / 4 - 1)) - 1;
+}
+
+/* Batch time at percentile pct, from the histogram.
+ */
+static long
+benchPct (b, pct)
+register struct bench *b;
+int pct;
+{
+  register long n = b->done * pct / 100 + 1, t;
+  register int k;
+
+  for (k = 0; k < NHIST - 1 && (n -= b->hist [k]) > 0; ++k);
+  t = benchTop (k);
+  if (t > b->max) t = b->max;
+  if (t < b->min) t = b->min;
+  return USEC (t);
+}
+
+/* Print the summary.
+ */
+static
+benchReport (b)
+register struct bench *b;
+{
+  register int i;
+  long ms;
+
+  for (i = 0; i < 5; ++i) b->usec [i] = 0;
+  if (b->done > 0) {
+    b->usec [0] = USEC (b->min);
+    b->usec [1] = benchPct (b, 50);
+    b->usec [2] = benchPct (b, 90);
+    b->usec [3] = benchPct (b, 99);
+    b->usec [4] = USEC (b->max);
+  }
+  myPrintf ("%s: ", testName [b->test]);
+  timerReport (b->bytes, b->ticks);
+  ms = b->ticks / (TIMER_HZ / 1000);
+  if (ms > 0) myPrintf ("%ld requests/sec, ",
+    b->bytes / (b->len * b->blksize) * 1000 / ms);
+  myPrintf ("batch usec min %ld, 50%% %ld, 90%% %ld, 99%% %ld, max %ld\n",
+    b->usec [0], b->usec [1], b->usec [2], b->usec [3], b->usec [4]);
+  myPrintf ("Results at 0x%lx, %ld bytes\n", (long)b, (long)sizeof (*b));
+}
+
+/* BENCH command handler.
+ */
+bench (p)
+char *p;
+{
+  register struct bench *b = &benchRes;
+  long ram, blk, next, t0, t1, sc_blksize ();
+  int ret, i, n, op, random;
+
+  scanToken (&p, cmdWord);
+  for (i = 0; i < 4 && CMP_MATCH != myStrCmp (cmdWord, testName [i]); ++i);
+  if (i == 4) {
+    myPrintf ("Test must be sr, sw, rr or rw\n");
+    return;
+  }
+  b->test = i;
+  op = (i & 1)? DISK_WRITE: DISK_READ;
+  random = (i >= 2);
+  if (GOT_NUM != getIntScan (&p, &b->start) ||
+  GOT_NUM != getIntScan (&p, &b->blocks) || b->blocks <= 0) {
+    myPrintf ("Bad block range\n");
+    return;
+  }
+  if (GOT_NUM != getIntScan (&p, &ram)) {
+    myPrintf ("Bad RAM address\n");
+    return;
+  }
+  if (BAD_NUM == (ret = getIntScan (&p, &b->len)) ||
+  ret == GOT_NUM && (b->len <= 0 || b->len > b->blocks)) {
+    myPrintf ("Bad transfer length\n");
+    return;
+  } else if (ret == NO_NUM) b->len = 1;
+  if (BAD_NUM == (ret = getIntScan (&p, &b->count)) ||
+  ret == GOT_NUM && b->count <= 0) {
+    myPrintf ("Bad count\n");
+    return;
+  } else if (ret == NO_NUM) b->count = b->blocks / b->len;
+  if (BAD_NUM == (ret = getIntScan (&p, &b->depth)) ||
+  ret == GOT_NUM && (b->depth <= 0 || b->depth > MAX_DEPTH)) {
+    myPrintf ("Depth must be 1 to %d\n", MAX_DEPTH);
+    return;
+  } else if (ret == NO_NUM) b->depth = 1;
+  b->magic = BENCH_MAGIC;
+  b->sc_adr = scsiAdr;
+  b->lun = scsiLun;
+  b->blksize = sc_blksize (scsiAdr, scsiLun);
+  b->hz = TIMER_HZ;
+  b->bytes = b->done = b->max = 0;
+  b->min = 0x7fffffff;
+  for (i = 0; i < NHIST; ++i) b->hist [i] = 0;
+  if (op == DISK_WRITE) cacheInval ();
+  benchSeed = 1;			/* same blocks every run */
+
+  ret = OK;
+  next = b->start;
+  timerStart ();
+  t0 = timerRead ();
+  for (n = 0; n < b->count && ret == OK; ) {
+    for (i = 0; i < b->depth && n < b->count; ++i, ++n) {
+      if (random) blk = b->start + benchRand () % (b->blocks - b->len + 1);
+      else {
+	if (next + b->len > b->start + b->blocks) next = b->start;
+	blk = next;
+	next += b->len;
+      }
+      if (OK != sc_queue (op, blk, ram + i * b->len * b->blksize, b->len,
+	scsiAdr, scsiLun)) ret = NOT_OK;
+    }
+    if (OK != sc_flush ()) ret = NOT_OK;
+    t1 = timerRead ();
+    t0 = t1 - t0;
+    if (t0 < b->min) b->min = t0;
+    if (t0 > b->max) b->max = t0;
+    ++b->hist [benchBucket (t0)];
+    ++b->done;
+    b->bytes += i * b->len * b->blksize;
+    t0 = t1;
+    if (uart_poll (DEFAULT_UART) && getch () == '\003') break;	/* ^C */
+  }
+  b->ticks = timerRead ();
+  timerStop ();
+  if (ret != OK) myPrintf ("SCSI error after %ld requests\n", (long)n);
+  benchReport (b);
+}
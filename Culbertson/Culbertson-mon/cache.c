@@ -0,0 +1,296 @@
+/* NSC 32000 ROM debugger.
+ *
+ * SCSI block cache.  READ looks here before going to the drive, so
+ * booting again or looking at a label again comes from RAM.  The cache
+ * lives in free RAM, by default just above the monitor, and is off until
+ * the CACHE command gives it a size.  The table of slots and the hash
+ * table are at the start of that RAM and the block data follows, so the
+ * monitor's own RAM does not grow with the cache.  Slots are found
+ * through the hash table and replaced least recently used first.
+ *
+ * A READ which misses, or which starts where the last one ended, also
+ * reads up to cacheRA following blocks into the cache.  WRITE goes to
+ * the drive and updates any copies.  RAW may do anything to a drive, so
+ * it empties the cache.
+ */
+
+#include "debugger.h"
+
+#define OK 		0
+#define NOT_OK		OK+1
+#define DISK_READ	3
+#define DISK_WRITE	4
+
+#define DEFAULT_BSZ	512
+#define MAX_SLOTS	0x7fff		/* slot numbers are shorts */
+#define MAX_RA		64
+#define CHASH		256		/* power of 2 */
+#define CHASH_OF(dev,blk)	(((blk) ^ (dev) << 5) & (CHASH - 1))
+#define CDATA(i)	(cacheData + (i) * cacheBsz)
+#define NO_SLOT		(-1)
+
+struct cslot {
+  long block;
+  short dev;				/* adr << 3 | lun, NO_SLOT if free */
+  short hnext;				/* hash chain */
+  short newer, older;			/* LRU list */
+};
+
+long cacheRA = 8;			/* blocks to read ahead */
+static struct cslot *cacheTab;
+static char *cacheData;
+static long cacheN, cacheBsz, cacheHits, cacheMisses;
+static short *cacheHash, cacheNew, cacheOld;
+static long lastEnd;			/* block after the last READ */
+static int lastDev = NO_SLOT;
+
+extern char end;
+
+/* CACHE command handler.  Set the size and place of the cache, empty
+ * it, or show it.
+ */
+cache (p)
+char *p;
+{
+  long n, bsz, adr;
+  char *save;
+  int ret;
+
+  save = p;
+  scanToken (&p, cmdWord);
+  if (strlen (cmdWord) >= 3 &&
+  CMP_NOMATCH != myStrCmp (cmdWord, "invalidate")) {
+    cacheInval ();
+    return;
+  }
+  p = save;
+  if (BAD_NUM == (ret = getIntScan (&p, &n))) {
+    myPrintf ("Bad number of blocks\n");
+    return;
+  }
+  if (ret == NO_NUM) {
+    if (cacheN == 0) myPrintf ("Cache off\n");
+    else myPrintf (
+      "%ld blocks of %ld bytes at 0x%lx, %ld hits, %ld misses\n",
+      cacheN, cacheBsz, (long)cacheTab, cacheHits, cacheMisses);
+    return;
+  }
+  if (BAD_NUM == (ret = getIntScan (&p, &bsz)) ||
+  ret == GOT_NUM && (bsz <= 0 || bsz & 3)) {
+    myPrintf ("Bad block size\n");
+    return;
+  } else if (ret == NO_NUM) bsz = DEFAULT_BSZ;
+  if (BAD_NUM == (ret = getIntScan (&p, &adr))) {
+    myPrintf ("Bad address\n");
+    return;
+  } else if (ret == NO_NUM) adr = ((long)&end + 15) & ~15;
+  if (n < 0 || n > MAX_SLOTS) {
+    myPrintf ("Too many blocks\n");
+    return;
+  }
+  cacheN = n;
+  cacheBsz = bsz;
+  cacheTab = (struct cslot *)adr;
+  cacheHash = (short *)(cacheTab + n);
+  cacheData = (char *)(((long)(cacheHash + CHASH) + 15) & ~15);
+  cacheInval ();
+  if (n > 0) myPrintf ("Cache uses 0x%lx to 0x%lx\n", adr, (long)CDATA (n));
+}
+
+/* Empty the cache.
+ */
+cacheInval ()
+{
+  register int i;
+
+  if (cacheN > 0)
+    for (i = 0; i < CHASH; ++i) cacheHash [i] = NO_SLOT;
+  for (i = 0; i < cacheN; ++i) {
+    cacheTab [i].dev = NO_SLOT;
+    cacheTab [i].newer = i - 1;
+    cacheTab [i].older = (i + 1 < cacheN)? i + 1: NO_SLOT;
+  }
+  cacheNew = 0;
+  cacheOld = cacheN - 1;
+  cacheHits = cacheMisses = 0;
+  lastDev = NO_SLOT;
+}
+
+/* Slot holding block blk of device dev, or NO_SLOT.
+ */
+static int
+cacheFind (dev, blk)
+int dev;
+long blk;
+{
+  register int i;
+
+  for (i = cacheHash [CHASH_OF (dev, blk)]; i != NO_SLOT;
+    i = cacheTab [i].hnext)
+    if (cacheTab [i].block == blk && cacheTab [i].dev == dev) return i;
+  return NO_SLOT;
+}
+
+/* Take slot i out of the LRU list.
+ */
+static
+cacheUnlink (i)
+int i;
+{
+  register struct cslot *s = &cacheTab [i];
+
+  if (s->newer == NO_SLOT) cacheNew = s->older;
+  else cacheTab [s->newer].older = s->older;
+  if (s->older == NO_SLOT) cacheOld = s->newer;
+  else cacheTab [s->older].newer = s->newer;
+}
+
+/* Make slot i the most recently used.
+ */
+static
+cacheTouch (i)
+int i;
+{
+  if (i == cacheNew) return;
+  cacheUnlink (i);
+  cacheTab [i].newer = NO_SLOT;
+  cacheTab [i].older = cacheNew;
+  cacheTab [cacheNew].newer = i;
+  cacheNew = i;
+}
+
+/* Forget what slot i holds and make it the first to be reused.
+ */
+static
+cacheDrop (i)
+int i;
+{
+  register short *link;
+  register struct cslot *s = &cacheTab [i];
+
+  if (s->dev != NO_SLOT) {
+    link = &cacheHash [CHASH_OF (s->dev, s->block)];
+    while (*link != i) link = &cacheTab [*link].hnext;
+    *link = s->hnext;
+    s->dev = NO_SLOT;
+  }
+  if (i == cacheOld) return;
+  cacheUnlink (i);
+  s->older = NO_SLOT;
+  s->newer = cacheOld;
+  cacheTab [cacheOld].older = i;
+  cacheOld = i;
+}
+
+/* Reuse the least recently used slot for block blk of device dev.
+ */
+static int
+cacheAlloc (dev, blk)
+int dev;
+long blk;
+{
+  register int i = cacheOld;
+  register struct cslot *s = &cacheTab [i];
+
+  cacheDrop (i);
+  s->dev = dev;
+  s->block = blk;
+  s->hnext = cacheHash [CHASH_OF (dev, blk)];
+  cacheHash [CHASH_OF (dev, blk)] = i;
+  cacheTouch (i);
+  return i;
+}
+
+/* Read the blocks after blk which are not already cached, up to the
+ * next one which is, into the cache.  Stop at the end of the drive.
+ * A failure here is no business of the READ that caused it.
+ */
+static
+cacheAhead (dev, blk, sc_adr, lun)
+int dev;
+long blk, sc_adr, lun;
+{
+  long n, sc_lastblk ();
+  int i, k, ret = OK;
+
+  n = sc_lastblk (sc_adr, lun) - blk + 1;
+  if (n > cacheRA) n = cacheRA;
+  if (n > MAX_RA) n = MAX_RA;
+  if (n > cacheN / 2) n = cacheN / 2;
+  for (i = 0; i < n && NO_SLOT == cacheFind (dev, blk + i); ++i) {
+    k = cacheAlloc (dev, blk + i);
+    if (OK != sc_queue (DISK_READ, blk + i, (long)CDATA (k), 1L, sc_adr, lun))
+      ret = NOT_OK;
+  }
+  if (OK != sc_flush () || ret != OK)
+    while (--i >= 0) cacheDrop (cacheFind (dev, blk + i));
+}
+
+/* Read len blocks from block into ram, taking what we can from the
+ * cache.  The blocks missed are read straight into ram, then copied
+ * to the cache, as many of the last ones as fit.
+ */
+int
+cacheRead (block, ram, len, sc_adr, lun)
+long block, len, sc_adr, lun;
+char *ram;
+{
+  register int i, j, k;
+  int dev, ret = OK, seq;
+  long sc_blksize ();
+
+  if (cacheN == 0 || sc_blksize (sc_adr, lun) != cacheBsz)
+    return sc_rdwt (DISK_READ, block, (long)ram, len, sc_adr, lun);
+  dev = sc_adr << 3 | lun & 7;
+  seq = (dev == lastDev && block == lastEnd);
+  for (i = 0; i < len; i = j) {
+    if (NO_SLOT != (k = cacheFind (dev, block + i))) {
+      blockMove (CDATA (k), ram + i * cacheBsz, cacheBsz);
+      cacheTouch (k);
+      ++cacheHits;
+      j = i + 1;
+      continue;
+    }
+    for (j = i + 1; j < len && NO_SLOT == cacheFind (dev, block + j); ++j);
+    cacheMisses += j - i;
+    if (j == len) seq = 1;		/* ends with a miss */
+    if (OK != sc_queue (DISK_READ, block + i, (long)(ram + i * cacheBsz),
+      (long)(j - i), sc_adr, lun)) ret = NOT_OK;
+  }
+  if (OK != sc_flush ()) ret = NOT_OK;
+  icache_inval ((long)ram, len * cacheBsz);	/* hits skip sc_xfer() */
+  if (ret != OK) {
+    lastDev = NO_SLOT;
+    return ret;
+  }
+  for (i = (len > cacheN)? len - cacheN: 0; i < len; ++i)
+    if (NO_SLOT == cacheFind (dev, block + i))
+      blockMove (ram + i * cacheBsz, CDATA (cacheAlloc (dev, block + i)),
+	cacheBsz);
+  lastDev = dev;
+  lastEnd = block + len;
+  if (seq) cacheAhead (dev, lastEnd, sc_adr, lun);
+  return OK;
+}
+
+/* Write len blocks from ram to the drive, then bring any cached copies
+ * up to date.
+ */
+int
+cacheWrite (block, ram, len, sc_adr, lun)
+long block, len, sc_adr, lun;
+char *ram;
+{
+  int dev, ret, i, k;
+  long sc_blksize ();
+
+  ret = sc_rdwt (DISK_WRITE, block, (long)ram, len, sc_adr, lun);
+  if (cacheN == 0 || sc_blksize (sc_adr, lun) != cacheBsz) return ret;
+  dev = sc_adr << 3 | lun & 7;
+  for (i = 0; i < len; ++i) {
+    if (NO_SLOT == (k = cacheFind (dev, block + i))) continue;
+    if (ret == OK) blockMove (ram + i * cacheBsz, CDATA (k), cacheBsz);
+    else cacheDrop (k);
+  }
+  return ret;
+}
@@ -0,0 +1,20 @@
+/* NSC 32000 ROM debugger.
+ *
+ * CCITT CRC table, defined in crctab.c.  romimg (Culbertson-host) links
+ * crctab.c too; the Minix download program builds its own copy.
+ *
+ * The download CRC shifts each data bit into the low end of the CRC and
+ * reduces by the generator x^16 + x^12 + x^5 + 1.  Shifting in a whole
+ * byte moves the high byte of the CRC out past x^16, so
+ *
+ *	new = ((old & 0xff) << 8 | ch) ^ crctab [old >> 8]
+ *
+ * where crctab [t] is t * x^16 mod the generator.  This gives the same
+ * CRC, bit for bit, as the old loop, and the same as Minix's CRC command.
+ * The includer defines CONST, as debugger.h does.
+ */
+
+#define UPDATE_CRC(crc, ch) \
+  ((((crc) & 0xff) << 8 | ((ch) & 0xff)) ^ crctab [((crc) >> 8) & 0xff])
+
+extern CONST unsigned short crctab [];
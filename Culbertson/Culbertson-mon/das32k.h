@@ -571,7 +571,10 @@ char fmt6_table[16][6] = {
 #define FMT6_CBITI  0x3 /* clear bit interlocked */
 #define FMT6_UNDEF1 0x4 /* undefined */
 #define FMT6_LSH    0x5 /* logical shift */
-#define FMT6_SBIT   0x6 /* s#define FMT6_NOT    0x9 /* not */
+#define FMT6_SBIT   0x6 /* set bit */
+#define FMT6_SBITI  0x7 /* set bit interlocked */
+#define FMT6_NEG    0x8 /* negate */
+#define FMT6_NOT    0x9 /* not */
 #define FMT6_UNDEF2 0xa /* undefined */
 #define FMT6_SUBP   0xb /* subtract packed decimal */
 #define FMT6_ABS    0xc /* absolute value */
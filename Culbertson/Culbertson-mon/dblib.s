@@ -2,7 +2,8 @@
 ; SCN 2681 routines for debugger
 ;
 ; Note: These i/o routines are raw.  Do mappings
-;       (e.g. cr -> nl) elsewhere.
+;       (e.g. cr -> nl) elsewhere.  The ring buffers
+;       and the interrupt routine proper are in uart.c.
 ;
 ; Uart numbers:
 ;   There are eight uart addresses currently decoded
@@ -18,6 +19,7 @@ stat_reg:	.equ	1
 data_reg:	.equ	3
 in_rdy:		.equ	0
 out_rdy:	.equ	2
+psr_ie:		.equ	h'800
 	.program
 
 bconv:	.word	75
@@ -77,24 +79,35 @@ putchar_loop:
 ;****************************************************
 ; _db_setbaud -- Set baud rate of uart.
 ;
-;    Enter: db_setbaud (<rate>, <uart>)
+;    Enter: db_setbaud (<rate>, <uart>, <acr>)
 ;     Exit: r0 = 1 if Ok, else = 0
+;
+; The ACR is shared with the other uart on the duart.
+; <acr> selects the rate set for rates in both sets;
+; the caller passes set 2 for the set 2 only rates, and
+; 38.4K always gets set 1.
 ; Destroys: flags
 ;****************************************************
 _db_setbaud::
-	enter	[r1,r2,r3],0
+	enter	[r1,r2,r3,r4],0
 	movd	12(fp),r1	;r1 = uart number
 	bsr	get_uart_adr
 	movd	8(fp),r0	;r0 = baud rate
 	addr	@bconv,r2	; point to baud conversion table
 	movqd	0,r3		; start with a zero offset
+	movb	16(fp),r4	; ACR value from the caller
 dbsbl1:	cmpqw	0,r2[r3:w]	; are we at the end of the table?
-	beq	setbaud_err	; yes, exit with error now
+	beq	dbsbl3		; yes, last chance is 38.4K
 	cmpw	r0,r2[r3:w]	; have a look at the table
 	beq	dbsbl2		; matched, exit now
 	addqd	1,r3		; move to next table entry
 	br	dbsbl1		; loop to do next one
 
+dbsbl3:	cmpd	38400,r0	; 38.4K is only in set 1, whose
+	bne	setbaud_err	; other rates match set 2 except
+	addr	@12,r3		; that 19.2K becomes 38.4K
+	movqb	0,r4		; ACR value for set 1
+
 dbsbl2:	mulb	17,r3		; this moves the index into both
 				; nibbles of r3, for the 2681 baud
 				; rate register. 0xb becomes 0xbb
@@ -107,7 +120,7 @@ dbsbl2:	mulb	17,r3		; this moves the index into both
 	movb	h'13,0(r1)	; no rts, no parity, 8 bits
 	movb	h'7,0(r1)	; no cts, 1 stop bit
 	movb	r3,1(r1)	; set baud rate
-	movb	h'80,4(r2)	; set ACR to set 2 (19.2 Kbps)
+	movb	r4,4(r2)	; set ACR to set 2 or 1
 	movb	h'85,2(r1)	; enable rx & tx, set RTS for 2692
 	movb	h'5,2(r1)	; enable rx & tx for 2681
 	movb	h'0,13(r2)	; ensure RTS mode set
@@ -118,9 +131,63 @@ dbsbl2:	mulb	17,r3		; this moves the index into both
 setbaud_err:
 	movqd	0,r0
 setbaudx:
-	exit	[r1,r2,r3]
+	exit	[r1,r2,r3,r4]
+	ret	0
+
+;****************************************************
+; _db_intr_on, _db_intr_off -- Enable or disable
+;    interrupts in the monitor.
+;
+;    Enter: db_intr_on (), db_intr_off ()
+;     Exit:
+; Destroys:
+;****************************************************
+_db_intr_on::
+	bispsrw	psr_ie
 	ret	0
 
+_db_intr_off::
+	bicpsrw	psr_ie
+	ret	0
+
+;****************************************************
+; _isr_duart0 .. _isr_duart3 -- DUART interrupts.
+;    Installed by inttab_init().  Save the registers
+;    C code may destroy and call duart_intr (<duart
+;    number>) in uart.c.
+;****************************************************
+_isr_duart0::
+	save	[r0,r1,r2]
+	movqd	0,tos
+	br	isr_duart
+_isr_duart1::
+	save	[r0,r1,r2]
+	movqd	1,tos
+	br	isr_duart
+_isr_duart2::
+	save	[r0,r1,r2]
+	movqd	2,tos
+	br	isr_duart
+_isr_duart3::
+	save	[r0,r1,r2]
+	movqd	3,tos
+isr_duart:
+	bsr	_duart_intr
+	adjspb	-4		; pop argument
+	restore	[r0,r1,r2]
+	reti
+
+;****************************************************
+; _isr_scsi -- DP8490 interrupt.  Installed by
+;    inttab_init().  Save the registers C code may
+;    destroy and call sc_intr () in scsi.c.
+;****************************************************
+_isr_scsi::
+	save	[r0,r1,r2]
+	bsr	_sc_intr
+	restore	[r0,r1,r2]
+	reti
+
 ;****************************************************
 ; Get uart base address.
 ;
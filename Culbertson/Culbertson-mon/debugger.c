@@ -18,6 +18,7 @@ char help_str [] =
 "Command arguments may be expressions.  Type HELP = for expression syntax.\n";
 
 long debug = 0;
+char cmdWord [LNLEN];		/* a command's keyword, off the small stack */
 long defaultBase = 16;
 #if !STANDALONE
 char *fileBase = 0;			/* beginning of file buffer */
@@ -34,7 +35,9 @@ int baseConverter(), disassemble(), dump(), quitHandler(),
  stackTrace(), baud(),
  init_machState(), run(), single_step(),
  fill(), move(), set(), show(), gpr(), cpu(), fpu(), mmu(),
- scsiRaw(), scsiRead(), scsiWrite(), crc(), download();
+ scsiRaw(), scsiRead(), scsiWrite(), crc(), download(), symbols(), view(),
+ doScript(), cache(), bench();
+long blockFind(), searchFind();
 
 #if !STANDALONE
 int getfile(), putfile();
@@ -51,8 +54,37 @@ struct cmd cmd_tbl [] = {		/* Command Table */
 
 #if STANDALONE
 { baud, "baud",
-"Syntax: BAUD <rate> [<uart>].  Set UART baud rate.  Console UART is 0 and\n\
-is the default."
+"Syntax: BAUD <rate> [<uart> [<flow>]].  Set UART baud rate.  Console UART\n\
+is 0 and is the default.  A non-zero <flow> turns on RTS/CTS flow control.\n\
+The two UARTs of a DUART share a rate set: 38400 needs set 1, and 75, 150,\n\
+1800, 2000 and 19200 need set 2; in the other set they would be 50, 200,\n\
+7200, 1050 and 38400.  A rate which would change the other UART's rate is\n\
+refused while that UART is open, e.g. 38400 on UART 1 with the console at\n\
+19200.  The first two UARTs set are buffered and interrupt driven; any\n\
+others are polled."
+},
+#endif
+
+#if STANDALONE
+{ cache, "cache",
+"Syntax: CACHE [<blocks> [<block size> [<address>]]].  Keep up to <blocks>\n\
+blocks read from SCSI devices in RAM at <address>, default the free RAM\n\
+above the monitor.  Only devices with <block size> blocks, default 512, are\n\
+cached.  The variable cache_ra is how many blocks READ reads ahead.  WRITE\n\
+goes through to the device.  CACHE 0 turns the cache off, CACHE INVALIDATE\n\
+empties it, and CACHE alone shows how well it is doing."
+},
+#endif
+
+#if STANDALONE
+{ bench, "bench",
+"Syntax: BENCH <test> <block> <blocks> <RAM address> [<len> [<count>\n\
+[<depth>]]].  Time <count> transfers of <len> blocks, default 1, within the\n\
+<blocks> blocks from <block> of SCSI device scsi_adr.  <Test> is sr or sw\n\
+for sequential read or write, rr or rw for random.  Writes destroy the data!\n\
+<Depth>, 1 to 16, requests are queued at a time, and <RAM address> needs room\n\
+for all of them.  Prints throughput and batch time percentiles, and leaves\n\
+a histogram of the batch times in RAM.  ^C stops the test."
 },
 #endif
 
@@ -75,7 +107,10 @@ starting at <address>."
 
 { download, "download",
 "Syntax: DOWNLOAD <address>.  Download via serial line into memory.  Hit\n\
-control-C to abort.  After transfer, hit <return> for status."
+control-C to abort.  After transfer, hit <return> for status.  The sender's\n\
+-b option selects the block protocol, which resends only damaged blocks.\n\
+DOWNLOAD HEX [<offset>] takes Intel HEX or S-records, pasted as text, and\n\
+stores each at its own address plus <offset>."
 },
 
 { dump, "dump",
@@ -92,7 +127,9 @@ causes the old value to be retained and advances the editor to the next byte."
 },
 
 { fill, "fill",
-"Syntax: FILL <address> <count> <pattern>.  Fills memory with byte pattern."
+"Syntax: FILL <address> <count> <pattern> [<size>].  Fills <count> bytes of\n\
+memory with <pattern>, which is <size> (1, 2 or 4) bytes long, low byte\n\
+first.  Default <size> is 1."
 },
 
 { fpu, "fpu",
@@ -132,10 +169,14 @@ to handy values."
 
 #if STANDALONE
 { scsiRaw, "raw",
-"Syntax: RAW <parameters> [<SCSI adr>].  Issues a command to a SCSI device.\n\
+"Syntax: RAW [<parameters> [<SCSI adr>]].  Issues a command to a SCSI device.\n\
 <Parameters> is the address of an array of eight pointers to the various\n\
 SCSI buffers: data-out, data-in, command, status, dummy, dummy, message-out,\n\
-message-in.  Default SCSI address is the variable scsi_adr."
+message-in.  Default SCSI address is the variable scsi_adr.  If the variable\n\
+scsi_intr is not 0, RAW returns once the command is sent, so other commands\n\
+can be used while the drive seeks.  When the target leaves the command\n\
+phase, its interrupt runs the rest of the command, and the monitor waits for\n\
+that.  RAW alone waits for the command to finish."
 },
 #endif
 
@@ -158,10 +199,21 @@ scsi_adr and scsi_lun.  Block length is same as used by the SCSI device."
 current PC."
 },
 
+{ doScript, "script",
+"Syntax: SCRIPT <address> [<length>].  Run the commands in the text at\n\
+<address>, one per line, up to <length> bytes or a NUL or ^Z.  Output is not\n\
+paged.  A script may also have lines: # <comment>, :<label>, GOTO <label>,\n\
+STOP, IF <expression> <line> and IFNOT <expression> <line>.  ^C stops a\n\
+script."
+},
+
 { search, "search",
 "Syntax: SEARCH <start> <cnt> <byte> [<byte> ...].  Searches from <start> to\n\
-<start>+<cnt> for all occurrences of the given pattern.  Eventually quits if\n\
-many matches."
+<start>+<cnt> for every occurrence of a pattern of up to 64 bytes.  A <byte>\n\
+of ? matches anything, and <byte>:<mask> matches bytes which equal <byte> in\n\
+the bits set in <mask>.  The colon splits <byte> from <mask> first, so b:f0 is\n\
+the byte 0xb under mask 0xf0; write a memory fetch as (b:<adr>).  Answer Q at\n\
+the <MORE> prompt to stop."
 },
 
 { set, "set",
@@ -178,11 +230,23 @@ SHOW to get a complete list of register and variable names."
 program."
 },
 
+{ symbols, "symbols",
+"Syntax: SYMBOLS [<address>].  Use the symbol table of the a.out image at\n\
+<address> in expressions.  The image must stay in RAM.  The symbol index is\n\
+built in the RAM just past the image, about 6 bytes per symbol; its range\n\
+is printed.  Without <address>, forget the symbols."
+},
+
 { stackTrace, "trace",
 "Syntax: TRACE <count> [<fp value>].  Display a trace of the top <count>\n\
 stack frames, starting at FP or <fp value>."
 },
 
+{ view, "view",
+"Syntax: VIEW [<expression>].  Show the value of <expression> each time the\n\
+user program stops.  Without <expression>, stop showing all of them."
+},
+
 #if !STANDALONE
 { putfile, "write",
 "Syntax: WRITE <file> <address> <count>.  Writes <count> bytes to\n\
@@ -209,7 +273,8 @@ Registers may be used in expressions.  The prefix r' specifies a register\n\
 for ambigious cases, e.g. f0 is a hex number but r'f0 is a register.\n\
 b: w: and d: fetch bytes, words, and doubles from memory.  '<character> is\n\
 the ASCII value of <character>.  V(<adr>[,<ptb>]) translates a virtual\n\
-address to a physical address."
+address to a physical address.  After SYMBOLS, a.out symbols may be used too;\n\
+s'<symbol> forces a symbol, e.g. s'add.  C names need no leading _."
 },
 
 { help, "?",
@@ -228,7 +293,7 @@ char **argv;
 #else /* STANDALONE */
   zero_bss();	/* note: this needs to happen before almost anything */
   copy_dataseg();
-  db_setbaud (DEFAULT_BAUD, DEFAULT_UART);
+  setbaud (DEFAULT_BAUD, DEFAULT_UART, 0);
   myPrintf ("\nNS32000 ROM Debugger\nVersion: %s\n", version);
   myPrintf ("RAM free above 0x%lx\n\n", (long)(&end));
 #endif
@@ -238,6 +303,9 @@ char **argv;
 #endif
   init_machState();
   initBreaks();
+#if STANDALONE
+  uart_resume();	/* after init_machState() sets up the vectors */
+#endif
   command_loop();
 #if UNIX
   ttclose();
@@ -249,7 +317,6 @@ char **argv;
 
 command_loop ()
 {
-  CONST struct cmd *q, *find_cmd();
   char *p, inline [LNLEN];
 
   for (;;) {
@@ -257,36 +324,66 @@ command_loop ()
     p = inline;
     scan (&p);
     if (*p == '\0' || *p == '\n') continue;
-    /* if command is found in command table, call command handler */
-    if (NULL != (q = find_cmd (&p))) (*(q->fn)) (p);
-    else morePrintf (1, "Unknown command\n");
+    exec_cmd (p);
   }
 }
 
+/* If the command at p is found in command table, call its handler.
+ * Return 0 if not found.
+ */
+int
+exec_cmd (p)
+char *p;
+{
+  CONST struct cmd *q, *find_cmd();
+
+  if (NULL == (q = find_cmd (&p, 1))) return 0;
+  (*(q->fn)) (p);
+  return 1;
+}
+
+/* Trie of command names.  They take about four nodes each (135 for 35
+ * names); the pool allows five.  If a new name does not fit, find_cmd()
+ * says so.
+ */
+#define CMDNODES (CMDLEN * 5)
+struct tnode cmdNodes [CMDNODES];
+struct trie cmdTrie = {cmdNodes, CMDNODES, 0};
+
 /* Search cmd_tbl for 1) a command matching what the user typed or 2)
  * a unique command which is a superstring of what the user typed.
+ * If verbose, say why there was no such command.
  */
 CONST struct cmd *
-find_cmd (p)
+find_cmd (p, verbose)
 char **p;
+int verbose;
 {
   char token [LNLEN];
-  CONST struct cmd *q, *substr;
-  int multisub = 0;
+  int i, print_cmd ();
 
-  scanToken (p, token);
-  for (q = cmd_tbl; q < cmd_tbl + CMDLEN; ++q)
-    switch (myStrCmp (token, q->name)) {
-      case CMP_MATCH:
-	return q;
-      case CMP_SUBSTR:
-	++multisub;
-	substr = q;
+  if (cmdTrie.used == 0)
+    for (i = 0; i < CMDLEN; ++i)
+      if (!trieAdd (&cmdTrie, cmd_tbl [i].name, i)) {
+	myPrintf ("CMDNODES too small at %s\n", cmd_tbl [i].name);
 	break;
-      case CMP_NOMATCH:
-	break;
-    }
-  return (multisub == 1)? substr: NULL;
+      }
+  scanToken (p, token);
+  i = trieFind (&cmdTrie, token);
+  if (i >= 0) return &cmd_tbl [i];
+  if (!verbose) return NULL;
+  if (i == TRIE_AMBIG) {
+    morePrintf (0, "Ambiguous command, could be:");
+    trieList (&cmdTrie, token, print_cmd);
+    morePrintf (1, "\n");
+  } else morePrintf (1, "Unknown command\n");
+  return NULL;
+}
+
+print_cmd (i)
+int i;
+{
+  morePrintf (0, " %s", cmd_tbl [i].name);
 }
 
 /* Scan next token from string pointed to by p.  Tokens are delimited
@@ -346,7 +443,7 @@ char *p;
 {
   CONST struct cmd *q;
 
-  if (NULL != (q = find_cmd (&p)))
+  if (NULL != (q = find_cmd (&p, 0)))
     morePrintf (1, "%s\n", q -> help);
   else help_cmds (p);
 }
@@ -435,6 +532,7 @@ char *p;
       else {
         if (GOT_NUM != (ret = getIntScan (&p, &i))) break;
         *(q + BASE) = i;
+        icache_inval ((long)(q + BASE), 1L);
       }
       ++q;
     }
@@ -448,8 +546,7 @@ char *p;
 fill (p)
 char *p;
 {
-  long cnt, start, pattern;
-  unsigned char *endp, *startp;
+  long cnt, start, pattern, size;
 
   if (GOT_NUM != getIntScan (&p, &start) ||
      GOT_NUM != getIntScan (&p, &cnt) ||
@@ -458,9 +555,19 @@ char *p;
     myPrintf ("Bad start address, count or pattern\n");
     return;
   }
-  startp = (unsigned char *)start + BASE;
-  for (endp = startp + cnt; startp < endp; ++startp)
-    *(startp) = pattern;
+  switch (getIntScan (&p, &size)) {
+    case NO_NUM:
+      size = 1;
+      break;
+    case GOT_NUM:
+      if (size == 1 || size == 2 || size == 4) break;
+      /* fall through */
+    default:
+      myPrintf ("Pattern size must be 1, 2 or 4\n");
+      return;
+  }
+  icache_inval (start + BASE, cnt);
+  blockFill ((unsigned char *)start + BASE, cnt, pattern, (int)size);
 }
 
 /* MOVE command handler.  Move (really copy) a block of memory.
@@ -469,7 +576,7 @@ move (p)
 char *p;
 {
   long cnt;
-  unsigned char *start, *dest, *q;
+  unsigned char *start, *dest;
 
   if (GOT_NUM != getIntScan (&p, &start) ||
      GOT_NUM != getIntScan (&p, &dest) ||
@@ -480,242 +587,128 @@ char *p;
   }
   start += BASE;
   dest += BASE;
-  if (start > dest)
-    for (q = start; q < start + cnt;) *dest++ = *q++;
-  else
-    for (q = start + cnt, dest += cnt; q > start;)
-      *--dest = *--q;
+  icache_inval ((long)dest, cnt);
+  blockMove (start, dest, cnt);
 }
 
-/* SEARCH command handler.  Search memory for a pattern.
+/* SEARCH pattern.  Memory byte b matches pattern byte i if
+ * (b & mask [i]) == val [i].  skip [c] is how far the Horspool search
+ * may move when c is the memory byte under the last pattern byte.
+ */
+#define SPATLEN		64		/* pattern bytes kept */
+
+struct spat {
+  int len;
+  int exact;				/* no wildcards or masks */
+  unsigned char val [SPATLEN], mask [SPATLEN];
+  unsigned char skip [256];
+} spat;
+
+/* SEARCH command handler.  Search memory for a pattern.  List every
+ * match; the user can quit at the <MORE> prompt.
  */
 search (p)
 char *p;
 {
-  char sbuf [LNLEN], *m, *n, *q, *first_fnd;
-  long start, cnt;
-  int len, found, i;
+  register struct spat *sp = &spat;
+  long start, cnt, at, found, val, mask;
+  char vtext [32], *q, *v;
+  int ret, depth;
 
   if (GOT_NUM != getIntScan (&p, &start) ||
   GOT_NUM != getIntScan (&p, &cnt)) {
     myPrintf ("Bad start address or count\n");
     return;
   }
-  found = len = 0;
-  q = sbuf;
-  while (q < sbuf + LNLEN && GOT_NUM == getIntScan (&p, &i)) {
-    *q++ = i;
-    ++len;
-  }
-  first_fnd = NULL;
-  for (m = (char *)start; m < (char *)start + cnt; ++m) {
-    if (*(m + BASE) == *sbuf) {
-      for (n = m + 1, q = sbuf + 1; n - m < len && *(n + BASE) == *(q + BASE);
-        ++n, ++q);
-      if (n - m == len) {
-	if (NULL == first_fnd) first_fnd = m;
-        ++found;
-        morePrintf (1, "0x%x\n", m);
+  sp->len = 0;
+  sp->exact = 1;
+  for (;;) {
+    scan (&p);
+    if (*p == '?') {
+      ++p;
+      val = mask = 0;
+    } else {
+      for (q = p, depth = 0; *q != '\0' && *q != ' ' && *q != '\t' &&
+	(*q != ':' || depth > 0); ++q)	/* split <byte>:<mask> first, */
+	depth += (*q == '(') - (*q == ')');	/* since b: is a fetch */
+      mask = 0xff;
+      if (*q != ':') {
+	if (NO_NUM == (ret = getIntScan (&p, &val))) break;
+      } else if (q - p >= sizeof vtext) ret = BAD_NUM;
+      else {
+	for (v = vtext; p < q; ) *v++ = *p++;
+	*v = '\0';
+	v = vtext;
+	if (GOT_NUM == (ret = getIntScan (&v, &val)) && *v != '\0')
+	  ret = BAD_NUM;
+	++p;
+	if (ret == GOT_NUM) ret = getIntScan (&p, &mask);
       }
-      if (found > 100) {
-        morePrintf (1, "quitting...\n");
-        break;
+      if (ret != GOT_NUM) {
+	myPrintf ("Bad pattern byte: %s\n", p);
+	return;
       }
     }
+    if (sp->len == SPATLEN) break;
+    sp->mask [sp->len] = mask;
+    sp->val [sp->len] = val & mask;
+    if ((mask & 0xff) != 0xff) sp->exact = 0;
+    ++sp->len;
   }
-  if (first_fnd != NULL) Dot = (unsigned char *)first_fnd;
-}
-
-/* Parse an expression from the passed string.  For consistency, all
- * command handlers should use this for parsing numeric arguments.
- * Advances *p past the current expression.
- *
- * Return True if got legal input, False otherwise.  Legal inputs are:
- *   allow simple expressions using + and -.
- *   . (return Dot)
- *   pc, fp, usp, or isp (return machState.xxx)
- *   '<character>
- *   <number> (default radix)
- *   b'<binary number>
- *   d'<decimal number>
- *   h'<hex number>
- */
-int
-getIntScan (p, c)
-char **p;
-long *c;
-{
-  long accum, val;
-  char op;
-  int ret;
-
-  ret = getIntScan1 (p, &accum);
-  if (ret != GOT_NUM) return ret;
-  for (;;) {
-    scan (p);
-    op = **p;
-    if (op != '-' && op != '+') break;
-    ++(*p);
-    if (getIntScan1 (p, &val) != GOT_NUM) return BAD_NUM;
-    accum += (op == '-')? -val: val;
+  if (sp->len == 0) return;
+  if (!sp->exact || sp->len > 3) searchInit (sp);
+  found = 0;
+  while (cnt > 0 && !screenIgnore) {
+    if (sp->exact && sp->len <= 3)
+      at = blockFind ((unsigned char *)start + BASE, cnt, sp->val, sp->len);
+    else at = searchFind (sp, (unsigned char *)start + BASE, cnt);
+    if (at < 0) break;
+    start += at;
+    cnt -= at;
+    if (0 == found++) Dot = (unsigned char *)start;
+    morePrintf (1, "0x%x\n", start);
+    ++start;
+    --cnt;
   }
-  *c = accum;
-  return GOT_NUM;
+  if (!screenIgnore) morePrintf (1, "%ld found\n", found);
 }
 
-/* Part of expression parser, parses one precedence level.
+/* Fill in the Horspool skip table.  A byte which can match pattern
+ * byte i (but not the last) allows a skip of len - 1 - i; the rightmost
+ * such i wins.  A wildcard near the end therefore keeps skips short.
  */
-int
-getIntScan1 (p, c)
-char **p;
-long *c;
+searchInit (sp)
+register struct spat *sp;
 {
-  long accum, val;
-  char op;
-  int ret;
-
-  ret = getIntScan2 (p, &accum);
-  if (ret != GOT_NUM) return ret;
-  for (;;) {
-    scan (p);
-    op = **p;
-    if (op != '*' && op != '/' && op != '%' && op != '<' && op != '>')
-      break;
-    if (op == '<' || op == '>') {
-      if (op != *(*p + 1)) return BAD_NUM;
-      ++(*p);
-    }
-    ++(*p);
-    if (getIntScan2 (p, &val) != GOT_NUM) return BAD_NUM;
-    switch (op) {
-      case '*':
-	accum *= val; break;
-      case '/':
-	accum /= val; break;
-      case '%':
-	accum %= val; break;
-      case '<':
-	accum <<= val; break;
-      case '>':
-	accum >>= val; break;
-    }
-  }
-  *c = accum;
-  return GOT_NUM;
-}
+  int c, i;
 
-/* Part of expression parser, parses one precedence level.
- */
-int
-getIntScan2 (p, c)
-char **p;
-long *c;
-{
-  long j, k;
-  char c0, c1;
-
-  scan (p);
-  c0 = tolower(**p);
-  c1 = tolower(*(*p+1));
-  switch (c0) {
-    case '\n':
-    case '\0':
-      return NO_NUM;
-    case '-':					/* -exp */
-      ++*p;
-      j = getIntScan2 (p, &k);
-      *c = -k;
-      return j;
-    case '(':					/* (exp) */
-      ++*p;
-      if (GOT_NUM != getIntScan (p, c))
-        return BAD_NUM;
-      scan (p);
-      if (**p != ')')
-        return BAD_NUM;
-      ++*p;
-      return GOT_NUM;
-    case '\'':					/* ASCII code */
-      ++*p;
-      *c = *(*p)++;
-      return GOT_NUM;
-    case 'b':
-      if (c1 == ':') {				/* b:adr, fetch char */
-        *p += 2;
-        j = getIntScan2 (p, &k);
-        *c = CHAR_STAR(k+BASE);
-        return j;
-      }
-      if (c1 == '\'') {				/* b'num, base = 2 */
-        *p += 2;
-	return getNum (p, c, 2L);
-      }
-      break;
-    case 'w':					/* w:adr, fetch short */
-      if (c1 == ':') {
-        *p += 2;
-        j = getIntScan2 (p, &k);
-        *c = SHORT_STAR(k+BASE);
-        return j;
-      }
-      break;
-    case 'd':					/* d:adr, fetch long */
-      if (c1 == ':') {
-        *p += 2;
-        j = getIntScan2 (p, &k);
-        *c = LONG_STAR(k+BASE);
-        return j;
-      }
-      if (c1 == '\'') {				/* d'num, base 10 */
-        *p += 2;
-	return getNum (p, c, 10L);
-      }
-      break;
-    case 'h':					/* base 16 number */
-      if (c1 == '\'') {
-        *p += 2;
-	return getNum (p, c, 16L);
-      }
-      break;
-    case 'r':					/* r'<reg> */
-      /* force "f0" to be interpretted as a reg instead of a number */
-      if (c1 == '\'') {
-        *p += 2;
-	return getReg (p, c);
-      }
-      break;
-    case 'v':					/* v(vaddr[,ptb]) */
-      if (c1 == '(' || c1 == ' ' || c1 == '\t') {
-	++*p;
-	return getVaddr (p, c);
-      }
-      break;
-  }
-  if (getNum (p, c, defaultBase) == GOT_NUM) return GOT_NUM;
-  return getReg (p, c);
+  for (c = 0; c < 256; ++c) sp->skip [c] = sp->len;
+  for (i = 0; i < sp->len - 1; ++i)
+    for (c = 0; c < 256; ++c)
+      if ((c & sp->mask [i]) == sp->val [i]) sp->skip [c] = sp->len - 1 - i;
 }
 
-/* Part of expression parser.  **p should point to a register name.
- * If so, *c is assigned the current value of the register.
+/* Return the offset from adr of the first match of sp in the cnt bytes
+ * at adr, or -1.  As with blockFind(), a match may run past adr + cnt.
  */
-int
-getReg (p, c)
-char **p;
-long *c;
+long
+searchFind (sp, adr, cnt)
+register struct spat *sp;
+unsigned char *adr;
+long cnt;
 {
-  char regbuf [80];
-  struct regTable *r, *find_reg();
-
-  scanreg (p, regbuf);				/* get register */
-  if (NULL != (r = find_reg (regbuf))) {
-    switch (r->type & T_LEN) {
-      case T_CHAR:	*c = CHAR_STAR (r->ptr); break;
-      case T_SHORT:	*c = SHORT_STAR (r->ptr); break;
-      case T_LONG:	*c = LONG_STAR (r->ptr); break;
-    }
-    return GOT_NUM;
+  register unsigned char *q, *end, *m;
+  register int i, last = sp->len - 1;
+  unsigned char lmask = sp->mask [last], lval = sp->val [last];
+
+  end = adr + cnt;
+  for (q = adr; q < end; q += sp->skip [q [last]]) {
+    if ((q [last] & lmask) != lval) continue;
+    for (i = last - 1, m = q + i; i >= 0; --i, --m)
+      if ((*m & sp->mask [i]) != sp->val [i]) break;
+    if (i < 0) return q - adr;
   }
-  return BAD_NUM;
+  return -1;
 }
 
 /* Part of expression parser.  **p should point to a number.
@@ -849,7 +842,7 @@ char *p;
 baud (p)
 char *p;
 {
-  int rate, uart;
+  int rate, uart, flow;
 
   switch (getIntScan (&p, &rate)) {
     case BAD_NUM:
@@ -865,6 +858,25 @@ char *p;
       uart = DEFAULT_UART;
       break;
   }
-  db_setbaud (rate, uart);
+  switch (getIntScan (&p, &flow)) {
+    case BAD_NUM:
+      myPrintf ("Bad flow control\n");
+      return;
+    case NO_NUM:
+      flow = 0;
+      break;
+  }
+  if (uart < 0 || uart > 7) {
+    myPrintf ("Bad uart number\n");
+    return;
+  }
+  switch (setbaud (rate, uart, flow != 0)) {
+    case 0:
+      myPrintf ("Bad baud rate\n");
+      break;
+    case -1:
+      myPrintf ("UART %d is open at a rate this would change\n", uart ^ 1);
+      break;
+  }
 }
 #endif
@@ -6,10 +6,12 @@
 
 #if STANDALONE
 #define BASE 0
+#ifndef DEFAULT_BAUD			/* the Makefile builds a ROM for each */
 #define DEFAULT_BAUD	9600
+#endif
 #define DEFAULT_UART	0		/* right for pc532 */
-#define getch() db_fgetc(DEFAULT_UART)
-#define putch(x) db_fputc(x, DEFAULT_UART)
+#define getch() uart_getc(DEFAULT_UART)
+#define putch(x) uart_putc(x, DEFAULT_UART)
 #else
 #define BASE ((long)(fileBase))
 #endif
@@ -26,8 +28,10 @@
 #endif
 
 #if UNIX
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
 #define PRINTFINC 0
-#define NULL 0
 #define myPrintf printf
 #define mySprintf sprintf
 #define getch ttgetc
@@ -76,6 +80,8 @@ extern long defaultBase;
 #define True 1
 #define False 0
 #define LNLEN 256
+#define EXPRLEN 32		    /* longs in a compiled expression */
+#define TIMER_HZ 921600L	    /* ICU counter clock, 3.6864 MHz / 4 */
 
 /* Stuff for myStrCmp()
  */
@@ -83,6 +89,32 @@ extern long defaultBase;
 #define CMP_MATCH	1
 #define CMP_SUBSTR	2
 
+/* Prefix trie of table names, see trie.c.  Node 0 is the empty prefix.
+ */
+struct tnode {			/* at most 256, for 254 entries */
+  char c;			/* last character of this prefix */
+  unsigned char kid, sib;	/* first longer prefix, next at this length,
+				   0 (the root) if none */
+  unsigned char last;		/* entry + 1 named this prefix, or 0 */
+};
+struct trie {
+  struct tnode *node;
+  int size, used;
+};
+#define TRIE_NONE	(-1)
+#define TRIE_AMBIG	(-2)
+
+/* Functions called from other files, among them the host tools which
+ * link disasm.c, newreg.c and trie.c (Culbertson-host).
+ */
+extern int scan (), getIntScan (), morePrintf (), myStrCmp ();
+extern int initInsn (), dasm_ns32k (), formatAsm (), reverseBits ();
+extern int trieAdd (), trieFind (), trieList ();
+extern struct tnode *trieWalk ();
+#if !UNIX
+extern int tolower ();
+#endif
+
 extern char *fileBase,              /* beginning of file buffer */
        version[];		    /* date of make */
 extern unsigned char *Dot;          /* current point in virtual space */
@@ -91,8 +123,13 @@ extern long fileTop;                /* offset to end of file buffer */
 extern long screenLength;            /* number of lines on the screen */
 extern int screenShown;             /* # of lines printed since prompt */
 extern int screenIgnore;            /* on if discarding output */
+extern int batch;		    /* running a script, do not page */
 extern long debug;		    /* turn on debugging printf's */
 extern long scsiAdr, scsiLun;	    /* SCSI defaults */
+extern long scsiTime;		    /* report READ/WRITE speed */
+extern long scsiIntr;		    /* SCSI commands end by interrupt */
+extern long cacheRA;		    /* SCSI blocks to read ahead */
+extern char cmdWord [];		    /* scratch for scanToken() */
 
 #if LSC
 #define swaps(x)    {short T = (((x)&0xff)<<8);\
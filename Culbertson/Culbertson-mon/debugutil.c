@@ -22,6 +22,18 @@ register char *p1, *p2;
   return CMP_NOMATCH;
 }
 
+/* Hash a string for the register and symbol tables.
+ */
+unsigned
+strHash (s)
+register char *s;
+{
+  register unsigned h = 0;
+
+  while (*s != '\0') h = h * 31 + *s++;
+  return h;
+}
+
 int
 strlen(s)
 register char *s;
@@ -65,3 +77,136 @@ char    c;
     return( (c>='A')&&(c<='Z') ? (c+('a'-'A')) : c );
 }
 #endif /* STANDALONE & !LSC */
+
+/* Block memory operations for FILL, MOVE and SEARCH.  The inner loops
+ * are the string instructions in memlib.s; the destination is brought to
+ * a doubleword boundary a byte at a time so movsd never straddles one on
+ * the write side, and the odd bytes left at the end go singly.
+ */
+
+long db_skpsb (), db_cmpsb ();
+
+/* Copy cnt bytes from src to dst.  The strings may overlap.
+ */
+blockMove (src, dst, cnt)
+unsigned char *src, *dst;
+long cnt;
+{
+  long odd;
+
+  if (dst <= src || dst >= src + cnt) {
+    odd = -(long)dst & 3;
+    if (odd > cnt) odd = cnt;
+    db_movsb (src, dst, odd);
+    src += odd;
+    dst += odd;
+    cnt -= odd;
+    db_movsd (src, dst, cnt >> 2);
+    db_movsb (src + (cnt & ~3), dst + (cnt & ~3), cnt & 3);
+  } else {
+    src += cnt;				/* overlapping, copy from the top */
+    dst += cnt;
+    odd = (long)dst & 3;
+    if (odd > cnt) odd = cnt;
+    db_bmovsb (src, dst, odd);
+    src -= odd;
+    dst -= odd;
+    cnt -= odd;
+    db_bmovsd (src, dst, cnt >> 2);
+    db_bmovsb (src - (cnt & ~3), dst - (cnt & ~3), cnt & 3);
+  }
+}
+
+/* Fill cnt bytes at dst with the size byte (1, 2 or 4) pattern pat,
+ * low byte first.  The first aligned doubleword is built by hand, then
+ * movsd copies each doubleword to the one after it.
+ */
+blockFill (dst, cnt, pat, size)
+unsigned char *dst;
+long cnt, pat;
+int size;
+{
+  long i, odd;
+
+#define PAT_BYTE(i)	(pat >> 8 * ((i) % size))
+  odd = -(long)dst & 3;
+  if (odd > cnt) odd = cnt;
+  for (i = 0; i < odd; ++i) dst [i] = PAT_BYTE (i);
+  if (cnt - odd >= 4) {
+    for (i = odd; i < odd + 4; ++i) dst [i] = PAT_BYTE (i);
+    db_movsd (dst + odd, dst + odd + 4, ((cnt - odd) >> 2) - 1);
+  }
+  for (i = odd + ((cnt - odd) & ~3); i < cnt; ++i) dst [i] = PAT_BYTE (i);
+#undef PAT_BYTE
+}
+
+/* Return the offset from adr of the first copy of the len byte string
+ * pat in the cnt bytes at adr, or -1.  A match may run past adr + cnt.
+ */
+long
+blockFind (adr, cnt, pat, len)
+unsigned char *adr, *pat;
+long cnt;
+int len;
+{
+  long at, left;
+
+  for (at = 0; at < cnt; ++at) {
+    if (0 == (left = db_skpsb (adr + at, cnt - at, *pat))) break;
+    at = cnt - left;
+    if (len <= 1 || 0 == db_cmpsb (adr + at + 1, pat + 1, (long)len - 1))
+      return at;
+  }
+  return -1;
+}
+
+#if !STANDALONE
+/* What memlib.s does, for versions without it
+ */
+db_movsb (src, dst, cnt)
+unsigned char *src, *dst;
+long cnt;
+{
+  while (cnt-- > 0) *dst++ = *src++;
+}
+
+db_movsd (src, dst, cnt)
+unsigned char *src, *dst;
+long cnt;
+{
+  db_movsb (src, dst, 4 * cnt);
+}
+
+db_bmovsb (src, dst, cnt)
+unsigned char *src, *dst;
+long cnt;
+{
+  while (cnt-- > 0) *--dst = *--src;
+}
+
+db_bmovsd (src, dst, cnt)
+unsigned char *src, *dst;
+long cnt;
+{
+  db_bmovsb (src, dst, 4 * cnt);
+}
+
+long
+db_skpsb (adr, cnt, c)
+unsigned char *adr;
+long cnt;
+int c;
+{
+  for (; cnt > 0 && *adr != (unsigned char)c; --cnt, ++adr);
+  return cnt;
+}
+
+long
+db_cmpsb (p1, p2, cnt)
+unsigned char *p1, *p2;
+long cnt;
+{
+  for (; cnt > 0 && *p1 == *p2; --cnt, ++p1, ++p2);
+  return cnt;
+}
+#endif /* !STANDALONE */
@@ -42,7 +42,7 @@ formatOperand(operand, text)
 struct operand *operand;
 unsigned char text[];
 {
-    int need_comma, i, mask, textlen;
+    int need_comma, i, mask, textlen = 0;
 
     switch (operand->o_mode) {
 
@@ -207,6 +207,119 @@ unsigned char text[];
     return(textlen);
 }
 
+/* Cache of decoded instructions, keyed by address.  Commands which write
+ * memory (EDIT, FILL, MOVE, DOWNLOAD, READ) invalidate the entries they
+ * overlap, and RUN flushes the lot since the user program may write
+ * anywhere.  STEP flushes only after an instruction which may store
+ * (insn_stores) or a trap, so stepping through a loop hits.  An entry
+ * is some 140 bytes of bss, so the cache is small.  An entry with
+ * ic_len zero is empty.
+ */
+#define ICACHE_SIZE	4		/* power of 2 */
+#define ICACHE_HASH(a)	(((a) ^ ((a) >> 5)) & (ICACHE_SIZE - 1))
+
+struct icache {
+    long	ic_adr;
+    int		ic_len;
+    struct insn	ic_insn;
+};
+
+struct icache icache [ICACHE_SIZE];
+
+/* Look up the instruction at adr.  Return its length, or 0 if it is not
+ * in the cache.
+ */
+int
+icache_get(insn, adr)
+struct insn *insn;
+long adr;
+{
+    register struct icache *ic = &icache[ICACHE_HASH(adr)];
+
+    if (ic->ic_len == 0 || ic->ic_adr != adr) return 0;
+    *insn = ic->ic_insn;
+    return ic->ic_len;
+}
+
+icache_put(insn, adr, len)
+struct insn *insn;
+long adr;
+int len;
+{
+    register struct icache *ic = &icache[ICACHE_HASH(adr)];
+
+    ic->ic_adr = adr;
+    ic->ic_len = len;
+    ic->ic_insn = *insn;
+}
+
+/* Forget instructions overlapping len bytes at adr.
+ */
+icache_inval(adr, len)
+long adr, len;
+{
+    register struct icache *ic;
+
+    for (ic = icache; ic < &icache[ICACHE_SIZE]; ++ic)
+	if (ic->ic_adr < adr + len && ic->ic_adr + ic->ic_len > adr)
+	    ic->ic_len = 0;
+}
+
+icache_flush()
+{
+    register struct icache *ic;
+
+    for (ic = icache; ic < &icache[ICACHE_SIZE]; ++ic)
+	ic->ic_len = 0;
+}
+
+/* Decode the instruction at buffer, going through the cache.
+ * formatAsm() destroys the insn, so the cache keeps its own copy.
+ */
+int
+dasm_cached(insn, buffer)
+struct insn *insn;
+unsigned char buffer[];
+{
+    int len;
+
+    if (0 != (len = icache_get(insn, (long)buffer))) return len;
+    initInsn (insn);
+    len = dasm_ns32k(insn, buffer);
+    icache_put(insn, (long)buffer, len);
+    return len;
+}
+
+/* Return 1 if executing insn may store to memory: it has a memory
+ * operand, pushes on the stack or moves a string (formats 1, 3 and 5),
+ * or did not decode.
+ */
+int
+insn_stores(insn)
+struct insn *insn;
+{
+    int i;
+
+    switch (insn->i_format) {
+    case ITYPE_FMT1:
+    case ITYPE_FMT3:
+    case ITYPE_FMT5:
+    case ITYPE_UNDEF:
+        return 1;
+    }
+    for (i = 0; i < 4; i++)
+        switch (insn->i_opr[i].o_mode) {
+        case AMODE_RREL:
+        case AMODE_MREL:
+        case AMODE_ABS:
+        case AMODE_EXT:
+        case AMODE_TOS:
+        case AMODE_MSPC:
+            return 1;
+        }
+    return 0;
+}
+
 disassemble(p)
 char *p;
 {
@@ -236,8 +349,7 @@ char *p;
     while (cnt > 0) {
         int ate;
         
-        initInsn (&insn);
-        ate = dasm_ns32k(&insn, Dot + BASE);
+        ate = dasm_cached(&insn, Dot + BASE);
         formatAsm(&insn, text);
         morePrintf(1, "%08lx\t%s\n", Dot, text);
         Dot += ate;
@@ -411,7 +523,7 @@ unsigned char byte0, byte1;
         opr++;
 
     if (mask&0x1) {
-        if (insn->i_opr[opr].o_iscale = GetGenSI(gen0)) {
+        if ((insn->i_opr[opr].o_iscale = GetGenSI(gen0)) != 0) {
             ScaledFields(buffer[0], insn->i_opr[opr].o_ireg,
                 gen0);
             consumed++;
@@ -37,15 +37,63 @@
  *   polynomial (x^16 + x^12 + x^5 + 1).  Compute on data only (not
  *   length or start) and exclude quotes.  (This is the same CRC
  *   as computed by Minix's CRC command.)
+ *
+ * Block protocol:
+ *
+ * If the start mark is a semicolon rather than a colon, the transfer
+ * is broken into blocks which are acknowledged one at a time, so a line
+ * error costs one block rather than the whole transfer.  No quoting is
+ * done; each block carries its own length and CRC instead.
+ *
+ *   ; <length> <CRC>			header, <CRC> on the 4 length bytes
+ *   SOH <seq> <~seq> <flags> <size> <data> <CRC>	block, <size> 2 bytes
+ *   EOT				end, once every block is acknowledged
+ *
+ * Block n holds data bytes n*BLKSZ through n*BLKSZ+BLKSZ-1; <seq> is n
+ * modulo 256 and <~seq> its complement, which makes it unlikely that an
+ * 0x01 in the data is taken for SOH.  <CRC> covers <seq> through
+ * <data>.  If bit 0 of <flags> is set, <data> is run-length encoded: a
+ * byte c < 128 is followed by c+1 literal bytes, a byte c >= 128 is
+ * followed by one byte to be repeated c-125 times.  A block whose
+ * encoding is no shorter is sent as is.
+ *
+ * DST answers the header with 'H' (or 'N' if the CRC is bad), each
+ * block with 'A' <seq> (or 'N' <seq>), and the EOT with 'E'.  SRC may
+ * send up to WINDOW blocks beyond the oldest unacknowledged one and
+ * resends a block on 'N' or when its acknowledgement is late.  DST
+ * keeps blocks which arrive out of order, so only the bad ones are
+ * resent.  DST never times out.  After a bad block DST hunts for the
+ * next SOH through data which may hold anything, so it takes ABORT
+ * control-C's in a row to abort.
+ *
+ * Text records:
+ *
+ * DOWNLOAD HEX takes Intel HEX or Motorola S-records, as sent by
+ * pasting a file into the terminal emulator.  Each record is stored
+ * as it arrives, at the address it gives plus an optional offset, so
+ * there is no length to send first and nothing is staged.  Intel
+ * records 00 to 05 and S-records S0 to S9, but S4, are understood; 02 or
+ * 04 sets the upper address bits for the records after it.  A record
+ * whose checksum is bad has already been stored, so it is reported by
+ * number and the file is best sent again.  The transfer ends with an
+ * end record (01, S7, S8 or S9) or a control-C.
  */
 
 #include "debugger.h"
-#define GEN_CCITT	0x11021L
+#include "crctab.h"
 #define ESC		0x1b
 #define CTLC		0x03
 #define START		':'
-
-unsigned long update_crc();
+#define BSTART		';'		/* block protocol start mark */
+#define SOH		0x01
+#define EOT		0x04
+#define BLKSZ		512
+#define WINDOW		8		/* blocks in flight, at most 32 */
+#define F_RLE		0x01		/* <flags>: data is run-length encoded */
+#define ABORT		8		/* control-C's to abort block protocol */
+#define HSTART		':'		/* Intel HEX record mark */
+#define SSTART		'S'		/* S-record mark */
+#define MAXBAD		8		/* bad records listed */
 
 /* Compute CRC on memory.  This can be used to see if a chunk of
  * memory has been corrupted.
@@ -54,7 +102,7 @@ crc (p)
 char *p;
 {
   unsigned long crc = 0, adr, len;
-  unsigned char *cp;
+  register unsigned char *cp, *endp;
 
   if (GOT_NUM != getIntScan (&p, &adr) ||
       GOT_NUM != getIntScan (&p, &len))
@@ -63,8 +111,9 @@ char *p;
     return;
   }
   adr += BASE;
-  for (cp = (unsigned char *)adr; cp < (unsigned char *)adr + len; ++cp)
-    crc = update_crc (crc, *cp);
+  endp = (unsigned char *)adr + len;
+  for (cp = (unsigned char *)adr; cp < endp; ++cp)
+    crc = UPDATE_CRC (crc, *cp);
   myPrintf ("CRC: %d\n", crc);
 }
 
@@ -76,7 +125,20 @@ char *p;
   unsigned long crc, adr, len;
   unsigned char c;
   unsigned short xcrc;
+  char *save;
+  int ret;
 
+  save = p;
+  scanToken (&p, cmdWord);
+  if (CMP_MATCH == myStrCmp (cmdWord, "hex")) {
+    if (BAD_NUM == (ret = getIntScan (&p, &adr))) {
+      myPrintf ("Bad offset\n");
+      return;
+    }
+    hex_download (ret == GOT_NUM? adr: 0L);
+    return;
+  }
+  p = save;
   if (GOT_NUM != getIntScan (&p, &adr)) {
     myPrintf ("Bad argument\n");
     return;
@@ -85,11 +147,16 @@ char *p;
   for (;;) {				/* get start character */
     c = getch();
     if (c == START) break;
+    if (c == BSTART) {
+      block_download ((unsigned char *)adr);
+      return;
+    }
     if (c == CTLC) return;
   }
   if (!get_buf ((unsigned char *)&len,	/* get len (assume big endian) */
     4L, &crc)) return;
   crc = 0;				/* crc on data only */
+  icache_inval (adr, len);
   if (!get_buf ((unsigned char *)adr,	/* get data */
     len, &crc)) return;
   if (!get_buf ((unsigned char *)&xcrc,	/* get crc (assume big endian) */
@@ -111,28 +178,305 @@ unsigned char *adr;
 unsigned long len, *crc;
 {
   unsigned char c;
+  register unsigned long r = *crc;
 
   while (len > 0) {
     c = getch ();
     if (c == CTLC) return 0;		/* handle control-C */
     if (c == ESC) c = getch ();		/* handle quote */
     *adr++ = c;
-    *crc = update_crc (*crc, c);	/* compute crc, skip quote */
+    r = UPDATE_CRC (r, c);		/* compute crc, skip quote */
     --len;
   }
+  *crc = r;
   return 1;
 }
 
-unsigned long
-update_crc (crc, new_ch)
-unsigned long crc;
-int new_ch;
+unsigned char blk_buf [BLKSZ];
+
+/* Read the rest of a block protocol header.  Return the length, or -1
+ * if the CRC is bad.
+ */
+long
+get_header ()
 {
+  unsigned char b [6];
+  unsigned long crc = 0;
   int i;
 
-  for (i = 0x80; i; i >>= 1) {
-    crc = (crc << 1) | (i & new_ch? 1: 0);
-    if (crc & 0x10000) crc ^= GEN_CCITT;
+  for (i = 0; i < 6; ++i) b[i] = getch();
+  for (i = 0; i < 4; ++i) crc = UPDATE_CRC (crc, b[i]);
+  if (crc != (b[4] | b[5] << 8)) return -1;
+  return b[0] | b[1] << 8 | (long)b[2] << 16 | (long)b[3] << 24;
+}
+
+/* Read the rest of a block into blk_buf.  Return the size of the data,
+ * -1 if the block is bad, or -2 if the SOH was not the start of a block.
+ */
+int
+get_block (seq, flags)
+int *seq, *flags;
+{
+  register unsigned char *p;
+  register unsigned long crc;
+  int size, c;
+
+  *seq = getch();
+  c = getch();
+  if ((*seq ^ c) != 0xff) return -2;
+  *flags = getch();
+  size = getch();
+  size |= getch() << 8;
+  if (size > BLKSZ) return -1;
+  crc = UPDATE_CRC (0L, *seq);
+  crc = UPDATE_CRC (crc, c);
+  crc = UPDATE_CRC (crc, *flags);
+  crc = UPDATE_CRC (crc, size);
+  crc = UPDATE_CRC (crc, size >> 8);
+  for (p = blk_buf; p < blk_buf + size; ++p) {
+    *p = c = getch();
+    crc = UPDATE_CRC (crc, c);
+  }
+  c = getch();
+  c |= getch() << 8;
+  return (crc == c)? size: -1;
+}
+
+/* Expand size bytes of run-length encoded data from blk_buf to dst,
+ * which has room for len bytes.  Return 1 if exactly len came out.
+ */
+int
+unrle (dst, len, size)
+register unsigned char *dst;
+int len, size;
+{
+  register unsigned char *p = blk_buf, *endp = dst + len;
+  register int n;
+
+  while (p < blk_buf + size) {
+    n = *p++;
+    if (n < 128) {
+      if (dst + n + 1 > endp || p + n + 1 > blk_buf + size) return 0;
+      while (n-- >= 0) *dst++ = *p++;
+    } else {
+      n -= 125;
+      if (dst + n > endp || p >= blk_buf + size) return 0;
+      while (n-- > 0) *dst++ = *p;
+      ++p;
+    }
+  }
+  return dst == endp;
+}
+
+/* Receive a transfer using the block protocol.  The start mark has been
+ * read.  Blocks are stored straight into place, so out of order arrivals
+ * need only a bit each in got, which is relative to block base.
+ */
+block_download (adr)
+unsigned char *adr;
+{
+  long len, nblk, base, n;
+  unsigned long got, crc;
+  unsigned char c, *dst;
+  int seq, flags, size, bad, cnt, ok, ctlc;
+
+  for (;;) {
+    if (0 <= (len = get_header())) break;
+    putch ('N');
+    do {				/* wait for SRC to try again */
+      c = getch();
+      if (c == CTLC) return;
+    } while (c != BSTART);
+  }
+  putch ('H');
+  icache_inval ((long)adr, len);
+  nblk = (len + BLKSZ - 1) / BLKSZ;
+  base = 0;
+  got = 0;
+  bad = ctlc = 0;
+  for (;;) {
+    c = getch();
+    if (c != CTLC) ctlc = 0;
+    else if (++ctlc == ABORT) return;
+    if (c == BSTART) {			/* our 'H' was lost */
+      if (len == get_header()) putch ('H');
+      continue;
+    }
+    if (c == EOT && base == nblk) break;
+    if (c != SOH) continue;
+    if (-2 == (size = get_block (&seq, &flags))) continue;
+    if (size < 0) {
+      ++bad;
+      putch ('N');
+      putch (seq);
+      continue;
+    }
+    n = (seq - base) & 0xff;
+    if (n >= WINDOW || base + n >= nblk) {
+      if (n >= 256 - WINDOW) {		/* our 'A' was lost */
+        putch ('A');
+        putch (seq);
+      }
+      continue;
+    }
+    if (!(got & 1L << n)) {
+      dst = adr + (base + n) * BLKSZ;
+      cnt = (len - (base + n) * BLKSZ < BLKSZ)?
+	len - (base + n) * BLKSZ: BLKSZ;
+      if (flags & F_RLE) ok = unrle (dst, cnt, size);
+      else {
+	ok = (size == cnt);
+	for (n = 0; ok && n < cnt; ++n) dst[n] = blk_buf[n];
+      }
+      if (!ok) {
+	++bad;
+	putch ('N');
+	putch (seq);
+	continue;
+      }
+      got |= 1L << ((seq - base) & 0xff);
+      while (got & 1) {
+	got >>= 1;
+	++base;
+      }
+    }
+    putch ('A');
+    putch (seq);
+  }
+  putch ('E');
+  for (;;) {				/* let user return to terminal */
+    c = getch();
+    if (c == '\r' || c == '\n') break;	/* user hits <return> */
+    if (c == CTLC) return;
+  }
+  crc = 0;
+  for (dst = adr; dst < adr + len; ++dst) crc = UPDATE_CRC (crc, *dst);
+  myPrintf ("Length = %d, CRC = %d, %d bad blocks\n", len, crc, bad);
+}
+
+/* Value of character c as a hex digit; -1 if it is not one, -2 for
+ * control-C, -3 and -4 for the record marks, which end a short record
+ * and start the next.
+ */
+static int
+hex_val (c)
+register int c;
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return (c == CTLC)? -2: (c == HSTART)? -3: (c == SSTART)? -4: -1;
+}
+
+/* Read two hex digits.  Return the byte, or the hex_val of the first
+ * character which is not a digit; nothing after it is read.
+ */
+int
+get_hex ()
+{
+  register int h, l;
+
+  if (0 > (h = hex_val (getch () & 0xff))) return h;
+  if (0 > (l = hex_val (getch () & 0xff))) return l;
+  return h << 4 | l;
+}
+
+/* Receive Intel HEX or S-records and store their data at off plus the
+ * addresses they give.  The checksum is summed as the bytes go by, so
+ * it is known as soon as the last one arrives; a record which sets an
+ * address takes effect only if its checksum is good.
+ */
+hex_download (off)
+unsigned long off;
+{
+  static char *why [] = {"bad checksum", "not hex", "unknown type"};
+  unsigned long base = 0, adr, val, lo = ~0L, hi = 0, nbytes = 0;
+  unsigned long entry = 0;
+  long nrec = 0, nbad = 0, bad [MAXBAD];
+  char badwhy [MAXBAD];
+  register unsigned char *dst;
+  register int b, n, sum;
+  int c, intel, type, alen, err, i, done = 0, gotentry = 0, next = 0;
+
+  while (!done) {
+    c = next? next: getch ();
+    next = 0;
+    if (c == CTLC) break;
+    if (c != HSTART && c != SSTART) continue;	/* CR, LF, blanks */
+    ++nrec;
+    err = -1;
+    intel = (c == HSTART);
+    if (intel) {				/* :nn aaaa tt <data> ss */
+      if (0 > (b = get_hex ())) goto digit;
+      sum = n = b;
+      alen = 2;
+    } else {					/* St nn aaaa <data> ss */
+      if (0 > (b = hex_val (getch () & 0xff))) goto digit;
+      type = b;
+      if (0 > (b = get_hex ())) goto digit;
+      sum = n = b;
+      alen = (type <= 1 || type == 5 || type == 9)? 2:
+	(type == 2 || type == 6 || type == 8)? 3: 4;
+      if (type == 4 || n < alen + 1) err = 2;
+      n -= alen + 1;
+    }
+    for (adr = 0, i = 0; i < alen; ++i) {
+      if (0 > (b = get_hex ())) goto digit;
+      sum += b;
+      adr = adr << 8 | b;
+    }
+    if (intel) {
+      if (0 > (b = get_hex ())) goto digit;
+      sum += type = b;
+      if (type > 5) err = 2;
+      dst = (type == 0)? (unsigned char *)(BASE + off + base + adr): 0;
+    } else if (type >= 1 && type <= 3 && err < 0)
+      dst = (unsigned char *)(BASE + off + adr);
+    else dst = 0;
+    if (dst != 0 && n > 0) {			/* for icache_inval */
+      if ((unsigned long)dst < lo) lo = (unsigned long)dst;
+      if ((unsigned long)dst + n > hi) hi = (unsigned long)dst + n;
+    }
+    for (val = 0, i = n; i > 0; --i) {		/* data */
+      if (0 > (b = get_hex ())) goto digit;
+      sum += b;
+      if (dst != 0) *dst++ = b;
+      else val = val << 8 | b;
+    }
+    if (dst != 0) nbytes += n;
+    if (0 > (b = get_hex ())) goto digit;
+    if (((sum + b) & 0xff) != (intel? 0: 0xff) && err < 0) err = 0;
+    if (err >= 0) goto bad;
+    if (intel) switch (type) {
+      case 1: done = 1; break;
+      case 2: base = val << 4; break;
+      case 3: entry = (val >> 16 << 4) + (val & 0xffff); gotentry = 1; break;
+      case 4: base = val << 16; break;
+      case 5: entry = val; gotentry = 1; break;
+    } else if (type >= 7) {
+      entry = adr;
+      gotentry = 1;
+      done = 1;
+    }
+    continue;
+  digit:
+    if (b == -2) break;				/* control-C */
+    if (b < -2) next = (b == -3)? HSTART: SSTART;	/* read it again */
+    err = 1;
+  bad:
+    if (nbad < MAXBAD) {
+      bad [nbad] = nrec;
+      badwhy [nbad] = err;
+    }
+    ++nbad;
   }
-  return crc;
+  if (done) while ((c = getch ()) != '\r' && c != '\n' && c != CTLC);
+  if (hi > lo) icache_inval (lo, hi - lo);
+  myPrintf ("%ld records, %ld bytes", nrec, nbytes);
+  if (hi > lo) myPrintf (" in 0x%lx-0x%lx", lo - BASE, hi - 1 - BASE);
+  if (gotentry) myPrintf (", entry 0x%lx", entry);
+  myPrintf ("%s\n", done? "": ", stopped before the end record");
+  for (i = 0; i < nbad && i < MAXBAD; ++i)
+    myPrintf ("record %ld: %s\n", bad [i], why [badwhy [i]]);
+  if (nbad > MAXBAD) myPrintf ("and %ld more bad records\n", nbad - MAXBAD);
 }
@@ -0,0 +1,474 @@
+/* NSC 32000 ROM debugger.
+ *
+ * Expressions.  An expression is compiled once into a short list of
+ * operations for a stack machine, which can then be evaluated as often
+ * as needed without looking at the text again.  Registers become
+ * pointers to their value, symbols and constant subexpressions become
+ * numbers; only memory fetches and virtual address translation are
+ * left for evaluation time.
+ */
+
+#include "debugger.h"
+
+/* Operations.  X_CONST and the X_REG* are followed by their operand.
+ */
+#define X_END		0
+#define X_CONST		1		/* push number */
+#define X_REGB		2		/* push byte register */
+#define X_REGW		3		/* push word register */
+#define X_REGD		4		/* push doubleword register */
+#define X_FETCHB	5		/* replace address by byte there */
+#define X_FETCHW	6
+#define X_FETCHD	7
+#define X_NEG		8
+#define X_ADD		9		/* binary, pop y, pop x, push x op y */
+#define X_SUB		10
+#define X_MUL		11
+#define X_DIV		12
+#define X_MOD		13
+#define X_SHL		14
+#define X_SHR		15
+#define X_PTB		16		/* push current page table base */
+#define X_VADDR		17		/* pop ptb, translate address */
+
+#define EXPRSTK		16		/* evaluation stack depth */
+
+/* Compiler state
+ */
+struct xcomp {
+  long *code, *end;			/* next free slot, end of buffer */
+  int consts;				/* X_CONSTs just emitted */
+  int depth, ok;
+};
+
+#define VIEWLEN		32
+#define NVIEW		4
+
+/* Expressions shown each time the monitor gets control
+ */
+struct view {
+  char text [VIEWLEN];
+  long code [EXPRLEN];
+} viewTab [NVIEW];
+int nview;
+
+static long scanCode [EXPRLEN];		/* for getIntScan() */
+
+/* Parse an expression from the passed string.  For consistency, all
+ * command handlers should use this for parsing numeric arguments.
+ * Advances *p past the current expression.
+ *
+ * Return GOT_NUM if got legal input, NO_NUM if there was none, else
+ * BAD_NUM.  Legal inputs are:
+ *   simple expressions using + - * / % << >> and ().
+ *   . (return Dot)
+ *   pc, fp, usp, or isp (return machState.xxx)
+ *   '<character>
+ *   <number> (default radix)
+ *   b'<binary number>
+ *   d'<decimal number>
+ *   h'<hex number>
+ *   r'<register>
+ *   s'<symbol>, or just <symbol> if it is not a number or register
+ *   b:<adr>, w:<adr>, d:<adr> (fetch byte, word, doubleword)
+ *   v(<vaddr>[,<ptb>]) (translate virtual address)
+ */
+int
+getIntScan (p, c)
+char **p;
+long *c;
+{
+  int ret;
+
+  if (GOT_NUM != (ret = exprCompile (p, scanCode, EXPRLEN))) return ret;
+  return exprEval (scanCode, c);
+}
+
+/* Compile the expression at *p into code, which has room for len
+ * longs.  Return as getIntScan().
+ */
+int
+exprCompile (p, code, len)
+char **p;
+long *code;
+int len;
+{
+  struct xcomp x;
+  int ret;
+
+  x.code = code;
+  x.end = code + len - 1;		/* room for X_END */
+  x.consts = x.depth = 0;
+  x.ok = 1;
+  ret = compSum (&x, p);
+  *x.code = X_END;
+  if (ret == GOT_NUM && !x.ok) ret = BAD_NUM;
+  return ret;
+}
+
+/* Evaluate compiled code, leaving the value in *c.  Return GOT_NUM, or
+ * BAD_NUM if a virtual address did not translate or a divisor was 0.
+ */
+int
+exprEval (code, c)
+register long *code;
+long *c;
+{
+  long stk [EXPRSTK], y, translateVaddr(), getCurrentPtb();
+  register long *sp = stk - 1;
+
+  for (;;) {
+    switch ((int)*code++) {
+      case X_END:	*c = *sp; return GOT_NUM;
+      case X_CONST:	*++sp = *code++; break;
+      case X_REGB:	*++sp = CHAR_STAR (*code++); break;
+      case X_REGW:	*++sp = SHORT_STAR (*code++); break;
+      case X_REGD:	*++sp = LONG_STAR (*code++); break;
+      case X_FETCHB:	*sp = CHAR_STAR (*sp + BASE); break;
+      case X_FETCHW:	*sp = SHORT_STAR (*sp + BASE); break;
+      case X_FETCHD:	*sp = LONG_STAR (*sp + BASE); break;
+      case X_NEG:	*sp = -*sp; break;
+      case X_PTB:	*++sp = getCurrentPtb (); break;
+      case X_VADDR:
+	y = *sp--;
+	if (GOT_NUM != translateVaddr (*sp, y, sp)) return BAD_NUM;
+	break;
+      default:
+	y = *sp--;
+	if (0 == binop ((int)code [-1], sp, y)) return BAD_NUM;
+	break;
+    }
+  }
+}
+
+/* *x = *x op y.  Return 0 if op is not possible.
+ */
+int
+binop (op, x, y)
+int op;
+long *x, y;
+{
+  switch (op) {
+    case X_ADD:	*x += y; break;
+    case X_SUB:	*x -= y; break;
+    case X_MUL:	*x *= y; break;
+    case X_DIV:	if (y == 0) return 0; *x /= y; break;
+    case X_MOD:	if (y == 0) return 0; *x %= y; break;
+    case X_SHL:	*x <<= y; break;
+    case X_SHR:	*x >>= y; break;
+    default:	return 0;
+  }
+  return 1;
+}
+
+/* Add an operation, and its operand if it has one.  A binary or unary
+ * operation on constants is done now and replaced by its result.
+ */
+emit (x, op, arg)
+register struct xcomp *x;
+int op;
+long arg;
+{
+  long v;
+
+  if (op >= X_ADD && op <= X_SHR && x->consts >= 2) {
+    v = x->code [-3];
+    if (binop (op, &v, x->code [-1])) {
+      x->code -= 4;
+      x->consts -= 2;
+      op = X_CONST;
+      arg = v;
+      x->depth -= 2;
+    }
+  } else if (op == X_NEG && x->consts >= 1) {
+    x->code [-1] = -x->code [-1];
+    return;
+  }
+  if (x->code + (op <= X_REGD? 2: 1) > x->end) {
+    x->ok = 0;
+    return;
+  }
+  *x->code++ = op;
+  if (op <= X_REGD) *x->code++ = arg;
+  x->consts = (op == X_CONST)? x->consts + 1: 0;
+  if (op <= X_REGD || op == X_PTB) {
+    if (++x->depth > EXPRSTK) x->ok = 0;
+  } else if (op >= X_ADD && op <= X_SHR || op == X_VADDR) --x->depth;
+}
+
+/* Part of expression compiler, parses + and -.
+ */
+int
+compSum (x, p)
+struct xcomp *x;
+char **p;
+{
+  char op;
+  int ret;
+
+  ret = compTerm (x, p);
+  if (ret != GOT_NUM) return ret;
+  for (;;) {
+    scan (p);
+    op = **p;
+    if (op != '-' && op != '+') break;
+    ++(*p);
+    if (compTerm (x, p) != GOT_NUM) return BAD_NUM;
+    emit (x, (op == '-')? X_SUB: X_ADD, 0L);
+  }
+  return GOT_NUM;
+}
+
+/* Part of expression compiler, parses * / % << and >>.
+ */
+int
+compTerm (x, p)
+struct xcomp *x;
+char **p;
+{
+  char op;
+  int ret;
+
+  ret = compFactor (x, p);
+  if (ret != GOT_NUM) return ret;
+  for (;;) {
+    scan (p);
+    op = **p;
+    if (op != '*' && op != '/' && op != '%' && op != '<' && op != '>')
+      break;
+    if (op == '<' || op == '>') {
+      if (op != *(*p + 1)) return BAD_NUM;
+      ++(*p);
+    }
+    ++(*p);
+    if (compFactor (x, p) != GOT_NUM) return BAD_NUM;
+    switch (op) {
+      case '*': emit (x, X_MUL, 0L); break;
+      case '/': emit (x, X_DIV, 0L); break;
+      case '%': emit (x, X_MOD, 0L); break;
+      case '<': emit (x, X_SHL, 0L); break;
+      case '>': emit (x, X_SHR, 0L); break;
+    }
+  }
+  return GOT_NUM;
+}
+
+/* Part of expression compiler, parses operands and prefix operators.
+ */
+int
+compFactor (x, p)
+struct xcomp *x;
+char **p;
+{
+  long k;
+  int j;
+  char c0, c1, *q;
+
+  scan (p);
+  c0 = tolower(**p);
+  c1 = tolower(*(*p+1));
+  switch (c0) {
+    case '\n':
+    case '\0':
+      return NO_NUM;
+    case '-':					/* -exp */
+      ++*p;
+      if (GOT_NUM == (j = compFactor (x, p))) emit (x, X_NEG, 0L);
+      return j;
+    case '(':					/* (exp) */
+      ++*p;
+      if (GOT_NUM != compSum (x, p))
+        return BAD_NUM;
+      scan (p);
+      if (**p != ')')
+        return BAD_NUM;
+      ++*p;
+      return GOT_NUM;
+    case '\'':					/* ASCII code */
+      ++*p;
+      emit (x, X_CONST, (long)*(*p)++);
+      return GOT_NUM;
+    case 'b':
+      if (c1 == ':') {				/* b:adr, fetch char */
+        *p += 2;
+        if (GOT_NUM == (j = compFactor (x, p))) emit (x, X_FETCHB, 0L);
+        return j;
+      }
+      if (c1 == '\'') {				/* b'num, base = 2 */
+        *p += 2;
+	return compNum (x, p, 2L);
+      }
+      break;
+    case 'w':					/* w:adr, fetch short */
+      if (c1 == ':') {
+        *p += 2;
+        if (GOT_NUM == (j = compFactor (x, p))) emit (x, X_FETCHW, 0L);
+        return j;
+      }
+      break;
+    case 'd':					/* d:adr, fetch long */
+      if (c1 == ':') {
+        *p += 2;
+        if (GOT_NUM == (j = compFactor (x, p))) emit (x, X_FETCHD, 0L);
+        return j;
+      }
+      if (c1 == '\'') {				/* d'num, base 10 */
+        *p += 2;
+	return compNum (x, p, 10L);
+      }
+      break;
+    case 'h':					/* base 16 number */
+      if (c1 == '\'') {
+        *p += 2;
+	return compNum (x, p, 16L);
+      }
+      break;
+    case 'r':					/* r'<reg> */
+      /* force "f0" to be interpretted as a reg instead of a number */
+      if (c1 == '\'') {
+        *p += 2;
+	return compReg (x, p);
+      }
+      break;
+    case 's':					/* s'<symbol> */
+      if (c1 == '\'') {
+        *p += 2;
+	return compSym (x, p);
+      }
+      break;
+    case 'v':					/* v(vaddr[,ptb]) */
+      if (c1 == '(' || c1 == ' ' || c1 == '\t') {
+	++*p;
+	return compVaddr (x, p);
+      }
+      break;
+  }
+  if (getNum (p, &k, defaultBase) == GOT_NUM) {
+    emit (x, X_CONST, k);
+    return GOT_NUM;
+  }
+  q = *p;
+  if (GOT_NUM == compReg (x, p)) return GOT_NUM;
+  *p = q;
+  return compSym (x, p);
+}
+
+/* Part of expression compiler.  Number in the given base.
+ */
+int
+compNum (x, p, base)
+struct xcomp *x;
+char **p;
+long base;
+{
+  long k;
+
+  if (GOT_NUM != getNum (p, &k, base)) return BAD_NUM;
+  emit (x, X_CONST, k);
+  return GOT_NUM;
+}
+
+/* Part of expression compiler.  **p should point to a register name.
+ */
+int
+compReg (x, p)
+struct xcomp *x;
+char **p;
+{
+  char regbuf [80];
+  struct regTable *r, *find_reg();
+
+  scanreg (p, regbuf);				/* get register */
+  if (NULL == (r = find_reg (regbuf)) || NULL == r->ptr) return BAD_NUM;
+  switch (r->type & T_LEN) {
+    case T_CHAR:	emit (x, X_REGB, (long)r->ptr); break;
+    case T_SHORT:	emit (x, X_REGW, (long)r->ptr); break;
+    case T_LONG:	emit (x, X_REGD, (long)r->ptr); break;
+  }
+  return GOT_NUM;
+}
+
+/* Part of expression compiler.  **p should point to a symbol.
+ */
+int
+compSym (x, p)
+struct xcomp *x;
+char **p;
+{
+  char symbuf [80], *q;
+  long val;
+
+  for (q = symbuf; (REGCHAR (**p) || **p == '$') && q < symbuf + 79;)
+    *q++ = *(*p)++;
+  *q = '\0';
+  if (q == symbuf || !symLookup (symbuf, &val)) return BAD_NUM;
+  emit (x, X_CONST, val);
+  return GOT_NUM;
+}
+
+/* Part of expression compiler.  v(vaddr[,ptb]).
+ */
+int
+compVaddr (x, p)
+struct xcomp *x;
+char **p;
+{
+  scan(p);
+  if (**p != '(') return BAD_NUM;
+  ++*p;
+  if (GOT_NUM != compSum (x, p)) return BAD_NUM;
+  scan(p);
+  if (**p == ',') {
+    ++*p;
+    if (GOT_NUM != compSum (x, p)) return BAD_NUM;
+  } else emit (x, X_PTB, 0L);
+  scan(p);
+  if (**p != ')') return BAD_NUM;
+  ++*p;
+  emit (x, X_VADDR, 0L);
+  return GOT_NUM;
+}
+
+/* VIEW command handler.  Add an expression to those shown when the
+ * monitor gets control, or forget them all.
+ */
+view (p)
+char *p;
+{
+  register struct view *v;
+  char *q;
+  int i;
+
+  scan (&p);
+  if (*p == '\0' || *p == '\n') {
+    nview = 0;
+    return;
+  }
+  if (nview == NVIEW) {
+    myPrintf ("Only %d view expressions\n", NVIEW);
+    return;
+  }
+  v = &viewTab [nview];
+  q = p;
+  if (GOT_NUM != exprCompile (&p, v->code, EXPRLEN)) {
+    myPrintf ("Bad expression\n");
+    return;
+  }
+  for (i = 0; i < VIEWLEN - 1 && q < p; ++i) v->text [i] = *q++;
+  v->text [i] = '\0';
+  ++nview;
+  showView ();
+}
+
+/* Show the view expressions.
+ */
+showView ()
+{
+  register struct view *v;
+  long val;
+
+  for (v = viewTab; v < viewTab + nview; ++v)
+    if (GOT_NUM == exprEval (v->code, &val))
+      myPrintf ("%s = %lx\n", v->text, val);
+    else myPrintf ("%s = ?\n", v->text);
+}
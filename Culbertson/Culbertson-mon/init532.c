@@ -79,6 +79,11 @@ int	btext(),
 	isr_nbe(),
 	isr_ovf(),
 	isr_dbg(),
+	isr_duart0(),
+	isr_duart1(),
+	isr_duart2(),
+	isr_duart3(),
+	isr_scsi(),
 	ret_save();
 	
 /* Table for initializing interrupt vector table.
@@ -101,6 +106,17 @@ int ((*isrInitTab[])()) = {
 	isr_dbg,
 };
 #define ISRTABSZ (sizeof (isrInitTab)/sizeof (int ((*)())))
+
+/* DUART interrupt routines, by duart number.  Their vectors come from
+ * duart_vector() in uart.c.
+ */
+int ((*duartIsrTab[])()) = {
+	isr_duart0,
+	isr_duart1,
+	isr_duart2,
+	isr_duart3,
+};
+#define DUARTTABSZ (sizeof (duartIsrTab)/sizeof (int ((*)())))
 #endif
 
 /* Create a safe environment for user.
@@ -143,12 +159,46 @@ inttab_init()
   int ((**fn)());
   long *q;
 
+  int d;
+
   q = (long *) INTTAB_ADR;
   for (fn = isrInitTab; fn < isrInitTab + ISRTABSZ; ++fn)
     *q++ = MODTAB_ADR | ((long)(*fn - btext)) << 16;
+  q = (long *) INTTAB_ADR;
+  for (d = 0; d < DUARTTABSZ; ++d)
+    q [duart_vector (d)] = MODTAB_ADR | ((long)(duartIsrTab[d] - btext)) << 16;
+  q [scsi_vector ()] = MODTAB_ADR | ((long)(isr_scsi - btext)) << 16;
 }
 #endif
 
+#define MAX_INSN_LEN	20
+/* Decode the user's instruction at pc, through the cache, and find its
+ * physical address.  Return BAD_NUM if pc does not translate.
+ */
+static int
+pc_insn (insn, padr)
+struct insn *insn;
+long *padr;
+{
+  char buf [MAX_INSN_LEN], *bufp;
+  int i;
+  long adr, translateVaddr(), getCurrentPtb(), ptb;
+
+  ptb = getCurrentPtb();
+  if (GOT_NUM != translateVaddr (machState.pc + BASE, ptb, padr))
+    return BAD_NUM;
+  if (0 == icache_get (insn, *padr)) {
+    for (bufp = buf, i = 0; i < MAX_INSN_LEN; ++bufp, ++i) {
+      if (GOT_NUM != translateVaddr (machState.pc + BASE + i, ptb, &adr))
+	return BAD_NUM;
+      *bufp = *((char *)adr);
+    }
+    initInsn (insn);
+    icache_put (insn, *padr, dasm_ns32k (insn, buf));
+  }
+  return GOT_NUM;
+}
+
 /* Single step one instrution.  Then set breakpoints and set user going.
  * On return from user, clear breakpoints and print reason for return.
  */
@@ -164,15 +214,18 @@ char *p;
     return;
   } else if (ret == GOT_NUM) machState.pc = adr;
   machState.psr |= TRACE_FLAG;
-  if ((ret = resume()) != TRACE_VEC) {
+  ret = go();
+  icache_flush();			/* user may write anywhere */
+  if (ret != TRACE_VEC) {
     machState.psr &= ~TRACE_FLAG;
     print_return_info (ret);
     return;
   }
   machState.psr &= ~TRACE_FLAG;
   setBreaks();
-  ret = resume();
+  ret = go();
   clrBreaks();
+  icache_flush();
   print_return_info (ret);
 }
 
@@ -181,7 +234,9 @@ char *p;
 single_step(p)
 char *p;
 {
-  int ret, cnt;
+  struct insn insn;
+  int ret, cnt, stores;
+  long padr;
 
   switch (getIntScan (&p, &cnt)) {
     case NO_NUM:
@@ -193,32 +248,27 @@ char *p;
     default:;
   }
   do {
+    stores = BAD_NUM == pc_insn (&insn, &padr) || insn_stores (&insn);
     machState.psr |= TRACE_FLAG;
-    ret = resume();
+    ret = go();
+    if (stores || ret != TRACE_VEC) icache_flush();	/* may hit code */
   } while (--cnt > 0 && ret == TRACE_VEC);
   machState.psr &= ~TRACE_FLAG;
   print_return_info (ret);
 }
 
-#define MAX_INSN_LEN	20
 print_return_info (type)
 int type;
 {
   struct insn insn;
-  char text [50], buf [MAX_INSN_LEN], *bufp;
-  int i;
-  long adr, translateVaddr(), getCurrentPtb(), ptb;
+  char text [50];
+  long padr, getCurrentPtb(), ptb;
 
   ptb = getCurrentPtb();
-  for (bufp = buf, i = 0; i < MAX_INSN_LEN; ++bufp, ++i) {
-    if (GOT_NUM != translateVaddr (machState.pc + BASE + i, ptb, &adr)) {
-      printf ("Bad virtual address\n");
-      return;
-    }
-    *bufp = *((char *)adr);
+  if (BAD_NUM == pc_insn (&insn, &padr)) {
+    printf ("Bad virtual address\n");
+    return;
   }
-  initInsn (&insn);
-  dasm_ns32k (&insn, buf);
   formatAsm (&insn, text);
   printf ("%6lx%c\t%s\t(%s)\n",
     machState.pc,
@@ -226,6 +276,7 @@ int type;
     text,
     (type < 0 || type > FAKE_RET)?
     "unknown trap or interrupt": trap_string [type]);
+  showView ();
 }
 
 #if STANDALONE
@@ -293,3 +344,22 @@ resume()
 {
 }
 #endif
+
+/* Let the user program run.  The monitor's UART and SCSI interrupts are
+ * off meanwhile, so they cannot land in the user's interrupt table.
+ */
+int
+go()
+{
+  int ret;
+
+#if STANDALONE
+  scsi_suspend();
+  uart_suspend();
+  ret = resume();
+  uart_resume();
+#else
+  ret = resume();
+#endif
+  return ret;
+}
@@ -26,6 +26,7 @@ extern char *malloc();
 long screenLength = 24;             /* number of lines on the screen */
 int screenShown = 1;                /* # of lines printed since prompt */
 int screenIgnore = 0;               /* on if discarding output */
+int batch = 0;                      /* running a script, do not page */
 
 morePrintf(increment, a0, a1, a2, a3, a4 ,a5, a6, a7, a8, a9)
 int increment;
@@ -36,7 +37,7 @@ char *a0, *a1, *a2, *a3, *a4, *a5, *a6, *a7, *a8, *a9;
     if (screenIgnore)               /* if throwing away output */
         return;
     
-    while (screenShown >= screenLength) {
+    while (!batch && screenShown >= screenLength) {
         myPrintf("<MORE>...");
         reply = cooked_getc();
 /*      myPrintf("\b\b\b\b\b\b\b\b\b");  */
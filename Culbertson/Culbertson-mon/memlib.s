@@ -0,0 +1,97 @@
+;****************************************************
+; String instruction routines for debugger
+;
+; These let FILL, MOVE and SEARCH hand the inner
+; loops to movs, skps and cmps.  Alignment, overlap
+; and pattern phase are sorted out in C (debugutil.c),
+; which also has equivalents for non-ROM versions.
+;****************************************************
+
+	.program
+
+;****************************************************
+; _db_movsb, _db_movsd -- copy bytes or doublewords,
+;    lowest address first.
+;
+;    Enter: db_movsb (<src>, <dst>, <count>)
+;     Exit:
+; Destroys: r0, flags
+;****************************************************
+_db_movsb::
+	enter	[r1,r2],0
+	movd	8(fp),r1	;r1 = source
+	movd	12(fp),r2	;r2 = destination
+	movd	16(fp),r0	;r0 = byte count
+	movsb
+	exit	[r1,r2]
+	ret	0
+
+_db_movsd::
+	enter	[r1,r2],0
+	movd	8(fp),r1	;r1 = source
+	movd	12(fp),r2	;r2 = destination
+	movd	16(fp),r0	;r0 = doubleword count
+	movsd
+	exit	[r1,r2]
+	ret	0
+
+;****************************************************
+; _db_bmovsb, _db_bmovsd -- copy bytes or doublewords,
+;    highest address first.  The addresses passed are
+;    just past the ends of the strings.
+;
+;    Enter: db_bmovsb (<src end>, <dst end>, <count>)
+;     Exit:
+; Destroys: r0, flags
+;****************************************************
+_db_bmovsb::
+	enter	[r1,r2],0
+	addr	-1(8(fp)),r1	;r1 = last source byte
+	addr	-1(12(fp)),r2	;r2 = last destination byte
+	movd	16(fp),r0	;r0 = byte count
+	movsb	b
+	exit	[r1,r2]
+	ret	0
+
+_db_bmovsd::
+	enter	[r1,r2],0
+	addr	-4(8(fp)),r1	;r1 = last source doubleword
+	addr	-4(12(fp)),r2	;r2 = last destination doubleword
+	movd	16(fp),r0	;r0 = doubleword count
+	movsd	b
+	exit	[r1,r2]
+	ret	0
+
+;****************************************************
+; _db_skpsb -- skip bytes until one matches.
+;
+;    Enter: db_skpsb (<adr>, <count>, <byte>)
+;     Exit: r0 = bytes left, counting the match,
+;	    or 0 if there was no match
+; Destroys: flags
+;****************************************************
+_db_skpsb::
+	enter	[r1,r4],0
+	movd	8(fp),r1	;r1 = string
+	movd	12(fp),r0	;r0 = byte count
+	movzbd	16(fp),r4	;r4 = byte to stop at
+	skpsb	u
+	exit	[r1,r4]
+	ret	0
+
+;****************************************************
+; _db_cmpsb -- compare two byte strings.
+;
+;    Enter: db_cmpsb (<adr1>, <adr2>, <count>)
+;     Exit: r0 = 0 if the same, else bytes left,
+;	    counting the first mismatch
+; Destroys: flags
+;****************************************************
+_db_cmpsb::
+	enter	[r1,r2],0
+	movd	8(fp),r1	;r1 = first string
+	movd	12(fp),r2	;r2 = second string
+	movd	16(fp),r0	;r0 = byte count
+	cmpsb
+	exit	[r1,r2]
+	ret	0
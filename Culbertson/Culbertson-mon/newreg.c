@@ -88,11 +88,22 @@ struct regTable regTable[] = {
 #else
   {"scsi_adr",	(char *)(&scsiAdr), T_LONG},	      /* default SCSI bus adr */
   {"scsi_lun",	(char *)(&scsiLun), T_LONG},	      /* default SCSI bus adr */
+  {"scsi_time",	(char *)(&scsiTime), T_LONG|T_DECI},  /* time READ/WRITE */
+  {"scsi_intr",	(char *)(&scsiIntr), T_LONG|T_DECI},  /* SCSI interrupts */
+  {"cache_ra",	(char *)(&cacheRA), T_LONG|T_DECI},   /* SCSI read ahead */
 # endif
 };
 
 #define REGTABLESZ ((sizeof regTable) / (sizeof (struct regTable)))
 
+/* Trie of register names.  The names share prefixes, so they take about
+ * two nodes each (154 for 76 names); the pool allows two and 32 more.
+ * If a new name does not fit, find_reg() says so.
+ */
+#define REGNODES (REGTABLESZ * 2 + 32)
+struct tnode regNodes [REGNODES];
+struct trie regTrie = {regNodes, REGNODES, 0};
+
 /* Search regTable for 1) a register matching what the user typed or 2)
  * a unique register which is a superstring of what the user typed.
  */
@@ -100,21 +111,22 @@ CONST struct regTable *
 find_reg (p)
 char *p;
 {
-  CONST struct regTable *q, *substr;
-  int multisub = 0;
+  int i;
 
-  for (q = regTable; q < regTable + REGTABLESZ; ++q)
-    switch (myStrCmp (p, q->name)) {
-      case CMP_MATCH:
-        return q;
-      case CMP_SUBSTR:
-        ++multisub;
-        substr = q;
-        break;
-      case CMP_NOMATCH:
-        break;
-    }
-  return (multisub == 1)? substr: NULL;
+  if (regTrie.used == 0)
+    for (i = 0; i < REGTABLESZ; ++i)
+      if (!trieAdd (&regTrie, regTable [i].name, i)) {
+	myPrintf ("REGNODES too small at %s\n", regTable [i].name);
+	break;
+      }
+  i = trieFind (&regTrie, p);
+  return (i >= 0)? &regTable [i]: NULL;
+}
+
+print_reg (i)
+int i;
+{
+  morePrintf (0, " %s", regTable [i].name);
 }
 
 /* Scan a register.
@@ -139,7 +151,11 @@ char *p;
   scan (&p);
   scanreg (&p, regname);
   if (NULL == (r = find_reg (regname))) {
-    myPrintf ("Bad register name\n");
+    if (TRIE_AMBIG == trieFind (&regTrie, regname)) {
+      morePrintf (0, "Ambiguous register name, could be:");
+      trieList (&regTrie, regname, print_reg);
+      morePrintf (1, "\n");
+    } else myPrintf ("Bad register name\n");
     return;
   }
   if (GOT_NUM != getIntScan (&p, &val)) {
@@ -156,7 +172,7 @@ char *p;
 printreg (r)
 struct regTable *r;
 {
-  long val;
+  long val = 0;
 
 
   switch (r->type & T_LEN) {
@@ -0,0 +1,163 @@
+/* NSC 32000 ROM debugger.
+ *
+ * Command scripts.  SCRIPT runs the commands in a text buffer in RAM,
+ * one per line, as if they had been typed; READ or DOWNLOAD put a
+ * script there from a disk or the host.  Output is not paged while a script
+ * runs, and each line is echoed so the log shows what was done.  Lines
+ * which are not commands:
+ *
+ *	# <comment>
+ *	:<label>
+ *	goto <label>
+ *	if <expression> <line>		do <line> if <expression> is not 0
+ *	ifnot <expression> <line>	do <line> if <expression> is 0
+ *	stop				end the script
+ *
+ * For example, to dump ten blocks of a disk:
+ *
+ *	set v1 0
+ *	:next
+ *	read v1 100000
+ *	dump 100000 200
+ *	set v1 v1+1
+ *	if v1-d'10 goto next
+ *
+ * Typing ^C stops a script between lines.
+ */
+
+#include "debugger.h"
+
+#define MAXSCRIPT	0x100000	/* longest script without a length */
+#define SCRIPT_END(c)	((c) == '\0' || (c) == '\032')	/* NUL or ^Z */
+#define EOL(c)		((c) == '\n' || (c) == '\r')
+#define CTRL_C		'\003'
+
+#if STANDALONE
+#define BREAK_KEY()	(uart_poll (DEFAULT_UART) && getch () == CTRL_C)
+#else
+#define BREAK_KEY()	0
+#endif
+
+static char *scriptBase, *scriptEnd;
+static char scriptLine [LNLEN];		/* off the small stack */
+
+/* SCRIPT command handler.  Run the script at <address>, which is
+ * <length> bytes long or ends with NUL or ^Z.
+ */
+doScript (p)
+char *p;
+{
+  long adr, len;
+  int ret;
+  char *q;
+
+  if (batch) {
+    myPrintf ("Scripts do not nest\n");
+    return;
+  }
+  if (GOT_NUM != getIntScan (&p, &adr) ||
+  BAD_NUM == (ret = getIntScan (&p, &len))) {
+    myPrintf ("Bad address or length\n");
+    return;
+  }
+  scriptBase = (char *)adr + BASE;
+  if (ret == NO_NUM) {
+    for (q = scriptBase; q < scriptBase + MAXSCRIPT && !SCRIPT_END (*q); ++q);
+    scriptEnd = q;
+  } else scriptEnd = scriptBase + len;
+  batch = 1;
+  screenIgnore = 0;
+  runScript ();
+  batch = 0;
+}
+
+/* Run scriptBase to scriptEnd.
+ */
+runScript ()
+{
+  char *next, *p, *save, *getLine(), *findLabel();
+  long val;
+  int lineno;
+
+  for (next = scriptBase, lineno = 0; next < scriptEnd;) {
+    next = getLine (next, &lineno);
+    if (BREAK_KEY ()) {
+      myPrintf ("Script stopped at line %d\n", lineno);
+      return;
+    }
+    p = scriptLine;
+    scan (&p);
+    if (*p == '\0' || *p == '#' || *p == ':') continue;
+    myPrintf ("> %s\n", p);
+    for (;;) {				/* if and ifnot may be stacked */
+      save = p;
+      scanToken (&p, cmdWord);
+      if (CMP_MATCH == myStrCmp (cmdWord, "if") ||
+      CMP_MATCH == myStrCmp (cmdWord, "ifnot")) {
+	if (GOT_NUM != getIntScan (&p, &val)) break;
+	if ((val != 0) != (cmdWord [2] == '\0')) goto skip;
+	continue;
+      }
+      if (CMP_MATCH == myStrCmp (cmdWord, "goto")) {
+	scanToken (&p, cmdWord);
+	if (NULL == (next = findLabel (cmdWord, &lineno))) {
+	  myPrintf ("No label %s, line %d\n", cmdWord, lineno);
+	  return;
+	}
+	goto skip;
+      }
+      if (CMP_MATCH == myStrCmp (cmdWord, "stop")) return;
+      if (!exec_cmd (save)) break;
+      goto skip;
+    }
+    myPrintf ("Bad line %d\n", lineno);
+    return;
+skip:;
+  }
+}
+
+/* Copy the line at p to scriptLine, without its end of line.  Return
+ * the start of the next line and count it in *lineno.
+ */
+char *
+getLine (p, lineno)
+register char *p;
+int *lineno;
+{
+  register char *q = scriptLine;
+
+  while (p < scriptEnd && !EOL (*p)) {
+    if (q < scriptLine + LNLEN - 1) *q++ = *p;
+    ++p;
+  }
+  *q = '\0';
+  if (p < scriptEnd && *p == '\r') ++p;
+  if (p < scriptEnd && *p == '\n') ++p;
+  ++*lineno;
+  return p;
+}
+
+/* Return the line after :<name>, or NULL.  *lineno is its number.
+ * Name is in lower case, as from scanToken().
+ */
+char *
+findLabel (name, lineno)
+char *name;
+int *lineno;
+{
+  char *next, *p, *q;
+  int n;
+
+  for (next = scriptBase, n = 0; next < scriptEnd;) {
+    next = getLine (next, &n);
+    p = scriptLine;
+    scan (&p);
+    if (*p != ':') continue;
+    for (++p, q = name; *q != '\0' && tolower (*p) == *q; ++p, ++q);
+    if (*q == '\0' && (*p == '\0' || *p == ' ' || *p == '\t')) {
+      *lineno = n;
+      return next;
+    }
+  }
+  return NULL;
+}
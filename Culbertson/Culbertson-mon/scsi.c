@@ -97,11 +97,22 @@
 #define ICU_DIR		(ICU_ADR+21)
 #define ICU_DATA	(ICU_ADR+19)
 #define ICU_SCSI_BIT	0x80
+#define ICU_ELTG	(ICU_ADR+2)	/* 1 = level triggered */
+#define ICU_TPL		(ICU_ADR+4)	/* 1 = high level/rising edge */
+#define ICU_IMSK	(ICU_ADR+10)	/* 1 = masked */
+/* The pc532 wires the DP8490 to IR 5 and the AIC6250 to IR 4, as in
+ * IR_SCSI0 and IR_SCSI1 of the NetBSD/pc532 icu.h.
+ */
+#define IR_SCSI		5		/* DP8490 interrupt line */
+#define IR_SCSI_BIT	(1 << IR_SCSI)	/* in the low byte registers */
+#define VEC_BIAS	0x10		/* as set by uart_resume() */
 
 /* Miscellaneous
  */
 #define MAX_WAIT	2000000
+#define SC_BUSY		(-1)		/* from sc_poll() */
 #define SC_LOG_LEN	32
+#define BURST		16		/* bytes moved per DRQ check */
 
 struct scsi_args {
   long ptr [8];
@@ -116,7 +127,13 @@ PRIVATE char			sc_cur_phase,
 				*memDmaAdr,
 				dmaDir;
 long scsiAdr = DEFAULT_SCSI_ADR,	/* default SCSI address */
-     scsiLun = DEFAULT_SCSI_LUN;
+     scsiLun = DEFAULT_SCSI_LUN,
+     scsiTime,				/* report speed of READ/WRITE */
+     scsiIntr;				/* finish commands by interrupt */
+PRIVATE int			sc_busy,	/* submitted, not polled */
+				sc_armed,	/* interrupt will finish it */
+				sc_status;	/* of the last one polled */
+PRIVATE volatile int		sc_isr_ret;	/* set by sc_intr() */
 
 #ifdef DEBUG
 struct sc_log {
@@ -147,15 +164,23 @@ char *p;
   long parm_ptr, scsi_adr;
   int ret;
 
-  if (GOT_NUM != getIntScan (&p, &parm_ptr)) {
+  if (BAD_NUM == (ret = getIntScan (&p, &parm_ptr))) {
     myPrintf ("Bad parameter address\n");
     return;
+  } else if (ret == NO_NUM) {			/* background command */
+    if (sc_busy) myPrintf ("Waiting\n");
+    while (SC_BUSY == (ret = sc_poll ()));
+    if (ret != OK) myPrintf ("Error %d\n", ret);
+    return;
   }
   if (BAD_NUM == (ret = getIntScan (&p, &scsi_adr))) {	/* SCSI adr */
     myPrintf ("Bad SCSI address\n");
     return;
   } else if (ret == NO_NUM) scsi_adr = scsiAdr;		/* use default */
-  ret = execute_scsi_cmd ((struct scsi_args *)parm_ptr, scsi_adr);
+  cacheInval ();				/* who knows what it did */
+  ret = sc_submit ((struct scsi_args *)parm_ptr, scsi_adr);
+  if (ret == OK && scsiIntr) return;	/* RAW alone waits for it */
+  if (ret == OK) ret = sc_poll ();
   if (ret != OK) myPrintf ("Error %d\n", ret);
 }
 
@@ -184,7 +209,7 @@ scsi_generic (p, op)
 char *p;
 int op;
 {
-  long block, ram_adr, len, scsi_adr, scsi_lun;
+  long block, ram_adr, len, scsi_adr, scsi_lun, ticks, sc_blksize();
   int ret;
 
   if (GOT_NUM != getIntScan (&p, &block)) {		/* block */
@@ -210,7 +235,15 @@ int op;
   if (debug)
 	myPrintf ("blk=%ld adr=0x%lx len=%ld adr=%d lun=%d\n",
 	block, ram_adr, len, scsi_adr, scsi_lun);
-  ret = sc_rdwt (op, block, ram_adr, len, scsi_adr, scsi_lun);
+  if (scsiTime) timerStart ();
+  if (op == DISK_READ)
+    ret = cacheRead (block, (char *)ram_adr, len, scsi_adr, scsi_lun);
+  else ret = cacheWrite (block, (char *)ram_adr, len, scsi_adr, scsi_lun);
+  if (scsiTime) {
+    ticks = timerRead ();
+    timerStop ();
+    if (ret == OK) timerReport (len * sc_blksize (scsi_adr, scsi_lun), ticks);
+  }
   if (debug) myPrintf ("return = %d\n", ret);
   else if (ret != OK) myPrintf ("Error %d\n", ret);
 }
@@ -244,6 +277,44 @@ PRIVATE U8		msg_buf[1];
 #define IDATA_IX	1
 PRIVATE struct scsi_args scsi_args;
 
+/* Request queue.  Requests wait here until sc_flush(), which sorts them,
+ * joins those for consecutive blocks of the same device into one command,
+ * and issues each command with a scatter-gather list of the requests'
+ * RAM buffers.
+ */
+#define SC_QLEN		16		/* also most segments per command */
+#define MAX_XFER	0xffff		/* most blocks per READ/WRITE(10) */
+#define CMD_RDCAP	0x25
+#define RDCAP_LEN	8
+#define DEFAULT_BLKSZ	512
+
+struct sc_req {
+  int op;
+  long block, len, adr, lun;
+  char *ram;
+};
+PRIVATE struct sc_req	sc_q[SC_QLEN];
+PRIVATE int		sc_qn;
+
+struct sg {
+  char *adr;
+  long len;				/* bytes */
+};
+PRIVATE struct sg	sc_sgl[SC_QLEN],	/* as built */
+			sc_sgw[SC_QLEN],	/* being used */
+			*sc_sg, *sc_sg_end;	/* NULL unless in use */
+PRIVATE char		*dmaEnd;		/* end of segment */
+#define SC_SG_PHASE(ph)	(sc_sg != NULL && ((ph) == PH_IDATA || (ph) == PH_ODATA))
+#define SC_DEV(adr,lun)	(((adr) & 7) << 3 | ((lun) & 7))
+#define SC_NDEV		8		/* devices whose size is kept */
+PRIVATE struct sc_dev {
+  int dev;				/* SC_DEV + 1, 0 = free */
+  long blksz, last;			/* block size, last block */
+} sc_dev[SC_NDEV];
+PRIVATE int		sc_ndev;		/* next to replace */
+
+PRIVATE U8		sense_cmd[CMD_LEN];
+
 /*===========================================================================*
  *				sc_rdwt					     * 
  *===========================================================================*/
@@ -252,32 +323,202 @@ sc_rdwt(op, block, ram_adr, len, sc_adr, lun)
 long block, ram_adr, len, sc_adr, lun;
 {
 /* Carry out a read or write request for the SCSI disk. */
-  int retries;
+  if (OK != sc_queue(op, block, ram_adr, len, sc_adr, lun)) return NOT_OK;
+  return sc_flush();
+}
+
+/*===========================================================================*
+ *				sc_queue				     * 
+ *===========================================================================*/
+/* Add a request to the queue.  The queue is flushed first if it is
+ * full, if it holds requests of the other kind, or if a write overlaps
+ * an earlier one; sc_flush() may then reorder freely.  If that flush
+ * fails the new request is not queued either.
+ */
+PUBLIC int
+sc_queue(op, block, ram_adr, len, sc_adr, lun)
+long block, ram_adr, len, sc_adr, lun;
+{
+  register struct sc_req *r;
+
+  for (r = sc_q; r < sc_q + sc_qn; ++r)	/* keep order where it matters */
+    if (r->op != op || op == DISK_WRITE && r->adr == sc_adr &&
+      r->lun == lun && r->block < block + len && block < r->block + r->len)
+      break;
+  if ((r < sc_q + sc_qn || sc_qn == SC_QLEN) && OK != sc_flush())
+    return NOT_OK;
+  r = &sc_q[sc_qn++];
+  r->op = op;
+  r->block = block;
+  r->len = len;
+  r->adr = sc_adr;
+  r->lun = lun;
+  r->ram = (char *)ram_adr;
+  return OK;
+}
+
+/*===========================================================================*
+ *				sc_flush				     * 
+ *===========================================================================*/
+/* Issue the queued requests, stopping at the first which fails, and
+ * empty the queue either way.  Return OK if they all worked.
+ */
+#define SC_BEFORE(a,b)	((a)->adr != (b)->adr? (a)->adr < (b)->adr: \
+			 (a)->lun != (b)->lun? (a)->lun < (b)->lun: \
+			 (a)->block < (b)->block)
+#define SC_NEXT(a,b)	((a)->adr == (b)->adr && (a)->lun == (b)->lun && \
+			 (a)->block + (a)->len == (b)->block)
+
+PUBLIC int
+sc_flush()
+{
+  struct sc_req t, *r, *q, *end;
+  struct sg *sg;
+  long len, bsz, sc_blksize();
+  int ret = OK, i;
+
+  end = sc_q + sc_qn;
+  for (r = sc_q + 1; r < end; ++r) {	/* insertion sort */
+    t = *r;
+    for (q = r; q > sc_q && SC_BEFORE (&t, q - 1); --q) *q = q[-1];
+    *q = t;
+  }
+  for (r = sc_q; r < end && ret == OK; r = q) {
+    len = r->len;
+    for (q = r + 1; q < end && SC_NEXT (q - 1, q) && len + q->len <= MAX_XFER;
+      ++q)
+      len += q->len;
+    bsz = sc_blksize (r->adr, r->lun);	/* segment ends bound bursts */
+    for (sg = sc_sgl, i = 0; r + i < q; ++i) {
+      if (sg > sc_sgl && sg[-1].adr + sg[-1].len == r[i].ram)
+	sg[-1].len += r[i].len * bsz;	/* RAM contiguous, too */
+      else {
+	sg->adr = r[i].ram;
+	sg->len = r[i].len * bsz;
+	++sg;
+      }
+    }
+    if (OK != sc_xfer (r->op, r->block, len, sc_sgl, sg - sc_sgl,
+      r->adr, r->lun)) ret = NOT_OK;
+  }
+  sc_qn = 0;
+  return ret;
+}
+
+/*===========================================================================*
+ *				sc_find					     * 
+ *===========================================================================*/
+/* The kept size of a device, or NULL.
+ */
+PRIVATE struct sc_dev *
+sc_find(sc_adr, lun)
+long sc_adr, lun;
+{
+  register struct sc_dev *d;
+
+  for (d = sc_dev; d < sc_dev + SC_NDEV; ++d)
+    if (d->dev == SC_DEV (sc_adr, lun) + 1) return d;
+  return NULL;
+}
+
+/*===========================================================================*
+ *				sc_blksize				     * 
+ *===========================================================================*/
+/* Block size of a device, from READ CAPACITY, which is needed to divide
+ * a transfer among several buffers.  The first command after a reset
+ * usually gets CHECK CONDITION, so it is retried after a request sense,
+ * as in sc_xfer().  If the device never answers, DEFAULT_BLKSZ is
+ * returned but not kept, so it is asked again next time.
+ */
+PRIVATE long
+sc_blksize(sc_adr, lun)
+long sc_adr, lun;
+{
+  U8 cap[RDCAP_LEN], *p;
+  struct sc_dev *d;
+  int retries, i;
+
+  if (NULL != (d = sc_find (sc_adr, lun))) return d->blksz;
+  for (retries = 0; retries < MAX_SCSI_RETRIES; ++retries) {
+    for (p = sense_cmd, i = 0; i < 10; ++i) *p++ = 0;	/* get_sense() */
+    sense_cmd[0] = CMD_RDCAP;				/* uses it, too */
+    sense_cmd[1] = lun << 5;
+    scsi_args.ptr[IDATA_IX] = (long)cap;
+    scsi_args.ptr[ODATA_IX] = 0;
+    scsi_args.ptr[CMD_IX] = (long)sense_cmd;
+    scsi_args.ptr[STAT_IX] = (long)stat_buf;
+    scsi_args.ptr[IMSG_IX] = (long)msg_buf;
+    if (OK != execute_scsi_cmd (&scsi_args, sc_adr)) continue;
+    if (*stat_buf == 0) {
+      d = &sc_dev[sc_ndev++ % SC_NDEV];
+      d->dev = SC_DEV (sc_adr, lun) + 1;
+      d->blksz = cap[4]<<24 | cap[5]<<16 | cap[6]<<8 | cap[7];
+      d->last = cap[0]<<24 | cap[1]<<16 | cap[2]<<8 | cap[3];
+      return d->blksz;
+    }
+    if (*stat_buf == CHECK_CONDITION) (void) get_sense (sc_adr, lun);
+  }
+  return DEFAULT_BLKSZ;
+}
+
+/*===========================================================================*
+ *				sc_lastblk				     * 
+ *===========================================================================*/
+/* Last block of a device, also from READ CAPACITY.
+ */
+PUBLIC long
+sc_lastblk(sc_adr, lun)
+long sc_adr, lun;
+{
+  struct sc_dev *d;
+
+  (void) sc_blksize(sc_adr, lun);
+  if (NULL == (d = sc_find (sc_adr, lun))) return 0x7fffffff;	/* unknown */
+  return d->last;
+}
+
+/*===========================================================================*
+ *				sc_xfer					     * 
+ *===========================================================================*/
+/* One READ(10) or WRITE(10) of len blocks.  The data goes to or from the
+ * nsg segments of sgl, or to sgl->adr if nsg is 0.  The command is built
+ * once; a retry only resets the pointers.
+ */
+PRIVATE int
+sc_xfer(op, block, len, sgl, nsg, sc_adr, lun)
+long block, len, sc_adr, lun;
+struct sg *sgl;
+int nsg;
+{
+  int retries, i;
   U8 *p;
 
+  p = cmd_buf;			/* build SCSI command */
+  *p++ = (op == DISK_READ)? CMD_READ: CMD_WRITE;
+  *p++ = lun << 5;
+  *p++ = (block >> 24) & 0xff;
+  *p++ = (block >> 16) & 0xff;
+  *p++ = (block >> 8) & 0xff;
+  *p++ = (block >> 0) & 0xff;
+  *p++ = 0;
+  *p++ = (len >> 8) & 0xff;
+  *p++ = (len >> 0) & 0xff;
+  *p = 0;
+  if (op == DISK_READ) icache_flush();
   for (retries = 0; retries < MAX_SCSI_RETRIES; ++retries) {
-    p = cmd_buf;		/* build SCSI command */
-    *p++ = (op == DISK_READ)? CMD_READ: CMD_WRITE;
-    *p++ = lun << 5;
-    *p++ = (block >> 24) & 0xff;
-    *p++ = (block >> 16) & 0xff;
-    *p++ = (block >> 8) & 0xff;
-    *p++ = (block >> 0) & 0xff;
-    *p++ = 0;
-    *p++ = (len >> 8) & 0xff;
-    *p++ = (len >> 0) & 0xff;
-    *p = 0;
     scsi_args.ptr[CMD_IX] = (long)cmd_buf;
     scsi_args.ptr[STAT_IX] = (long)stat_buf;
     scsi_args.ptr[IMSG_IX] = (long)msg_buf;
-    if (op == DISK_READ) {
-      scsi_args.ptr[IDATA_IX] = ram_adr;
-      scsi_args.ptr[ODATA_IX] = 0;
-    } else {
-      scsi_args.ptr[ODATA_IX] = ram_adr;
-      scsi_args.ptr[IDATA_IX] = 0;
+    scsi_args.ptr[IDATA_IX] = scsi_args.ptr[ODATA_IX] = 0;
+    scsi_args.ptr[op == DISK_READ? IDATA_IX: ODATA_IX] = (long)sgl->adr;
+    if (nsg > 0) {		/* segments are used up as they go */
+      for (i = 0; i < nsg; ++i) sc_sgw[i] = sgl[i];
+      sc_sg = sc_sgw;
+      sc_sg_end = sc_sgw + nsg;
     }
-    if (OK != execute_scsi_cmd (&scsi_args, sc_adr))
+    i = execute_scsi_cmd (&scsi_args, sc_adr);
+    sc_sg = sc_sg_end = NULL;
+    if (OK != i)
       continue;
     if (*stat_buf == 0)
       /* Success -- this should be the usual case */
@@ -323,8 +564,8 @@ long lun;
 {
   U8 *p;
 
-  p = cmd_buf;				/* build SCSI command */
-  *p++ = CMD_SENSE;
+  p = sense_cmd;			/* build SCSI command; cmd_buf */
+  *p++ = CMD_SENSE;			/* is kept for the retry */
   *p++ = lun << 5;
   *p++ = 0;
   *p++ = 0;
@@ -332,7 +573,7 @@ long lun;
   *p = 0;
   scsi_args.ptr[IDATA_IX] = (long)sense_buf;
   scsi_args.ptr[ODATA_IX] = 0;
-  scsi_args.ptr[CMD_IX] = (long)cmd_buf;
+  scsi_args.ptr[CMD_IX] = (long)sense_cmd;
   scsi_args.ptr[STAT_IX] = (long)stat_buf;
   scsi_args.ptr[IMSG_IX] = (long)msg_buf;
   if (OK != execute_scsi_cmd (&scsi_args, scsi_adr)) {
@@ -376,6 +617,32 @@ long scsi_adr;
 {
   int ret;
 
+  if (OK != (ret = sc_submit (args, scsi_adr))) return ret;
+  while (SC_BUSY == (ret = sc_poll ()));
+  return ret;
+}
+
+/*===========================================================================*
+ *				sc_submit				     *
+ *===========================================================================*/
+/* Start a command, after waiting for the last one to finish.  Then
+ * sc_poll() says when it is done.  With scsiIntr set, sc_submit() sends
+ * the command bytes and returns; the 8490 interrupts when the target
+ * goes on to the next phase, and sc_intr() does the rest.  Only the
+ * time from selection to that phase change, while the drive seeks, is
+ * free for the monitor; the data, status and message phases are all
+ * run inside the interrupt.  Commands of unknown length are run without
+ * interrupts.
+ */
+PUBLIC
+int
+sc_submit (args, scsi_adr)
+struct scsi_args *args;
+long scsi_adr;
+{
+  int len;
+
+  while (sc_busy) (void) sc_poll ();
   sc_ptrs = args;			/* make pointers globally accessible */
   scCtlrSelect (DP8490);
   if (!sc_reset_done) sc_reset();
@@ -392,15 +659,120 @@ long scsi_adr;
   if (OK != sc_select (scsi_adr))	/* select phase */
     return NOT_OK;
   sc_watchdog_error = 0;
-  ret = sc_receive ();			/* isr does the rest */
-  if (ret == ISR_OK) return OK;
-  else {
-    sc_reset();
-    myPrintf ("SCSI: %s\n", scsi_errors[ret]);
-    return NOT_OK;
+  sc_busy = 1;
+  len = sc_cdb_len (*(U8 *)sc_ptrs->ptr[PH_CMD]);
+  if (scsiIntr && len > 0) {
+    sc_send_cmd ((char *)sc_ptrs->ptr[PH_CMD] + len);
+    sc_isr_ret = ISR_NOTDONE;
+    sc_armed = 1;
+    RD_ADR (ICU_ELTG) |= IR_SCSI_BIT;	/* 8490 INT is active high */
+    RD_ADR (ICU_TPL) |= IR_SCSI_BIT;
+    RD_ADR (ICU_IMSK) &= ~IR_SCSI_BIT;
+  }
+  return OK;
+}
+
+/*===========================================================================*
+ *				sc_poll					     *
+ *===========================================================================*/
+/* Return SC_BUSY while the submitted command runs, then OK or NOT_OK.
+ * Without interrupts the command is run to the end here.  Once nothing
+ * is running, the result of the last command is returned again.
+ */
+PUBLIC
+int
+sc_poll ()
+{
+  int ret;
+
+  if (!sc_busy) return sc_status;
+  if (sc_armed) {
+    if (ISR_NOTDONE == (ret = sc_isr_ret)) return SC_BUSY;
+    sc_armed = 0;
+  } else ret = sc_receive ();		/* isr does the rest */
+  sc_busy = 0;
+  if (ret == ISR_OK) return sc_status = OK;
+  sc_reset();
+  myPrintf ("SCSI: %s\n", scsi_errors[ret]);
+  return sc_status = NOT_OK;
+}
+
+/*===========================================================================*
+ *				sc_cdb_len				     *
+ *===========================================================================*/
+/* Length of a command from its group code, or 0 if vendor unique.
+ */
+PRIVATE int
+sc_cdb_len (op)
+int op;
+{
+  switch ((op >> 5) & 7) {
+    case 0:	return 6;
+    case 1:
+    case 2:	return 10;
+    case 4:	return 16;
+    case 5:	return 12;
+    default:	return 0;
+  }
+}
+
+/*===========================================================================*
+ *				sc_send_cmd				     *
+ *===========================================================================*/
+/* Send command bytes up to end, unless the target changes phase first.
+ */
+PRIVATE
+sc_send_cmd (end)
+char *end;
+{
+  int stat2;
+
+  while (memDmaAdr < end) {
+    stat2 = RD_ADR (SC_STAT2);
+    if (stat2 & SC_S_IRQ) break;	/* for sc_intr() */
+    if (stat2 & SC_S_DRQ) WR_ADR (scsiDmaAdr++, *memDmaAdr++);
   }
 }
 
+/*===========================================================================*
+ *				sc_intr					     *
+ *===========================================================================*/
+/* Interrupt routine, called from _isr_scsi in dblib.s.  The pc532 has
+ * no DMA controller, so the 8490 never interrupts for DRQ or EOP, only
+ * for a phase change, and the CPU has to move every byte.  So the first
+ * interrupt, when the target leaves the command phase, runs the data,
+ * status and message phases to the end here, as sc_receive() does when
+ * polled.  The SCSI line stays masked from now on, and other interrupts
+ * are let in, so typing is not lost meanwhile.
+ */
+PUBLIC
+sc_intr ()
+{
+  RD_ADR (ICU_IMSK) |= IR_SCSI_BIT;
+  if (!sc_armed || sc_isr_ret != ISR_NOTDONE) return;
+  db_intr_on ();
+  sc_isr_ret = sc_receive ();
+  db_intr_off ();
+}
+
+/* Dispatch table entry for sc_intr()
+ */
+PUBLIC
+int
+scsi_vector ()
+{
+  return VEC_BIAS + IR_SCSI;
+}
+
+/* The user program is about to run, so the monitor's interrupts are
+ * about to go.  Finish any command still running.
+ */
+PUBLIC
+scsi_suspend ()
+{
+  while (sc_busy && sc_armed) (void) sc_poll ();
+}
+
 /*===========================================================================*
  *				sc_reset				     * 
  *===========================================================================*/
@@ -541,6 +913,10 @@ scsi_interrupt()
         new_ptr != sc_ptrs->ptr[PH_IMSG]) sc_have_msg = 1;
       sc_ptrs->ptr[sc_cur_phase] =	/* save pointer */
         new_ptr;
+      if (SC_SG_PHASE (sc_cur_phase) && dmaEnd != NULL) {	/* and rest */
+	sc_sg->len = dmaEnd - memDmaAdr;
+	sc_sg->adr = memDmaAdr;
+      }
     }
     if (sc_watchdog_error) ret = ISR_TIMEOUT;
     else if (stat2 & SC_S_BSYERR) {	/* target deasserted BSY? */
@@ -550,6 +926,8 @@ scsi_interrupt()
       sc_cur_phase = 			/* get new phase from controller */
         (RD_ADR (SC_STAT1) >> 2) & 7;
       new_ptr = sc_ptrs->ptr[sc_cur_phase];
+      if (SC_SG_PHASE (sc_cur_phase))
+	new_ptr = (sc_sg < sc_sg_end)? (long)sc_sg->adr: 0;
       if (new_ptr == 0) ret = ISR_BADPHASE;
       else {
         WR_ADR (SC_TCMD, sc_cur_phase);	/* write new phase into TCMD */
@@ -598,6 +976,25 @@ char *adr;
     scsiDmaAdr = (char *)SC_DMA;
   dmaDir = dir;
   memDmaAdr = adr;
+  dmaEnd = (SC_SG_PHASE (sc_cur_phase))? adr + sc_sg->len: NULL;
+}
+
+/*===========================================================================*
+ *				sc_sg_next				     *
+ *===========================================================================*/
+/* The DMA pointer has reached the end of a segment; move to the next.
+ */
+sc_sg_next ()
+{
+  sc_sg->adr = dmaEnd;
+  sc_sg->len = 0;
+  if (++sc_sg < sc_sg_end) {
+    memDmaAdr = sc_sg->adr;
+    dmaEnd = memDmaAdr + sc_sg->len;
+  } else {
+    --sc_sg;			/* overrun goes on past the last one */
+    dmaEnd = NULL;
+  }
 }
 
 /*===========================================================================*
@@ -616,14 +1013,81 @@ sc_receive()
     if (stat2 & SC_S_IRQ) {
       if (ISR_NOTDONE != (isr_ret = scsi_interrupt())) break;
     } else if (stat2 & SC_S_DRQ) {
+      if (dmaEnd != NULL && dmaEnd - memDmaAdr >= BURST) {
+	if (dmaDir == DISK_READ) sc_burst_in ();
+	else sc_burst_out ();
+	continue;
+      }
       /* increment scsi address to fool cache */
       if (dmaDir == DISK_READ) *memDmaAdr++ = RD_ADR (scsiDmaAdr++);
       else WR_ADR (scsiDmaAdr++, *memDmaAdr++);
+      if (memDmaAdr == dmaEnd) sc_sg_next ();
     }
   }
   return isr_ret;
 }
 
+/*===========================================================================*
+ *				sc_burst_in				     *
+ *===========================================================================*/
+/* Data phase of READ.  The pc532 holds off each access to the DMA
+ * register until the 8490 has the byte, so once DRQ is up a whole
+ * burst can be moved without looking at it again.  The target sends
+ * whole blocks, which is why only segments of READ and WRITE commands
+ * get here, and only while BURST or more bytes are left in one.  Each
+ * byte still comes from the next SCSI address to fool the cache.
+ */
+PRIVATE
+sc_burst_in ()
+{
+  register char *m = memDmaAdr, *s = scsiDmaAdr;
+
+  do {
+    m[0] = RD_ADR (s+0);   m[1] = RD_ADR (s+1);
+    m[2] = RD_ADR (s+2);   m[3] = RD_ADR (s+3);
+    m[4] = RD_ADR (s+4);   m[5] = RD_ADR (s+5);
+    m[6] = RD_ADR (s+6);   m[7] = RD_ADR (s+7);
+    m[8] = RD_ADR (s+8);   m[9] = RD_ADR (s+9);
+    m[10] = RD_ADR (s+10); m[11] = RD_ADR (s+11);
+    m[12] = RD_ADR (s+12); m[13] = RD_ADR (s+13);
+    m[14] = RD_ADR (s+14); m[15] = RD_ADR (s+15);
+    m += BURST;
+    s += BURST;
+  } while (dmaEnd - m >= BURST &&
+    (RD_ADR (SC_STAT2) & (SC_S_DRQ | SC_S_IRQ)) == SC_S_DRQ);
+  memDmaAdr = m;
+  scsiDmaAdr = s;
+  if (memDmaAdr == dmaEnd) sc_sg_next ();
+}
+
+/*===========================================================================*
+ *				sc_burst_out				     *
+ *===========================================================================*/
+/* Data phase of WRITE, as sc_burst_in().
+ */
+PRIVATE
+sc_burst_out ()
+{
+  register char *m = memDmaAdr, *s = scsiDmaAdr;
+
+  do {
+    WR_ADR (s+0, m[0]);   WR_ADR (s+1, m[1]);
+    WR_ADR (s+2, m[2]);   WR_ADR (s+3, m[3]);
+    WR_ADR (s+4, m[4]);   WR_ADR (s+5, m[5]);
+    WR_ADR (s+6, m[6]);   WR_ADR (s+7, m[7]);
+    WR_ADR (s+8, m[8]);   WR_ADR (s+9, m[9]);
+    WR_ADR (s+10, m[10]); WR_ADR (s+11, m[11]);
+    WR_ADR (s+12, m[12]); WR_ADR (s+13, m[13]);
+    WR_ADR (s+14, m[14]); WR_ADR (s+15, m[15]);
+    m += BURST;
+    s += BURST;
+  } while (dmaEnd - m >= BURST &&
+    (RD_ADR (SC_STAT2) & (SC_S_DRQ | SC_S_IRQ)) == SC_S_DRQ);
+  memDmaAdr = m;
+  scsiDmaAdr = s;
+  if (memDmaAdr == dmaEnd) sc_sg_next ();
+}
+
 /*===========================================================================*
  *				scCtlrSelect
  *===========================================================================*/
@@ -0,0 +1,109 @@
+/* NSC 32000 ROM debugger.
+ *
+ * Symbols from an a.out image in RAM, for use in expressions.  The
+ * image must stay where it is.  A hash index of its symbol table is
+ * built in the RAM just past the image's string table, sized from the
+ * symbol count, so the monitor's own bss does not grow.  The format is the one the 32k gcc tools write: a 32 byte
+ * header, text at 1024 in ZMAGIC files, 12 byte nlist entries, and a
+ * string table which starts with its own length.
+ */
+
+#include "debugger.h"
+
+#define OMAGIC		0407
+#define NMAGIC		0410
+#define ZMAGIC		0413
+#define ZTXTOFF		1024		/* ZMAGIC text offset */
+#define N_STAB		0xe0		/* debugger entries, not symbols */
+
+#define MINHASH		16		/* power of 2 */
+
+struct ahdr {
+  unsigned long a_info, a_text, a_data, a_bss, a_syms, a_entry,
+    a_trsize, a_drsize;
+};
+
+struct asym {
+  long n_strx;
+  unsigned char n_type;
+  char n_other;
+  short n_desc;
+  unsigned long n_value;
+};
+
+static struct asym *symTab;		/* in the image */
+static char *strTab;
+static long nsym;
+static long symMask;			/* hash size - 1 */
+static long *symHash;			/* first entry + 1, or 0 */
+static long *symNext;			/* next entry + 1, or 0 */
+
+#define SYMNAME(i)	(strTab + symTab [i].n_strx)
+
+/* SYMBOLS command handler.  Index the symbols of the a.out image at
+ * the given address, or forget them.
+ */
+symbols (p)
+char *p;
+{
+  struct ahdr *h;
+  long adr, i, off, h_i;
+  int n, magic;
+
+  switch (getIntScan (&p, &adr)) {
+    case NO_NUM:
+      nsym = 0;
+      return;
+    case BAD_NUM:
+      myPrintf ("Bad address\n");
+      return;
+  }
+  h = (struct ahdr *)(adr + BASE);
+  magic = h->a_info & 0xffff;
+  if (magic != OMAGIC && magic != NMAGIC && magic != ZMAGIC) {
+    myPrintf ("Not an a.out image\n");
+    return;
+  }
+  off = (magic == ZMAGIC)? ZTXTOFF: sizeof (struct ahdr);
+  off += h->a_text + h->a_data + h->a_trsize + h->a_drsize;
+  symTab = (struct asym *)((char *)h + off);
+  strTab = (char *)symTab + h->a_syms;
+  nsym = h->a_syms / sizeof (struct asym);
+  for (symMask = MINHASH; symMask < nsym / 2; symMask *= 2);
+  symHash = (long *)(((long)strTab + *(long *)strTab + 3) & ~3);
+  symNext = symHash + symMask--;
+  for (i = 0; i <= symMask; ++i) symHash [i] = 0;
+  for (i = 0, n = 0; i < nsym; ++i) {
+    if (symTab [i].n_type & N_STAB) continue;
+    h_i = strHash (SYMNAME (i)) & symMask;
+    symNext [i] = symHash [h_i];
+    symHash [h_i] = i + 1;
+    ++n;
+  }
+  myPrintf ("%d symbols, index at 0x%lx to 0x%lx\n", n,
+    (long)symHash - BASE, (long)(symNext + nsym) - BASE);
+}
+
+/* Find the value of a symbol.  C names may be given without their
+ * leading underscore.  Return 0 if there is no such symbol.
+ */
+int
+symLookup (name, val)
+char *name;
+long *val;
+{
+  char uname [80];
+  long i;
+
+  if (nsym == 0) return 0;
+  for (i = symHash [strHash (name) & symMask]; i != 0;
+    i = symNext [i - 1])
+    if (CMP_MATCH == myStrCmp (name, SYMNAME (i - 1))) {
+      *val = symTab [i - 1].n_value;
+      return 1;
+    }
+  if (name [0] == '_' || strlen (name) > sizeof uname - 2) return 0;
+  uname [0] = '_';
+  strcpy (uname + 1, name);
+  return symLookup (uname, val);
+}
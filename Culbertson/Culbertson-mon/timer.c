@@ -0,0 +1,101 @@
+/* NSC 32000 ROM debugger.
+ *
+ * Interval timer for timing monitor commands.  The two 16 bit ICU
+ * counters are concatenated into one 32 bit down counter which runs
+ * while a command is being timed.  CFNPS is left clear, so the counter
+ * clock is the ICU's 3.6864 MHz divided by 4, TIMER_HZ.  The user
+ * program's counter setup is put back afterwards, although the count
+ * it had is lost.
+ */
+
+#include "debugger.h"
+
+#define WR_ADR(adr,val)	(*((volatile unsigned char *)(adr))=(val))
+#define RD_ADR(adr)	(*((volatile unsigned char *)(adr)))
+
+/* NS32202 counter registers
+ */
+#define ICU_ADR		0xfffffe00
+#define ICU_CCTL	22
+#define ICU_LCSV	24		/* start values, low byte first */
+#define ICU_HCSV	26
+#define ICU_LCCV	28		/* current values */
+#define ICU_HCCV	30
+#define ICU_REG(r)	(ICU_ADR + (r))
+#define CCTL_CRUNL	0x04
+#define CCTL_CRUNH	0x08
+#define CCTL_CFNPS	0x40		/* no prescaler, left clear */
+#define CCTL_CCON	0x80		/* one 32 bit counter */
+
+unsigned char timer_cctl, timer_csv [4];	/* user program's */
+
+/* Read a 16 bit counter register.
+ */
+static unsigned long
+rdCount (r)
+int r;
+{
+  return RD_ADR (ICU_REG (r)) | RD_ADR (ICU_REG (r + 1)) << 8;
+}
+
+static
+wrCount (r, v)
+int r;
+unsigned long v;
+{
+  WR_ADR (ICU_REG (r), v);
+  WR_ADR (ICU_REG (r + 1), v >> 8);
+}
+
+/* Start counting from zero.
+ */
+timerStart ()
+{
+  int i;
+
+  timer_cctl = RD_ADR (ICU_REG (ICU_CCTL));
+  for (i = 0; i < 4; ++i) timer_csv [i] = RD_ADR (ICU_REG (ICU_LCSV + i));
+  WR_ADR (ICU_REG (ICU_CCTL), 0);
+  wrCount (ICU_LCSV, 0xffffL);
+  wrCount (ICU_HCSV, 0xffffL);
+  WR_ADR (ICU_REG (ICU_CCTL), CCTL_CCON | CCTL_CRUNL);
+}
+
+/* Ticks since timerStart().  The high half is read again in case the
+ * low half wrapped while it was being read.
+ */
+unsigned long
+timerRead ()
+{
+  unsigned long hi, lo;
+
+  do {
+    hi = rdCount (ICU_HCCV);
+    lo = rdCount (ICU_LCCV);
+  } while (hi != rdCount (ICU_HCCV));
+  return ~(hi << 16 | lo);
+}
+
+/* Stop counting and give the counters back to the user program.
+ */
+timerStop ()
+{
+  int i;
+
+  WR_ADR (ICU_REG (ICU_CCTL), 0);
+  for (i = 0; i < 4; ++i) WR_ADR (ICU_REG (ICU_LCSV + i), timer_csv [i]);
+  WR_ADR (ICU_REG (ICU_CCTL), timer_cctl);
+}
+
+/* Print how long it took to move cnt bytes.
+ */
+timerReport (cnt, ticks)
+unsigned long cnt, ticks;
+{
+  unsigned long ms;
+
+  ms = ticks / (TIMER_HZ / 1000);
+  myPrintf ("%ld bytes in %ld ms", cnt, ms);
+  if (ms > 0) myPrintf (", %ld KB/sec", cnt / ms * 125 / 128);
+  myPrintf ("\n");
+}
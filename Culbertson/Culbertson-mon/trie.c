@@ -0,0 +1,130 @@
+/* NSC 32000 ROM debugger.
+ *
+ * Prefix trie for the command and register tables.  Names are added
+ * once, the first time a table is searched.  A search then costs one
+ * step per character typed, and telling a unique abbreviation from an
+ * ambiguous one looks only at the names it abbreviates, and then only
+ * as far as the second.
+ */
+
+#include "debugger.h"
+
+int trieList1 (), trieOne ();
+
+/* Add the name of table entry idx.  Return 0 if out of nodes, or idx
+ * does not fit a node.
+ */
+int
+trieAdd (t, name, idx)
+register struct trie *t;
+char *name;
+int idx;
+{
+  register struct tnode *n;
+  unsigned char *link;
+  int i;
+
+  if (idx >= 254) return 0;
+  if (t->used == 0) {
+    n = t->node;
+    n->c = '\0';
+    n->kid = n->sib = n->last = 0;
+    t->used = 1;
+  }
+  n = t->node;
+  for (; *name != '\0'; ++name) {
+    link = &n->kid;			/* new prefixes go last, so that */
+    for (i = *link; i != 0 && t->node [i].c != *name; i = *link)
+      link = &t->node [i].sib;		/* trieList() keeps table order */
+    if (i == 0) {
+      if (t->used == t->size || t->used == 256) return 0;
+      i = t->used++;
+      t->node [i].c = *name;
+      t->node [i].kid = t->node [i].sib = t->node [i].last = 0;
+      *link = i;
+    }
+    n = &t->node [i];
+  }
+  if (n->last == 0) n->last = idx + 1;	/* first of equal names wins */
+  return 1;
+}
+
+/* Return the node for prefix p, or NULL.
+ */
+struct tnode *
+trieWalk (t, p)
+register struct trie *t;
+register char *p;
+{
+  register int i;
+
+  if (t->used == 0) return NULL;
+  for (i = 0; *p != '\0'; ++p)
+    for (i = t->node [i].kid; ; i = t->node [i].sib) {
+      if (i == 0) return NULL;
+      if (t->node [i].c == *p) break;
+    }
+  return &t->node [i];
+}
+
+/* Find the entry named p, or else the only entry p abbreviates.
+ * Return its index, TRIE_NONE or TRIE_AMBIG.
+ */
+int
+trieFind (t, p)
+struct trie *t;
+char *p;
+{
+  struct tnode *n;
+  int i;
+
+  if (NULL == (n = trieWalk (t, p))) return TRIE_NONE;
+  if (n->last) return n->last - 1;
+  i = trieOne (t, n, 0);
+  return (i > 0)? i - 1: (i == 0)? TRIE_NONE: TRIE_AMBIG;
+}
+
+/* Look for entries named by n and the prefixes under it, found being
+ * entry + 1 of the one seen so far, or 0.  Return the only entry + 1,
+ * 0 if none, or -1 as soon as there are two.
+ */
+int
+trieOne (t, n, found)
+struct trie *t;
+struct tnode *n;
+int found;
+{
+  int i;
+
+  if (n->last) {
+    if (found) return -1;
+    found = n->last;
+  }
+  for (i = n->kid; i != 0 && found >= 0; i = t->node [i].sib)
+    found = trieOne (t, &t->node [i], found);
+  return found;
+}
+
+/* Call fn with the index of each entry p abbreviates.
+ */
+trieList (t, p, fn)
+struct trie *t;
+char *p;
+int (*fn)();
+{
+  struct tnode *n;
+
+  if (NULL != (n = trieWalk (t, p))) trieList1 (t, n, fn);
+}
+
+trieList1 (t, n, fn)
+struct trie *t;
+struct tnode *n;
+int (*fn)();
+{
+  int i;
+
+  if (n->last) (*fn) (n->last - 1);
+  for (i = n->kid; i != 0; i = t->node [i].sib)
+    trieList1 (t, &t->node [i], fn);
+}
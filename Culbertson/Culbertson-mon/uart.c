@@ -0,0 +1,343 @@
+/* NSC 32000 ROM debugger.
+ *
+ * Interrupt driven, ring buffered UART i/o.
+ *
+ * While the monitor has control, each open UART is serviced by the DUART
+ * interrupt: received characters go into a ring, and characters to send
+ * are taken from another.  Only NRING UARTs get rings, the first ones
+ * opened, the console among them; the rest stay polled.  The raw polled
+ * routines in dblib.s are used for those, for UARTs which have not been
+ * opened, and while the user program runs.  Before the user program is resumed the transmit rings are
+ * drained, the DUART interrupts are turned off, and the ICU registers the
+ * monitor changed are put back the way the user program left them, so
+ * monitor interrupts never land in the user's interrupt table.
+ *
+ * With flow control on, RTS is dropped when a receive ring fills past
+ * RX_HIWAT and raised again when it drains below RX_LOWAT.  CTS is left
+ * to the DUART, which holds the transmitter while CTS is negated.
+ *
+ * The two UARTs of a DUART share its ACR, which picks one of two baud
+ * rate sets.  38400 is only in set 1, and 75, 150, 1800, 2000 and 19200
+ * only in set 2; in the other set their codes give 50, 200, 7200, 1050
+ * and 38400.  The set is kept for each DUART, other rates leave it alone,
+ * and a rate which would change the rate set on the sibling is refused.
+ */
+
+#include "debugger.h"
+
+#define WR_ADR(adr,val)	(*((volatile unsigned char *)(adr))=(val))
+#define RD_ADR(adr)	(*((volatile unsigned char *)(adr)))
+
+#define NUART		8
+#define NDUART		(NUART / 2)
+
+/* SCN2681 registers.  Uart n is at DUART_ADR + 8*n, so its duart is at
+ * DUART_ADR + 16*(n/2).
+ */
+#define DUART_ADR	0x28000000
+#define U_MR		0		/* MR1/MR2 */
+#define U_SR		1
+#define U_CR		2
+#define U_DATA		3		/* RHR/THR */
+#define D_ACR		4		/* write only */
+#define D_IMR		5		/* write only */
+#define D_ISR		5
+#define D_SOPR		14		/* set output port bits */
+#define D_ROPR		15		/* reset output port bits */
+#define UART_REG(u,r)	(DUART_ADR + 8 * (u) + (r))
+#define DUART_REG(d,r)	(DUART_ADR + 16 * (d) + (r))
+
+#define SR_RXRDY	0x01
+#define SR_TXRDY	0x04
+#define SR_TXEMT	0x08
+#define CR_MRRESET	0x10		/* point at MR1 */
+#define MR1_8N		0x13		/* as set by db_setbaud */
+#define MR2_1STOP	0x07
+#define MR2_CTS		0x10		/* CTS enables transmitter */
+#define ISR_TXRDY(u)	(0x01 << 4 * ((u) & 1))
+#define ISR_RXRDY(u)	(0x02 << 4 * ((u) & 1))
+#define RTS_BIT(u)	(1 << ((u) & 1))	/* OP0 is RTSA, OP1 RTSB */
+#define ACR_SET1	0x00		/* baud rate set select */
+#define ACR_SET2	0x80
+
+/* NS32202 registers.  DUART d interrupts on line IR_DUART(d), which
+ * the ICU turns into vector VEC_BIAS + IR_DUART(d).
+ */
+#define ICU_ADR		0xfffffe00
+#define ICU_SVCT	1
+#define ICU_ELTG	2		/* 1 = level triggered */
+#define ICU_TPL		4		/* 0 = low level/falling edge */
+#define ICU_IMSK	10		/* 1 = masked */
+#define ICU_REG(r)	(ICU_ADR + (r))
+#define IR_DUART(d)	(13 - 2 * (d))
+#define VEC_BIAS	0x10
+
+#define NRING		2		/* UARTs with rings */
+#define RXSZ		128		/* power of 2, at most 256 */
+#define TXSZ		64
+#define RX_HIWAT	(RXSZ - 32)
+#define RX_LOWAT	(RXSZ / 4)
+#define RX_CNT(r)	((unsigned char)((r)->rx_head - (r)->rx_tail))
+#define TX_CNT(r)	((unsigned char)((r)->tx_head - (r)->tx_tail))
+
+/* The interrupt routine advances rx_head and tx_tail; everyone else
+ * advances rx_tail and tx_head.
+ */
+struct ring {
+  volatile unsigned char rx_head, rx_tail, tx_head, tx_tail;
+  char on;				/* has rings, set by setbaud() */
+  int rate;				/* as set by setbaud(), or 0 */
+  char flow;				/* RTS/CTS flow control */
+  volatile char stopped;		/* RTS dropped */
+  long overruns;			/* characters lost, ring full */
+  unsigned char *rx, *tx;		/* RXSZ and TXSZ, or NULL */
+};
+
+struct ring ring [NUART];
+unsigned char rxbuf [NRING][RXSZ], txbuf [NRING][TXSZ];
+int nring;				/* rings given out */
+unsigned char imr [NDUART];		/* copy of write only IMR */
+char set1 [NDUART];			/* ACR selects rate set 1 */
+int uart_running;			/* monitor interrupts in use */
+
+/* ICU registers as the user program left them
+ */
+unsigned char user_svct, user_eltg [2], user_tpl [2], user_imsk [2];
+
+/* Dispatch table entry for the interrupts of duart d
+ */
+int
+duart_vector (d)
+int d;
+{
+  return VEC_BIAS + IR_DUART (d);
+}
+
+/* Interrupt routine for DUART d, called from _isr_duart<d> in dblib.s.
+ * A UART which was not opened is left alone: its input stays in the
+ * DUART for db_fgetc().
+ */
+duart_intr (d)
+int d;
+{
+  register struct ring *r;
+  int u, isr;
+
+  while (0 != (isr = RD_ADR (DUART_REG (d, D_ISR)) & imr [d])) {
+    for (u = 2 * d, r = &ring [u]; u < 2 * d + 2; ++u, ++r) {
+      if (!r->on || !(isr & (ISR_RXRDY (u) | ISR_TXRDY (u)))) continue;
+      while (RD_ADR (UART_REG (u, U_SR)) & SR_RXRDY) {
+	if (RX_CNT (r) < RXSZ) {
+	  r->rx [r->rx_head & (RXSZ - 1)] = RD_ADR (UART_REG (u, U_DATA));
+	  ++r->rx_head;
+	} else {
+	  (void) RD_ADR (UART_REG (u, U_DATA));
+	  ++r->overruns;
+	}
+      }
+      if (r->flow && !r->stopped && RX_CNT (r) >= RX_HIWAT) {
+	WR_ADR (DUART_REG (d, D_ROPR), RTS_BIT (u));
+	r->stopped = 1;
+      }
+      if (!(isr & ISR_TXRDY (u))) continue;
+      while (r->tx_head != r->tx_tail &&
+	(RD_ADR (UART_REG (u, U_SR)) & SR_TXRDY))
+      {
+	WR_ADR (UART_REG (u, U_DATA), r->tx [r->tx_tail & (TXSZ - 1)]);
+	++r->tx_tail;
+      }
+      if (r->tx_head == r->tx_tail) {
+	imr [d] &= ~ISR_TXRDY (u);
+	WR_ADR (DUART_REG (d, D_IMR), imr [d]);
+      }
+    }
+  }
+}
+
+/* Get a character from uart u.
+ */
+int
+uart_getc (u)
+int u;
+{
+  register struct ring *r = &ring [u];
+  int c;
+
+  if (!uart_running || !r->on) return db_fgetc (u);
+  while (r->rx_head == r->rx_tail);
+  c = r->rx [r->rx_tail & (RXSZ - 1)];
+  ++r->rx_tail;
+  if (r->stopped && RX_CNT (r) <= RX_LOWAT) {
+    db_intr_off ();
+    r->stopped = 0;
+    WR_ADR (DUART_REG (u / 2, D_SOPR), RTS_BIT (u));
+    db_intr_on ();
+  }
+  return c;
+}
+
+/* Return nonzero if a character from uart u is waiting.
+ */
+int
+uart_poll (u)
+int u;
+{
+  register struct ring *r = &ring [u];
+
+  if (!uart_running || !r->on)
+    return RD_ADR (UART_REG (u, U_SR)) & SR_RXRDY;
+  return r->rx_head != r->rx_tail;
+}
+
+/* Send character c to uart u.
+ */
+uart_putc (c, u)
+int c, u;
+{
+  register struct ring *r = &ring [u];
+
+  if (!uart_running || !r->on) {
+    db_fputc (c, u);
+    return;
+  }
+  while (TX_CNT (r) == TXSZ);
+  r->tx [r->tx_head & (TXSZ - 1)] = c;
+  ++r->tx_head;
+  db_intr_off ();
+  imr [u / 2] |= ISR_TXRDY (u);
+  WR_ADR (DUART_REG (u / 2, D_IMR), imr [u / 2]);
+  db_intr_on ();
+}
+
+/* Wait until everything queued for uart u has left the DUART.
+ */
+uart_drain (u)
+int u;
+{
+  if (!ring [u].on) return;
+  if (uart_running)
+    while (ring [u].tx_head != ring [u].tx_tail);
+  while (!(RD_ADR (UART_REG (u, U_SR)) & SR_TXEMT));
+}
+
+/* The baud rate set which has rate: 1 or 2 if only one of them has it,
+ * else 0.
+ */
+static int
+rate_set (rate)
+int rate;
+{
+  switch (rate) {
+    case 38400:
+      return 1;
+    case 75: case 150: case 1800: case 2000: case 19200:
+      return 2;
+  }
+  return 0;
+}
+
+/* Set the baud rate of uart u and start using its rings, if it has or
+ * can get them.  Return 0 if
+ * the rate is not supported, -1 if it would change the rate of the other
+ * UART on the DUART, which is open.
+ */
+int
+setbaud (rate, u, flow)
+int rate, u, flow;
+{
+  register struct ring *r = &ring [u];
+  int old = imr [u / 2], set = rate_set (rate), sib;
+
+  sib = rate_set (ring [u ^ 1].rate);
+  if (set != 0 && sib != 0 && set != sib) return -1;
+  if (set == 0) set = set1 [u / 2]? 1: 2;
+  uart_drain (u);
+  db_intr_off ();
+  imr [u / 2] &= ~(ISR_TXRDY (u) | ISR_RXRDY (u));
+  WR_ADR (DUART_REG (u / 2, D_IMR), imr [u / 2]);
+  if (!db_setbaud (rate, u, set == 1? ACR_SET1: ACR_SET2)) { /* RTS on */
+    imr [u / 2] = old;
+    WR_ADR (DUART_REG (u / 2, D_IMR), imr [u / 2]);
+    if (uart_running) db_intr_on ();
+    return 0;
+  }
+  WR_ADR (UART_REG (u, U_CR), CR_MRRESET);
+  WR_ADR (UART_REG (u, U_MR), MR1_8N);
+  WR_ADR (UART_REG (u, U_MR), flow? MR2_1STOP | MR2_CTS: MR2_1STOP);
+  set1 [u / 2] = (set == 1);
+  r->rx_head = r->rx_tail = r->tx_head = r->tx_tail = 0;
+  r->rate = rate;
+  r->flow = flow;
+  r->stopped = 0;
+  if (r->rx == NULL && nring < NRING) {
+    r->rx = rxbuf [nring];
+    r->tx = txbuf [nring++];
+  }
+  r->on = (r->rx != NULL);
+  if (r->on) imr [u / 2] |= ISR_RXRDY (u);
+  if (uart_running) {
+    icu_arm (u / 2);
+    WR_ADR (DUART_REG (u / 2, D_IMR), imr [u / 2]);
+    db_intr_on ();
+  }
+  return 1;
+}
+
+/* Unmask the ICU line of duart d, level triggered, active low.
+ */
+icu_arm (d)
+int d;
+{
+  int bit = 1 << (IR_DUART (d) & 7), hi = IR_DUART (d) >> 3;
+
+  RD_ADR (ICU_REG (ICU_ELTG + hi)) |= bit;
+  RD_ADR (ICU_REG (ICU_TPL + hi)) &= ~bit;
+  RD_ADR (ICU_REG (ICU_IMSK + hi)) &= ~bit;
+}
+
+/* Monitor is getting control.  Save the user's ICU registers, mask
+ * every line the user program left unmasked, since the monitor has no
+ * vector for them, and turn on the interrupts of the open UARTs.
+ */
+uart_resume ()
+{
+  int d, i;
+
+  user_svct = RD_ADR (ICU_REG (ICU_SVCT));
+  for (i = 0; i < 2; ++i) {
+    user_eltg [i] = RD_ADR (ICU_REG (ICU_ELTG + i));
+    user_tpl [i] = RD_ADR (ICU_REG (ICU_TPL + i));
+    user_imsk [i] = RD_ADR (ICU_REG (ICU_IMSK + i));
+    WR_ADR (ICU_REG (ICU_IMSK + i), 0xff);
+  }
+  WR_ADR (ICU_REG (ICU_SVCT), VEC_BIAS);
+  for (d = 0; d < NDUART; ++d) {
+    if (!ring [2 * d].on && !ring [2 * d + 1].on) continue;
+    icu_arm (d);
+    WR_ADR (DUART_REG (d, D_IMR), imr [d]);
+  }
+  uart_running = 1;
+  db_intr_on ();
+}
+
+/* User program is about to run.  Finish sending, then undo
+ * uart_resume().
+ */
+uart_suspend ()
+{
+  int d, i;
+
+  if (!uart_running) return;
+  for (i = 0; i < NUART; ++i) uart_drain (i);
+  db_intr_off ();
+  uart_running = 0;
+  for (d = 0; d < NDUART; ++d)
+    if (ring [2 * d].on || ring [2 * d + 1].on)
+      WR_ADR (DUART_REG (d, D_IMR), 0);
+  for (i = 0; i < 2; ++i) {
+    WR_ADR (ICU_REG (ICU_IMSK + i), user_imsk [i]);
+    WR_ADR (ICU_REG (ICU_ELTG + i), user_eltg [i]);
+    WR_ADR (ICU_REG (ICU_TPL + i), user_tpl [i]);
+  }
+  WR_ADR (ICU_REG (ICU_SVCT), user_svct);
+}